@@ -0,0 +1,139 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+
+using namespace std;
+
+namespace
+{
+    atomic<uint64_t> s_allocations{0};
+    /**
+     * @brief Every replacement form allocates here, so every delete form can release with free
+     */
+    void* countedAllocate(size_t size, size_t alignment) noexcept
+    {
+        s_allocations.fetch_add(1, memory_order_relaxed);
+        size = size == 0 ? 1 : size;
+        if (alignment <= alignof(max_align_t))
+        {
+            return malloc(size);
+        }
+        //aligned_alloc needs size to be a multiple of alignment
+        return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    }
+}
+
+uint64_t AllocationCounter::getCount()
+{
+    return s_allocations.load(memory_order_relaxed);
+}
+
+void* operator new(size_t size)
+{
+    if (void* memory = countedAllocate(size, 0))
+    {
+        return memory;
+    }
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, align_val_t alignment)
+{
+    if (void* memory = countedAllocate(size, static_cast<size_t>(alignment)))
+    {
+        return memory;
+    }
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size, align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept
+{
+    return countedAllocate(size, 0);
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept
+{
+    return countedAllocate(size, 0);
+}
+
+void* operator new(size_t size, align_val_t alignment, const nothrow_t&) noexcept
+{
+    return countedAllocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, align_val_t alignment, const nothrow_t&) noexcept
+{
+    return countedAllocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, align_val_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, align_val_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t, align_val_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t, align_val_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, const nothrow_t&) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, const nothrow_t&) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, align_val_t, const nothrow_t&) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, align_val_t, const nothrow_t&) noexcept
+{
+    free(memory);
+}
\ No newline at end of file
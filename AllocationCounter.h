@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+/**
+ * @brief Counts heap allocations of the whole process, benchmarks report allocations per item
+ * Global operator new and delete are replaced in its translation unit, kept apart from callers
+ * so the compiler never pairs an inlined free with a new expression.
+ */
+class AllocationCounter
+{
+public:
+    AllocationCounter() = delete;
+    /**
+     * @brief Allocations made so far by any thread
+     */
+    static std::uint64_t getCount();
+};
\ No newline at end of file
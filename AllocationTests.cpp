@@ -0,0 +1,95 @@
+#include "Tests.h"
+#include "BackupFixture.h"
+#include "AllocationCounter.h"
+#include "DirectoryWalker.h"
+#include <fstream>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+    /**
+     * @brief Memory resource which counts allocations it passes on to upstream
+     */
+    class CountingResource : public pmr::memory_resource
+    {
+    public:
+        size_t getCount() const
+        {
+            return m_count;
+        }
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            m_count++;
+            return pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* memory, size_t bytes, size_t alignment) override
+        {
+            pmr::new_delete_resource()->deallocate(memory, bytes, alignment);
+        }
+
+        bool do_is_equal(const pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+
+        size_t m_count = 0;
+    };
+    /**
+     * @brief 500 files in 10 folders, 3 levels deep
+     */
+    void createTree(const fs::path& hot)
+    {
+        for (int i = 0; i < 500; i++)
+        {
+            const auto folder = hot / ("folder" + to_string(i % 10)) / ("sub" + to_string(i % 3));
+            fs::create_directories(folder);
+            ofstream(folder / ("file" + to_string(i) + ".txt")) << i;
+        }
+    }
+}
+
+#ifdef __linux__
+TEST(DirectoryWalkerAllocatesOnlyFromArena)
+{
+    const auto hot = TestRegistry::makeTempFolder("alloc_walker");
+    createTree(hot);
+
+    CountingResource arena;
+    size_t globalAllocations = 0;
+    size_t entries = 0;
+    {
+        DirectoryWalker walker(hot, &arena);
+        const auto before = AllocationCounter::getCount();
+        FileSystem::Status status;
+        while (walker.next())
+        {
+            entries++;
+            CHECK(walker.getStatus(status));
+            CHECK(!walker.getRelativePath().empty() && !walker.getName().empty());
+        }
+        globalAllocations = AllocationCounter::getCount() - before;
+    }
+    CHECK(entries == 540);
+    CHECK(globalAllocations == 0);
+    //buffers grow with depth and name length, not with amount of entries
+    CHECK(arena.getCount() < 20);
+}
+
+TEST(WarmPassHardlyAllocates)
+{
+    BackupFixture fixture("alloc_pass", false);
+    createTree(fixture.getHot());
+    //first passes back up everything and grow buffers kept between passes
+    fixture.runPasses(2);
+
+    const auto before = AllocationCounter::getCount();
+    fixture.runPasses(1);
+    const auto allocations = AllocationCounter::getCount() - before;
+    //per pass setup allocates a few times, entries that are up to date do not
+    CHECK(allocations < 50);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "BackupFixture.h"
+#include "GlobalData.h"
+#include "NativeFileSystem.h"
+#include "Tests.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+BackupFixture::BackupFixture(const string& name, bool inMemory):
+    m_hot(TestRegistry::makeTempFolder(name) / "hot"),
+    m_backup(m_hot.parent_path() / "backup"),
+    m_memoryFileSystem{},
+    m_fileSystem(inMemory ? static_cast<const FileSystem&>(m_memoryFileSystem) : NativeFileSystem::getInstance()),
+    m_log{},
+    m_fsHelper{},
+    m_stopRequested{false},
+    m_runner{}
+{
+    //checksum manifest, pack index and log stay on disk also for a fixture in memory
+    fs::create_directories(m_hot);
+    fs::create_directories(m_backup);
+    error_code ec;
+    m_memoryFileSystem.createDirectories(m_hot, ec);
+    GlobalData::removeInstance();
+    GlobalData::getInstance(m_hot.string(), m_backup.string());
+
+    m_log = make_unique<LogUtility>();
+    m_fsHelper = make_unique<FSHelper>(m_log->getLogWriter(), m_fileSystem);
+    m_fsHelper->initEnvironment();
+    m_runner = make_unique<BackupRunner>(*m_fsHelper, m_stopRequested);
+}
+
+BackupFixture::~BackupFixture()
+{
+    m_runner.reset();
+    m_fsHelper.reset();
+    m_log.reset();
+    GlobalData::removeInstance();
+}
+
+void BackupFixture::restartRunner()
+{
+    m_runner.reset();
+    m_runner = make_unique<BackupRunner>(*m_fsHelper, m_stopRequested);
+}
+
+void BackupFixture::runPasses(int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        m_runner->runPass();
+    }
+    m_runner->waitUntilIdle();
+}
+
+bool BackupFixture::getBackupStatus(const string& name, FileSystem::Status& status) const
+{
+    error_code ec;
+    return m_fileSystem.getStatus(getBackupPath(name), status, ec);
+}
+
+bool BackupFixture::hasBackup(const string& name) const
+{
+    FileSystem::Status status;
+    return getBackupStatus(name, status);
+}
+
+fs::path BackupFixture::getBackupPath(const string& name) const
+{
+    return m_backup / (name + GlobalData::getInstance().getBackupExtension().string());
+}
+
+const fs::path& BackupFixture::getHot() const
+{
+    return m_hot;
+}
+
+const fs::path& BackupFixture::getBackup() const
+{
+    return m_backup;
+}
+
+MemoryFileSystem& BackupFixture::getMemoryFileSystem()
+{
+    return m_memoryFileSystem;
+}
+
+const FileSystem& BackupFixture::getFileSystem() const
+{
+    return m_fileSystem;
+}
+
+FSHelper& BackupFixture::getFsHelper()
+{
+    return *m_fsHelper;
+}
+
+BackupRunner& BackupFixture::getRunner()
+{
+    return *m_runner;
+}
\ No newline at end of file
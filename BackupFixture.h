@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include "BackupRunner.h"
+#include "FSHelper.h"
+#include "FileSystem.h"
+#include "LogUtility.h"
+#include "MemoryFileSystem.h"
+/**
+ * @brief Hot and backup folder with a backup runner on top, for tests of whole passes
+ * Folders are below a fresh temp folder, passes go through the real file system or a MemoryFileSystem of the fixture.
+ * GlobalData is created for the fixture and removed with it.
+ */
+class BackupFixture
+{
+public:
+    BackupFixture(const BackupFixture&) = delete;
+    BackupFixture& operator=(const BackupFixture&) = delete;
+    BackupFixture& operator==(const BackupFixture&) = delete;
+    /**
+     * @param name: name of temp folder, unique per test
+     * @param inMemory: passes go through MemoryFileSystem, otherwise through NativeFileSystem
+     */
+    BackupFixture(const std::string& name, bool inMemory);
+    ~BackupFixture();
+    /**
+     * @brief New runner, it reads filter rules and options again and has not seen any folder yet
+     */
+    void restartRunner();
+    /**
+     * @brief Run passes one after another, then wait till every scheduled backup is done
+     */
+    void runPasses(int count);
+    /**
+     * @param name: file name in hot folder, backup extension is added
+     * @return false: there is no backup file of that name
+     */
+    bool getBackupStatus(const std::string& name, FileSystem::Status& status) const;
+
+    bool hasBackup(const std::string& name) const;
+
+    std::filesystem::path getBackupPath(const std::string& name) const;
+
+    const std::filesystem::path& getHot() const;
+
+    const std::filesystem::path& getBackup() const;
+
+    /**
+     * @brief In memory file system, valid when fixture is in memory
+     */
+    MemoryFileSystem& getMemoryFileSystem();
+
+    const FileSystem& getFileSystem() const;
+
+    FSHelper& getFsHelper();
+
+    BackupRunner& getRunner();
+private:
+    const std::filesystem::path m_hot;
+    const std::filesystem::path m_backup;
+    MemoryFileSystem m_memoryFileSystem;
+    const FileSystem& m_fileSystem;
+    std::unique_ptr<LogUtility> m_log;
+    std::unique_ptr<FSHelper> m_fsHelper;
+    std::atomic<bool> m_stopRequested;
+    std::unique_ptr<BackupRunner> m_runner;
+};
\ No newline at end of file
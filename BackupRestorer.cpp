@@ -0,0 +1,293 @@
+#include "BackupRestorer.h"
+#include "GlobalData.h"
+#include "Crc32c.h"
+#include "Tracer.h"
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+BackupRestorer::BackupRestorer(const ChecksumStore& checksumStore, const PackStore& packStore):
+    m_checksumStore(checksumStore),
+    m_packStore(packStore),
+    m_fileCopier()
+{
+
+}
+
+BackupRestorer::~BackupRestorer()
+{
+
+}
+
+fs::path BackupRestorer::getOriginalPath(const string& sourcePath, const fs::path& backupName) const
+{
+    //name.txt.bak goes back to name.txt, manifest knows the folder it came from
+    fs::path originalPath = !sourcePath.empty() ? fs::u8path(sourcePath) : backupName.stem();
+    if (find(originalPath.begin(), originalPath.end(), fs::path("..")) != originalPath.end())
+    {
+        //never write outside of target folder
+        originalPath = backupName.stem();
+    }
+
+    return originalPath;
+}
+
+vector<BackupRestorer::RestoreItem> BackupRestorer::collectItems(const fs::path& backupFolder, const Options& options,
+    Result& result) const
+{
+    auto& gd = GlobalData::getInstance();
+    vector<RestoreItem> items;
+
+    error_code ec;
+    fs::directory_iterator backupIterator(backupFolder, ec);
+    if (ec)
+    {
+        cerr << "Unable to list backup folder " << backupFolder.string() << " - Due to Error: " << ec.message() << "\n";
+        return items;
+    }
+
+    for (; backupIterator != fs::directory_iterator(); backupIterator.increment(ec))
+    {
+        if (ec)
+        {
+            cerr << "Unable to list backup folder " << backupFolder.string() << " - Due to Error: " << ec.message() << "\n";
+            break;
+        }
+
+        const auto& backup = *backupIterator;
+        if (!backup.is_regular_file(ec) || backup.path().extension() != gd.getBackupExtension())
+        {
+            continue;
+        }
+
+        const auto backupName = backup.path().filename().string();
+        auto expected = m_checksumStore.get(backupName);
+        const auto originalPath = getOriginalPath(expected ? expected->sourcePath : string{}, backup.path().filename());
+
+        if (options.pathFilter && !regex_search(originalPath.generic_string(), options.pathFilter.value()))
+        {
+            result.skippedFiles++;
+            continue;
+        }
+
+        RestoreItem item;
+        item.backup = backup.path();
+        item.destination = options.targetFolder / originalPath.relative_path();
+        item.lastWriteTime = backup.last_write_time(ec);
+        if (!ec)
+        {
+            item.size = backup.file_size(ec);
+        }
+        item.expected = expected;
+
+        if (ec)
+        {
+            //backup vanished or can not be read, the rest of the folder can still be restored
+            cerr << backup.path().string() << " was not restored - Due to Error: " << ec.message() << "\n";
+            result.failedFiles++;
+            continue;
+        }
+
+        if (options.notNewerThan && item.lastWriteTime > options.notNewerThan.value())
+        {
+            result.skippedFiles++;
+            continue;
+        }
+
+        items.push_back(move(item));
+    }
+
+    for (const auto& [backupName, packed] : m_packStore.getAll())
+    {
+        //file is never packed and in own backup at once, own backup is newer if it happens anyway
+        if (fs::exists(backupFolder / backupName, ec))
+        {
+            continue;
+        }
+
+        const auto originalPath = getOriginalPath(packed.sourcePath, fs::u8path(backupName));
+        if (options.pathFilter && !regex_search(originalPath.generic_string(), options.pathFilter.value()))
+        {
+            result.skippedFiles++;
+            continue;
+        }
+
+        RestoreItem item;
+        item.backup = backupFolder / backupName;
+        item.packed = packed;
+        item.destination = options.targetFolder / originalPath.relative_path();
+        item.lastWriteTime = FileTime::toFileTime(packed.lastWriteTime);
+        item.size = packed.length;
+        item.expected = ChecksumStore::Entry{packed.checksum, packed.length, packed.sourcePath};
+
+        if (options.notNewerThan && item.lastWriteTime > options.notNewerThan.value())
+        {
+            result.skippedFiles++;
+            continue;
+        }
+
+        items.push_back(move(item));
+    }
+
+    //big files first, so a late huge file does not leave all but one worker idle
+    sort(items.begin(), items.end(), [](const RestoreItem& a, const RestoreItem& b) { return a.size > b.size; });
+
+    return items;
+}
+
+bool BackupRestorer::restoreItem(const RestoreItem& item, FileCopier::CopyStats& stats) const
+{
+    TraceSpan span("restoreItem");
+
+    error_code ec;
+    fs::create_directories(item.destination.parent_path(), ec);
+    if (ec)
+    {
+        cerr << "Unable to create folder " << item.destination.parent_path().string() << " - Due to Error: " << ec.message() << "\n";
+        return false;
+    }
+
+    //existing file is replaced by rename once the restored copy is complete
+    if (item.packed)
+    {
+        return restorePackedItem(item, stats);
+    }
+
+    if (!m_fileCopier.copy(item.backup, item.destination, stats, ec))
+    {
+        cerr << item.backup.string() << " was not restored - Due to Error: " << ec.message() << "\n";
+        return false;
+    }
+
+    fs::last_write_time(item.destination, item.lastWriteTime, ec);
+    if (ec)
+    {
+        cerr << item.destination.string() << " updating last write time failed - Due to Error: " << ec.message() << "\n";
+    }
+
+    return true;
+}
+
+bool BackupRestorer::restorePackedItem(const RestoreItem& item, FileCopier::CopyStats& stats) const
+{
+    error_code ec;
+    string content;
+    if (!m_packStore.read(item.packed.value(), content, ec))
+    {
+        cerr << item.backup.string() << " was not restored from pack - Due to Error: " << ec.message() << "\n";
+        return false;
+    }
+
+    auto partialDestination = item.destination;
+    partialDestination += GlobalData::getInstance().getPartialExtension();
+
+    ofstream destination(partialDestination, ios::binary | ios::trunc);
+    destination.write(content.data(), static_cast<streamsize>(content.size()));
+    destination.close();
+    if (!destination)
+    {
+        ec = make_error_code(errc::io_error);
+    }
+    else
+    {
+        fs::rename(partialDestination, item.destination, ec);
+    }
+    if (ec)
+    {
+        cerr << item.destination.string() << " was not restored - Due to Error: " << ec.message() << "\n";
+        error_code ignored;
+        fs::remove(partialDestination, ignored);
+        return false;
+    }
+
+    stats.logicalBytes = content.size();
+    stats.physicalBytes = content.size();
+    if (GlobalData::getInstance().isChecksumEnabled())
+    {
+        stats.checksum = Crc32c::update(0, content.data(), content.size());
+    }
+
+    if (!FileTime::setModificationTime(item.destination, item.packed->lastWriteTime))
+    {
+        cerr << item.destination.string() << " updating last write time failed\n";
+    }
+
+    return true;
+}
+
+BackupRestorer::Result BackupRestorer::restore(const fs::path& backupFolder, const Options& options) const
+{
+    const auto start = chrono::steady_clock::now();
+    Result result;
+
+    auto& gd = GlobalData::getInstance();
+    gd.setChecksumEnabled(options.verifyChecksums);
+
+    const auto items = collectItems(backupFolder, options, result);
+
+    atomic<size_t> nextItem{0};
+    atomic<size_t> restoredFiles{0};
+    atomic<size_t> failedFiles{result.failedFiles};
+    atomic<size_t> checksumMismatches{0};
+    atomic<uintmax_t> restoredBytes{0};
+    mutex outputMutex;
+
+    auto worker = [&]()
+    {
+        while (true)
+        {
+            const auto index = nextItem.fetch_add(1);
+            if (index >= items.size())
+            {
+                return;
+            }
+
+            const auto& item = items[index];
+            FileCopier::CopyStats stats;
+            if (!restoreItem(item, stats))
+            {
+                failedFiles.fetch_add(1);
+                continue;
+            }
+
+            restoredFiles.fetch_add(1);
+            restoredBytes.fetch_add(stats.logicalBytes);
+
+            if (options.verifyChecksums && item.expected && stats.checksum &&
+                (stats.checksum.value() != item.expected->checksum || stats.logicalBytes != item.expected->size))
+            {
+                checksumMismatches.fetch_add(1);
+                lock_guard<mutex> lock(outputMutex);
+                cout << "CHECKSUM MISMATCH " << item.destination.string() << " expected " << Crc32c::toString(item.expected->checksum)
+                    << " restored " << Crc32c::toString(stats.checksum.value()) << "\n";
+            }
+        }
+    };
+
+    const auto threadCount = max(1u, options.threadCount);
+    vector<thread> workers;
+    for (unsigned int i = 1; i < threadCount; i++)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& workerThread : workers)
+    {
+        workerThread.join();
+    }
+
+    result.restoredFiles = restoredFiles.load();
+    result.failedFiles = failedFiles.load();
+    result.checksumMismatches = checksumMismatches.load();
+    result.restoredBytes = restoredBytes.load();
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <regex>
+#include <cstdint>
+#include "ChecksumStore.h"
+#include "PackStore.h"
+#include "FileCopier.h"
+/**
+ * @brief Copies backup files back to their original names and locations
+ * Original location comes from checksum manifest or pack index, backups without a record
+ * are restored to the root of target folder.
+ */
+class BackupRestorer
+{
+public:
+    /**
+     * @brief What and where to restore
+     * targetFolder: folder which takes place of hot folder
+     * pathFilter: only original paths (relative to hot folder) matching it are restored
+     * notNewerThan: only backups of files modified at or before this time are restored
+     * threadCount: amount of files restored at once
+     * verifyChecksums: compare checksum computed while copying with manifest
+     */
+    struct Options
+    {
+        std::filesystem::path targetFolder;
+        std::optional<std::regex> pathFilter;
+        std::optional<std::filesystem::file_time_type> notNewerThan;
+        unsigned int threadCount = 1;
+        bool verifyChecksums = true;
+    };
+    /**
+     * @brief Outcome of a restore run
+     */
+    struct Result
+    {
+        std::size_t restoredFiles = 0;
+        std::size_t skippedFiles = 0;
+        std::size_t failedFiles = 0;
+        std::size_t checksumMismatches = 0;
+        std::uintmax_t restoredBytes = 0;
+        double seconds = 0;
+    };
+
+    BackupRestorer(const ChecksumStore& checksumStore, const PackStore& packStore);
+    ~BackupRestorer();
+    /**
+     * @brief Restore backups, problems are printed as they are found
+     * @param backupFolder: folder with backup files
+     */
+    Result restore(const std::filesystem::path& backupFolder, const Options& options) const;
+private:
+    /**
+     * @brief Single backup file and the place it goes to
+     * packed: set when backup is kept in a pack instead of own file
+     */
+    struct RestoreItem
+    {
+        std::filesystem::path backup;
+        std::optional<PackStore::Entry> packed;
+        std::filesystem::path destination;
+        std::filesystem::file_time_type lastWriteTime;
+        std::uintmax_t size;
+        std::optional<ChecksumStore::Entry> expected;
+    };
+
+    std::vector<RestoreItem> collectItems(const std::filesystem::path& backupFolder, const Options& options,
+        Result& result) const;
+    bool restoreItem(const RestoreItem& item, FileCopier::CopyStats& stats) const;
+    bool restorePackedItem(const RestoreItem& item, FileCopier::CopyStats& stats) const;
+    /**
+     * @brief Path relative to hot folder a backup goes back to, never leads outside of target folder
+     * @param sourcePath: original path from manifest or pack index, empty when unknown
+     */
+    std::filesystem::path getOriginalPath(const std::string& sourcePath, const std::filesystem::path& backupName) const;
+
+    const ChecksumStore& m_checksumStore;
+    const PackStore& m_packStore;
+    FileCopier m_fileCopier;
+};
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "Tests.h"
+#include "BackupFixture.h"
+#include "BackupRestorer.h"
+#include "GlobalData.h"
+#include <fstream>
+#include <map>
+#include <sstream>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+    void writeText(const fs::path& path, const string& text)
+    {
+        fs::create_directories(path.parent_path());
+        ofstream output(path, ios::binary | ios::trunc);
+        output << text;
+    }
+
+    string readText(const fs::path& path)
+    {
+        ifstream input(path, ios::binary);
+        stringstream text;
+        text << input.rdbuf();
+        return text.str();
+    }
+    /**
+     * @brief Files below folder by path relative to it, with their contents
+     */
+    map<string, string> readTree(const fs::path& folder)
+    {
+        map<string, string> tree;
+        error_code ec;
+        for (const auto& entry : fs::recursive_directory_iterator(folder, ec))
+        {
+            if (entry.is_regular_file())
+            {
+                tree[fs::relative(entry.path(), folder).generic_string()] = readText(entry.path());
+            }
+        }
+        return tree;
+    }
+    /**
+     * @brief Hot folder with small packed and big own backup files, old ones modified two days ago
+     * Backup is made and its runner finished, restore reads what the backup wrote to disk.
+     */
+    class RestoreFixture
+    {
+    public:
+        RestoreFixture(const RestoreFixture&) = delete;
+        RestoreFixture& operator=(const RestoreFixture&) = delete;
+
+        explicit RestoreFixture(const string& name)
+        {
+            {
+                BackupFixture fixture(name, false);
+                GlobalData::getInstance().setPackThreshold(1024);
+                m_hot = fixture.getHot();
+                m_backup = fixture.getBackup();
+                m_target = m_hot.parent_path() / "restored";
+                m_corruptBackup = fixture.getBackupPath("big.bin");
+
+                const auto old = fs::file_time_type::clock::now() - chrono::hours(48);
+                for (const auto& [path, text] : map<string, string>{{"docs/small.txt", "small document"},
+                    {"docs/old.txt", "old document"}, {"big.bin", string(5000, 'b')},
+                    {"photos/2023/big_old.jpg", string(3000, 'p')}, {"notes.txt", "note"}})
+                {
+                    writeText(m_hot / path, text);
+                    if (path.find("old") != string::npos)
+                    {
+                        fs::last_write_time(m_hot / path, old);
+                    }
+                }
+                fixture.runPasses(1);
+                //small files went to packs, big ones got own backup files
+                CHECK(!fixture.hasBackup("small.txt") && fixture.hasBackup("big.bin"));
+            }
+            GlobalData::getInstance(m_hot.string(), m_backup.string());
+            m_checksumStore.loadReadOnly(m_backup / GlobalData::getInstance().getChecksumFileName());
+            m_packStore.load(m_backup);
+        }
+
+        ~RestoreFixture()
+        {
+            GlobalData::removeInstance();
+        }
+
+        BackupRestorer::Result restore(BackupRestorer::Options options)
+        {
+            fs::remove_all(m_target);
+            options.targetFolder = m_target;
+            options.threadCount = 3;
+            BackupRestorer restorer(m_checksumStore, m_packStore);
+            return restorer.restore(m_backup, options);
+        }
+
+        fs::path m_hot;
+        fs::path m_backup;
+        fs::path m_target;
+        fs::path m_corruptBackup;
+        ChecksumStore m_checksumStore;
+        PackStore m_packStore;
+    };
+}
+
+TEST(BackupRestorerRestoresWholeTree)
+{
+    RestoreFixture fixture("restore_all");
+    const auto result = fixture.restore({});
+    CHECK(result.restoredFiles == 5);
+    CHECK(result.failedFiles == 0 && result.checksumMismatches == 0 && result.skippedFiles == 0);
+    CHECK(result.restoredBytes == 5000 + 3000 + 14 + 12 + 4);
+    CHECK(readTree(fixture.m_target) == readTree(fixture.m_hot));
+    //packed and own backup files both get original modification time back
+    CHECK(fs::last_write_time(fixture.m_target / "docs/old.txt") == fs::last_write_time(fixture.m_hot / "docs/old.txt"));
+    CHECK(fs::last_write_time(fixture.m_target / "photos/2023/big_old.jpg") ==
+        fs::last_write_time(fixture.m_hot / "photos/2023/big_old.jpg"));
+}
+
+TEST(BackupRestorerFiltersByPathAndTime)
+{
+    RestoreFixture fixture("restore_filtered");
+
+    BackupRestorer::Options byPath;
+    byPath.pathFilter = regex("^docs/");
+    auto result = fixture.restore(byPath);
+    CHECK(result.restoredFiles == 2 && result.skippedFiles == 3);
+    CHECK(readTree(fixture.m_target) == (map<string, string>{{"docs/old.txt", "old document"}, {"docs/small.txt", "small document"}}));
+
+    BackupRestorer::Options byTime;
+    byTime.notNewerThan = fs::file_time_type::clock::now() - chrono::hours(24);
+    result = fixture.restore(byTime);
+    CHECK(result.restoredFiles == 2 && result.skippedFiles == 3);
+    CHECK(readTree(fixture.m_target) == (map<string, string>{{"docs/old.txt", "old document"},
+        {"photos/2023/big_old.jpg", string(3000, 'p')}}));
+}
+
+TEST(BackupRestorerReportsChecksumMismatch)
+{
+    RestoreFixture fixture("restore_corrupt");
+    {
+        fstream backup(fixture.m_corruptBackup, fstream::in | fstream::out | fstream::binary);
+        backup.seekp(100);
+        backup << 'x';
+    }
+
+    auto result = fixture.restore({});
+    CHECK(result.checksumMismatches == 1);
+    CHECK(result.restoredFiles + result.failedFiles == 5);
+
+    BackupRestorer::Options withoutVerify;
+    withoutVerify.verifyChecksums = false;
+    result = fixture.restore(withoutVerify);
+    CHECK(result.checksumMismatches == 0 && result.restoredFiles == 5);
+}
\ No newline at end of file
@@ -0,0 +1,386 @@
+#include "BackupRunner.h"
+#include "GlobalData.h"
+#include "Metrics.h"
+#include "Tracer.h"
+#include <chrono>
+#include <algorithm>
+#include <string>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+const size_t BackupRunner::PassArenaSize{64 * 1024};
+const chrono::seconds BackupRunner::PassInterval{1};
+
+BackupRunner::BackupRunner(const FSHelper& fsHelper, const atomic<bool>& stopRequested):
+    m_fsHelper(fsHelper),
+    m_stopRequested(stopRequested),
+    m_pathFilter(GlobalData::getInstance().getFilterRules()),
+    m_scheduler(fsHelper, GlobalData::getInstance().getBackupThreads()),
+    m_poller(PassInterval, GlobalData::getInstance().getPollMaxInterval(), GlobalData::getInstance().getPollBudget()),
+    m_scanAllRequested(false),
+    m_orphans{},
+    m_orphanBaselineDone(false),
+    m_wakeMutex{},
+    m_wakeCondition{},
+    m_rescanRequested(false),
+    m_passArenaBuffer(PassArenaSize)
+{
+
+}
+
+BackupRunner::~BackupRunner()
+{
+
+}
+
+bool BackupRunner::isExcluded(FileSystem::Walker& entry, pmr::vector<PathFilter::State>& folderStates,
+    PathFilter::State& nameState) const
+{
+    if (m_pathFilter.isEmpty())
+    {
+        return false;
+    }
+
+    TraceSpan span("filterEntry");
+
+    const auto depth = entry.getDepth();
+    if (folderStates.size() < depth + 2)
+    {
+        folderStates.resize(depth + 2);
+    }
+
+    const auto decision = m_pathFilter.evaluate(folderStates[depth], entry.getRelativePath(), entry.getName(),
+        entry.isDirectory(), folderStates[depth + 1], nameState);
+
+    if (decision == PathFilter::Decision::Prune)
+    {
+        entry.disableRecursionPending();
+        Metrics::getInstance().increment(Metrics::Counter::DirectoriesPruned);
+        return true;
+    }
+
+    if (decision == PathFilter::Decision::Skip)
+    {
+        Metrics::getInstance().increment(Metrics::Counter::FilesExcluded);
+        return true;
+    }
+
+    return false;
+}
+
+void BackupRunner::scheduleBackup(const FileSystem::Walker& entry) const
+{
+    auto& gd = GlobalData::getInstance();
+
+    //delete_name is keyed like name, so it never runs while name is being backed up
+    auto name = entry.getName();
+    const auto& deletePrefix = gd.getDeletePrefix();
+    if (name.size() > deletePrefix.size() && name.compare(0, deletePrefix.size(), deletePrefix) == 0)
+    {
+        name.remove_prefix(deletePrefix.size());
+    }
+
+    FileSystem::Status status;
+    if (!entry.getStatus(status))
+    {
+        return;
+    }
+
+    m_scheduler.submit(entry.getPath(), string(name) + gd.getBackupExtension().string(), status.size, status.modificationTime);
+}
+
+bool BackupRunner::pollEntry(FileSystem::Walker& entry, pmr::vector<DirectoryPoller::Folder*>& folders,
+    DirectoryPoller::Decision& decision) const
+{
+    const auto depth = entry.getDepth();
+    auto& folder = *folders[depth];
+
+    if (!entry.isDirectory())
+    {
+        m_poller.countEntry(folder, false);
+        return folder.scanned;
+    }
+
+    m_poller.countEntry(folder, true);
+
+    FileSystem::Status status;
+    entry.getStatus(status);
+
+    auto& subfolder = m_poller.visitFolder(entry.getRelativePath(), status.modificationTime, decision);
+    if (decision == DirectoryPoller::Decision::Skip)
+    {
+        entry.disableRecursionPending();
+    }
+
+    if (folders.size() < depth + 2)
+    {
+        folders.resize(depth + 2);
+    }
+    folders[depth + 1] = &subfolder;
+
+    return false;
+}
+
+void BackupRunner::trackEntry(const FileSystem::Walker& entry, DirectoryPoller::Decision decision,
+    pmr::vector<OrphanReconciler::Folder*>& listings) const
+{
+    const auto depth = entry.getDepth();
+    if (entry.isDirectory())
+    {
+        if (listings.size() < depth + 2)
+        {
+            listings.resize(depth + 2);
+        }
+        listings[depth + 1] = &m_orphans.visitFolder(entry.getRelativePath(), decision != DirectoryPoller::Decision::Skip);
+        return;
+    }
+
+    //delete_name is removed together with backup of name right away, it never has a backup of its own
+    const auto name = entry.getName();
+    const auto& deletePrefix = GlobalData::getInstance().getDeletePrefix();
+    if (!entry.isRegularFile() || name.compare(0, deletePrefix.size(), deletePrefix) == 0)
+    {
+        return;
+    }
+
+    m_orphans.countFile(*listings[depth], name);
+}
+
+void BackupRunner::trackExcluded(const FileSystem::Walker& entry, pmr::vector<OrphanReconciler::Folder*>& listings,
+    pmr::memory_resource* memory) const
+{
+    if (!entry.isDirectory())
+    {
+        trackEntry(entry, DirectoryPoller::Decision::Scan, listings);
+        return;
+    }
+
+    auto* folder = &m_orphans.visitFolder(entry.getRelativePath(), false);
+    if (folder->everListed)
+    {
+        return;
+    }
+
+    //names of the whole subtree are kept with pruned folder, its subfolders are never reached by passes
+    TraceSpan span("listExcludedFolder");
+    folder = &m_orphans.visitFolder(entry.getRelativePath(), true);
+    const auto walker = m_fsHelper.getFileSystem().walk(entry.getPath(), memory);
+    const auto& deletePrefix = GlobalData::getInstance().getDeletePrefix();
+    bool listed = !walker->isIncomplete();
+    while (listed && walker->next())
+    {
+        const auto name = walker->getName();
+        if (walker->isRegularFile() && name.compare(0, deletePrefix.size(), deletePrefix) != 0)
+        {
+            m_orphans.countFile(*folder, name);
+        }
+        listed = !walker->hasOpenFailed();
+    }
+    if (!listed || walker->hasOpenFailed() || walker->isIncomplete())
+    {
+        m_orphans.keepListing(*folder);
+    }
+}
+
+void BackupRunner::reconcileOrphans() const
+{
+    //until every folder was listed names do not cover hot folder, backups of unlisted ones would look orphaned
+    if (!m_orphans.isComplete())
+    {
+        return;
+    }
+
+    TraceSpan span("reconcileOrphans");
+
+    auto& gd = GlobalData::getInstance();
+    const auto extension = gd.getBackupExtension().string();
+
+    if (!m_orphanBaselineDone)
+    {
+        vector<string> backupNames;
+        m_fsHelper.getBackupNames(backupNames);
+        sort(backupNames.begin(), backupNames.end());
+        backupNames.erase(unique(backupNames.begin(), backupNames.end()), backupNames.end());
+
+        for (const auto& backupName : backupNames)
+        {
+            const auto name = backupName.substr(0, backupName.size() - extension.size());
+            if (!m_orphans.isLive(name))
+            {
+                m_orphans.addCandidate(name);
+            }
+        }
+        m_orphanBaselineDone = true;
+    }
+
+    vector<string> batch;
+    m_orphans.takeCandidates(gd.getOrphanBatch(), batch);
+    const bool quarantine = gd.getOrphanMode() == GlobalData::OrphanMode::Quarantine;
+    for (const auto& name : batch)
+    {
+        //file may have come back since its name became a candidate
+        if (!m_orphans.isLive(name))
+        {
+            m_fsHelper.removeOrphan(name + extension, quarantine);
+        }
+    }
+
+    Metrics::getInstance().setGauge(Metrics::Gauge::OrphansPending, static_cast<int64_t>(m_orphans.getCandidateCount()));
+}
+
+bool BackupRunner::runPass() const
+{
+    auto& metrics = Metrics::getInstance();
+    const auto passStart = chrono::steady_clock::now();
+    const auto skippedBefore = metrics.getCounter(Metrics::Counter::FilesSkipped);
+    int64_t scanned = 0;
+    TraceSpan passSpan("pass");
+
+    GlobalData::getInstance().updatePaths();
+
+    //walker buffers and filter states live in the arena, nothing is allocated per file once it is warm
+    pmr::monotonic_buffer_resource passArena(m_passArenaBuffer.data(), m_passArenaBuffer.size());
+    pmr::vector<PathFilter::State> folderStates(&passArena);
+    folderStates.push_back(m_pathFilter.getRootState());
+    PathFilter::State nameState(&passArena);
+
+    const auto& fileSystem = m_fsHelper.getFileSystem();
+    const auto walker = fileSystem.walk(GlobalData::getInstance().getHotFolderPath(), &passArena);
+
+    const bool polling = m_poller.isEnabled();
+    pmr::vector<DirectoryPoller::Folder*> folders(&passArena);
+    if (polling)
+    {
+        m_poller.beginPass(m_scanAllRequested.exchange(false));
+
+        FileSystem::Status root;
+        error_code ec;
+        fileSystem.getStatus(GlobalData::getInstance().getHotFolderPath(), root, ec);
+        auto decision = DirectoryPoller::Decision::Scan;
+        folders.push_back(&m_poller.visitFolder({}, root.modificationTime, decision));
+    }
+
+    const bool reconciling = GlobalData::getInstance().getOrphanMode() != GlobalData::OrphanMode::Off;
+    pmr::vector<OrphanReconciler::Folder*> listings(&passArena);
+    if (reconciling)
+    {
+        m_orphans.beginPass();
+        listings.push_back(&m_orphans.visitFolder({}, true));
+    }
+
+    //folder the walk descends into next, it keeps its previous listing when it can not be opened
+    OrphanReconciler::Folder* descending = nullptr;
+    while (true)
+    {
+        {
+            //time spent reading directories shows up in trace
+            TraceSpan span("iterateDirectory");
+            const bool found = walker->next();
+            if (descending && walker->hasOpenFailed())
+            {
+                m_orphans.keepListing(*descending);
+            }
+            descending = nullptr;
+            if (!found)
+            {
+                break;
+            }
+        }
+
+        if (m_stopRequested.load())
+        {
+            return false;
+        }
+
+        scanned++;
+        if (isExcluded(*walker, folderStates, nameState))
+        {
+            if (reconciling)
+            {
+                trackExcluded(*walker, listings, &passArena);
+            }
+            continue;
+        }
+
+        auto decision = DirectoryPoller::Decision::Scan;
+        const bool due = !polling || pollEntry(*walker, folders, decision);
+        if (reconciling)
+        {
+            trackEntry(*walker, decision, listings);
+            descending = walker->isDirectory() ? listings[walker->getDepth() + 1] : nullptr;
+        }
+
+        if (due && m_fsHelper.needsBackup(*walker))
+        {
+            scheduleBackup(*walker);
+            if (polling)
+            {
+                m_poller.countChange(*folders[walker->getDepth()]);
+            }
+        }
+    }
+
+    m_scheduler.waitForLatencyLane(m_stopRequested);
+    m_fsHelper.flushPacks();
+
+    if (polling)
+    {
+        m_poller.endPass();
+        metrics.increment(Metrics::Counter::DirectoriesDeferred, m_poller.getDeferredFolders());
+        metrics.setGauge(Metrics::Gauge::LastPassDirectoriesScanned, static_cast<int64_t>(m_poller.getScannedFolders()));
+        metrics.setGauge(Metrics::Gauge::LastPassDirectoriesIdle, static_cast<int64_t>(m_poller.getIdleFolders()));
+    }
+
+    //hot folder which could not be listed would make every backup look orphaned
+    if (reconciling && !walker->isIncomplete())
+    {
+        m_orphans.endPass();
+        reconcileOrphans();
+    }
+
+    const auto passDuration = chrono::steady_clock::now() - passStart;
+    metrics.increment(Metrics::Counter::Passes);
+    metrics.increment(Metrics::Counter::FilesScanned, static_cast<uint64_t>(scanned));
+    metrics.observe(Metrics::Histogram::PassDuration, passDuration);
+    metrics.setGauge(Metrics::Gauge::LastPassFilesScanned, scanned);
+    metrics.setGauge(Metrics::Gauge::LastPassFilesSkipped,
+        static_cast<int64_t>(metrics.getCounter(Metrics::Counter::FilesSkipped) - skippedBefore));
+    metrics.setGauge(Metrics::Gauge::LastPassMicroseconds, chrono::duration_cast<chrono::microseconds>(passDuration).count());
+
+    //pack compaction runs between passes without holding the pack index lock while copying,
+    //so backup workers still finishing files are not blocked by it
+    m_fsHelper.maintainPacks();
+
+    return !m_stopRequested.load();
+}
+
+void BackupRunner::run() const
+{
+    Tracer::getInstance().setThreadName("backup");
+
+    while (runPass())
+    {
+        unique_lock<mutex> lock(m_wakeMutex);
+        m_wakeCondition.wait_for(lock, PassInterval, [this]() { return m_rescanRequested; });
+        m_rescanRequested = false;
+    }
+
+    m_scheduler.stop();
+}
+
+void BackupRunner::waitUntilIdle() const
+{
+    m_scheduler.waitUntilIdle();
+    m_fsHelper.flushPacks();
+}
+
+void BackupRunner::requestRescan() const
+{
+    {
+        lock_guard<mutex> lock(m_wakeMutex);
+        m_rescanRequested = true;
+    }
+    m_scanAllRequested.store(true);
+    m_wakeCondition.notify_one();
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+#include "FSHelper.h"
+#include "FileSystem.h"
+#include "PathFilter.h"
+#include "BackupScheduler.h"
+#include "DirectoryPoller.h"
+#include "OrphanReconciler.h"
+/**
+ * @brief Drives backup passes over hot folder
+ * Passes only discover new and changed files, they are backed up by workers of the backup scheduler.
+ * When polling is adaptive, passes check only folders which are due according to the directory poller.
+ * When orphan handling is on, names listed by passes are tracked and backups whose file is gone are removed or
+ * quarantined in batches after passes.
+ */
+class BackupRunner
+{
+public:
+    /**
+     * @param fsHelper: helper doing the per file work
+     * @param stopRequested: flag checked between files, pass is abandoned when set
+     * Filter rules are taken from GlobalData and compiled once here
+     */
+    BackupRunner(const FSHelper& fsHelper, const std::atomic<bool>& stopRequested);
+    ~BackupRunner();
+    /**
+     * @brief Crawls once through hot folder and schedules backup of each new or changed file
+     * Returns once small files found by the pass are backed up, large ones may still be in progress.
+     * Temporary buffers of the pass come from an arena released as a whole when pass ends.
+     * @return false: pass was interrupted by stop request
+     */
+    bool runPass() const;
+    /**
+     * @brief Wait till every file scheduled by passes so far is backed up, large ones included
+     */
+    void waitUntilIdle() const;
+    /**
+     * @brief loop for file backup thread
+     * Runs passes with a pause in between until stop is requested, then stops scheduler workers
+     */
+    void run() const;
+    /**
+     * @brief Ends the pause between passes, next pass starts right away and checks every folder
+     */
+    void requestRescan() const;
+private:
+    /**
+     * @brief Applies filter rules to entry, excluded folders are not descended into
+     * @param folderStates: filter state of every folder above entry, indexed by depth
+     * @param nameState: scratch state of name rules
+     * @return true: entry is excluded and must not be backed up
+     */
+    bool isExcluded(FileSystem::Walker& entry, std::pmr::vector<PathFilter::State>& folderStates,
+        PathFilter::State& nameState) const;
+    /**
+     * @brief Hand current entry of the walk to scheduler, keyed by the backup it writes or deletes
+     */
+    void scheduleBackup(const FileSystem::Walker& entry) const;
+    /**
+     * @brief Lets directory poller decide about entry, folders which are not due are not descended into
+     * @param folders: poller state of every folder above entry, indexed by depth
+     * @param decision: set for folders, what the pass does with them
+     * @return true: entry is a file in a folder checked by this pass
+     */
+    bool pollEntry(FileSystem::Walker& entry, std::pmr::vector<DirectoryPoller::Folder*>& folders,
+        DirectoryPoller::Decision& decision) const;
+    /**
+     * @brief Hand current entry of the walk to orphan reconciler, files are counted in folder they are listed in
+     * @param decision: what the pass does with entry when it is a folder, skipped folders keep names listed before
+     * @param listings: reconciler state of every folder above entry, indexed by depth
+     */
+    void trackEntry(const FileSystem::Walker& entry, DirectoryPoller::Decision decision,
+        std::pmr::vector<OrphanReconciler::Folder*>& listings) const;
+    /**
+     * @brief Hand entry excluded by filter to orphan reconciler, its backup is kept rather than taken for an orphan
+     * Excluded folder keeps names listed before, one never listed is listed once without backing anything up.
+     * @param memory: resource for buffers of that listing
+     */
+    void trackExcluded(const FileSystem::Walker& entry, std::pmr::vector<OrphanReconciler::Folder*>& listings,
+        std::pmr::memory_resource* memory) const;
+    /**
+     * @brief Remove or quarantine a batch of orphaned backups, called after every complete pass
+     * Backups left by previous runs are compared with hot folder once, when every folder was listed.
+     */
+    void reconcileOrphans() const;
+
+    const FSHelper& m_fsHelper;
+    const std::atomic<bool>& m_stopRequested;
+    const PathFilter m_pathFilter;
+    mutable BackupScheduler m_scheduler;
+    mutable DirectoryPoller m_poller;
+    mutable std::atomic<bool> m_scanAllRequested;
+    mutable OrphanReconciler m_orphans;
+    mutable bool m_orphanBaselineDone;
+    mutable std::mutex m_wakeMutex;
+    mutable std::condition_variable m_wakeCondition;
+    mutable bool m_rescanRequested;
+    mutable std::vector<std::byte> m_passArenaBuffer;
+    static const std::size_t PassArenaSize;
+    static const std::chrono::seconds PassInterval;
+};
\ No newline at end of file
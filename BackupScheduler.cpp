@@ -0,0 +1,189 @@
+#include "BackupScheduler.h"
+#include "GlobalData.h"
+#include "Metrics.h"
+#include "Tracer.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+const size_t BackupScheduler::MaxLatencyStreak{64};
+const chrono::seconds BackupScheduler::MaxBulkWait{5};
+
+bool BackupScheduler::NewerFirst::operator()(const Task& a, const Task& b) const
+{
+    //priority_queue keeps the largest on top, so "less" means older, or submitted later for equal times
+    if (a.lastWriteTime != b.lastWriteTime)
+    {
+        return a.lastWriteTime < b.lastWriteTime;
+    }
+    return a.sequence > b.sequence;
+}
+
+BackupScheduler::BackupScheduler(const FSHelper& fsHelper, unsigned int workerCount):
+    m_fsHelper(fsHelper),
+    m_mutex{},
+    m_taskAvailable{},
+    m_taskFinished{},
+    m_latencyLane{},
+    m_bulkLane{},
+    m_scheduledKeys{},
+    m_activeLatency(0),
+    m_activeBulk(0),
+    m_maxActiveBulk(workerCount > 1 ? workerCount - 1 : 1),
+    m_latencyStreak(0),
+    m_nextSequence(0),
+    m_stopping(false),
+    m_workers{}
+{
+    for (unsigned int i = 0; i < max(1u, workerCount); i++)
+    {
+        m_workers.emplace_back(&BackupScheduler::workerThread, this, i);
+    }
+}
+
+BackupScheduler::~BackupScheduler()
+{
+    stop();
+}
+
+bool BackupScheduler::submit(const fs::path& path, const string& key, uintmax_t size, int64_t lastWriteTime)
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        if (m_stopping || !m_scheduledKeys.insert(key).second)
+        {
+            return false;
+        }
+
+        Task task{path, key, lastWriteTime, m_nextSequence++, chrono::steady_clock::now(),
+            size >= GlobalData::getInstance().getLatencyLaneThreshold()};
+        if (task.bulk)
+        {
+            m_bulkLane.push_back(move(task));
+        }
+        else
+        {
+            m_latencyLane.push(move(task));
+        }
+        updateQueueGauges();
+    }
+    m_taskAvailable.notify_one();
+
+    return true;
+}
+
+bool BackupScheduler::takeTask(Task& task)
+{
+    const bool bulkAllowed = !m_bulkLane.empty() && m_activeBulk < m_maxActiveBulk;
+    const bool bulkStarving = bulkAllowed && (m_latencyStreak >= MaxLatencyStreak ||
+        chrono::steady_clock::now() - m_bulkLane.front().queuedAt >= MaxBulkWait);
+
+    if (bulkAllowed && (m_latencyLane.empty() || bulkStarving))
+    {
+        task = move(m_bulkLane.front());
+        m_bulkLane.pop_front();
+        m_activeBulk++;
+        m_latencyStreak = 0;
+        return true;
+    }
+
+    if (!m_latencyLane.empty())
+    {
+        //priority_queue only hands out a const top, the task is moved out right before pop
+        task = move(const_cast<Task&>(m_latencyLane.top()));
+        m_latencyLane.pop();
+        m_activeLatency++;
+        if (!m_bulkLane.empty())
+        {
+            m_latencyStreak++;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void BackupScheduler::workerThread(unsigned int index)
+{
+    Tracer::getInstance().setThreadName("backup worker " + to_string(index));
+
+    while (true)
+    {
+        Task task;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            //bulk task which is not allowed yet becomes allowed with time, so waiting is bounded
+            while (!m_stopping && !takeTask(task))
+            {
+                m_taskAvailable.wait_for(lock, chrono::seconds(1));
+            }
+            if (m_stopping)
+            {
+                return;
+            }
+            updateQueueGauges();
+        }
+
+        {
+            TraceSpan span(task.bulk ? "bulkTask" : "latencyTask");
+            m_fsHelper.backupSingleFile(task.path);
+        }
+
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_scheduledKeys.erase(task.key);
+            (task.bulk ? m_activeBulk : m_activeLatency)--;
+        }
+        //a finished bulk task frees a bulk slot, another worker may take the next one
+        m_taskAvailable.notify_all();
+        m_taskFinished.notify_all();
+    }
+}
+
+void BackupScheduler::waitForLatencyLane(const atomic<bool>& stopRequested) const
+{
+    unique_lock<mutex> lock(m_mutex);
+    while (!stopRequested.load() && !m_stopping && (!m_latencyLane.empty() || m_activeLatency > 0))
+    {
+        m_taskFinished.wait_for(lock, chrono::milliseconds(100));
+    }
+}
+
+void BackupScheduler::waitUntilIdle() const
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_taskFinished.wait(lock, [this]()
+    {
+        return m_stopping || (m_latencyLane.empty() && m_bulkLane.empty() && m_activeLatency == 0 && m_activeBulk == 0);
+    });
+}
+
+void BackupScheduler::stop()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (m_stopping)
+        {
+            return;
+        }
+        m_stopping = true;
+        m_latencyLane = {};
+        m_bulkLane.clear();
+        updateQueueGauges();
+    }
+    m_taskAvailable.notify_all();
+    m_taskFinished.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void BackupScheduler::updateQueueGauges() const
+{
+    auto& metrics = Metrics::getInstance();
+    metrics.setGauge(Metrics::Gauge::LatencyLaneDepth, static_cast<int64_t>(m_latencyLane.size()));
+    metrics.setGauge(Metrics::Gauge::BulkLaneDepth, static_cast<int64_t>(m_bulkLane.size()));
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "FSHelper.h"
+/**
+ * @brief Backs up files found by a pass on worker threads, small files do not wait behind large ones
+ * Latency lane holds files below latency lane threshold, newest modification first. Bulk lane holds the
+ * rest in order of discovery and never occupies every worker, so one is always left for small files.
+ * A bulk file is taken ahead of small ones once it waited too long or enough small files went first.
+ * A file is queued only once, it is not queued again while waiting or being backed up.
+ */
+class BackupScheduler
+{
+public:
+    BackupScheduler(const BackupScheduler&) = delete;
+    BackupScheduler& operator=(const BackupScheduler&) = delete;
+    BackupScheduler& operator==(const BackupScheduler&) = delete;
+    /**
+     * @param fsHelper: helper doing the per file work
+     * @param workerCount: amount of worker threads, at least one
+     */
+    BackupScheduler(const FSHelper& fsHelper, unsigned int workerCount);
+    /**
+     * @brief Stops workers, files still waiting are dropped
+     */
+    ~BackupScheduler();
+    /**
+     * @brief Queue a file for backup
+     * @param key: backup name of the file, files with the same key are never backed up at once
+     * @param size: decides the lane
+     * @param lastWriteTime: newer files go first within latency lane
+     * @return false: file with the same key is already waiting or being backed up
+     */
+    bool submit(const std::filesystem::path& path, const std::string& key, std::uintmax_t size, std::int64_t lastWriteTime);
+    /**
+     * @brief Wait till latency lane is empty and its files are backed up, bulk files may still be in progress
+     * @param stopRequested: waiting ends early when set
+     */
+    void waitForLatencyLane(const std::atomic<bool>& stopRequested) const;
+    /**
+     * @brief Wait till both lanes are empty and no file is being backed up
+     */
+    void waitUntilIdle() const;
+    /**
+     * @brief Drop waiting files and wait for files being backed up, workers end
+     */
+    void stop();
+private:
+    /**
+     * @brief Queued file
+     * sequence: order of submission, keeps ordering of files with the same modification time stable
+     */
+    struct Task
+    {
+        std::filesystem::path path;
+        std::string key;
+        std::int64_t lastWriteTime = 0;
+        std::uint64_t sequence = 0;
+        std::chrono::steady_clock::time_point queuedAt;
+        bool bulk = false;
+    };
+    /**
+     * @brief Latency lane order, newest modification on top
+     */
+    struct NewerFirst
+    {
+        bool operator()(const Task& a, const Task& b) const;
+    };
+
+    void workerThread(unsigned int index);
+    /**
+     * @brief Pick next task under lock
+     * @return false: nothing can be taken right now
+     */
+    bool takeTask(Task& task);
+    void updateQueueGauges() const;
+
+    const FSHelper& m_fsHelper;
+    mutable std::mutex m_mutex;
+    mutable std::condition_variable m_taskAvailable;
+    mutable std::condition_variable m_taskFinished;
+    std::priority_queue<Task, std::vector<Task>, NewerFirst> m_latencyLane;
+    std::deque<Task> m_bulkLane;
+    std::unordered_set<std::string> m_scheduledKeys;
+    std::size_t m_activeLatency;
+    std::size_t m_activeBulk;
+    std::size_t m_maxActiveBulk;
+    std::size_t m_latencyStreak;
+    std::uint64_t m_nextSequence;
+    bool m_stopping;
+    std::vector<std::thread> m_workers;
+    static const std::size_t MaxLatencyStreak;
+    static const std::chrono::seconds MaxBulkWait;
+};
\ No newline at end of file
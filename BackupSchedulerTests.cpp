@@ -0,0 +1,99 @@
+#include "Tests.h"
+#include "BackupFixture.h"
+#include "BackupScheduler.h"
+#include "GlobalData.h"
+#include <algorithm>
+#include <thread>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+    const uintmax_t MegaByte{1024 * 1024};
+    /**
+     * @brief Names in the order their backups appear, polled while scheduler works
+     */
+    vector<string> waitForBackups(const BackupFixture& fixture, const vector<string>& names)
+    {
+        vector<string> order;
+        const auto deadline = chrono::steady_clock::now() + chrono::seconds(10);
+        while (order.size() < names.size() && chrono::steady_clock::now() < deadline)
+        {
+            for (const auto& name : names)
+            {
+                if (find(order.begin(), order.end(), name) == order.end() && fixture.hasBackup(name))
+                {
+                    order.push_back(name);
+                }
+            }
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        return order;
+    }
+}
+
+TEST(BackupSchedulerTakesNewestSmallFilesFirst)
+{
+    BackupFixture fixture("scheduler_newest", true);
+    auto& fileSystem = fixture.getMemoryFileSystem();
+    fileSystem.setLatency(MemoryFileSystem::Operation::Copy, chrono::milliseconds(30));
+    for (const auto* name : {"first.txt", "old.txt", "newest.txt", "newer.txt"})
+    {
+        fileSystem.writeFile(fixture.getHot() / name, 100);
+    }
+
+    BackupScheduler scheduler(fixture.getFsHelper(), 1);
+    //first file is the newest of all, so it goes first whether or not the worker took it before the rest came
+    CHECK(scheduler.submit(fixture.getHot() / "first.txt", "first.txt", 100, 100));
+    CHECK(scheduler.submit(fixture.getHot() / "old.txt", "old.txt", 100, 1));
+    CHECK(scheduler.submit(fixture.getHot() / "newest.txt", "newest.txt", 100, 3));
+    CHECK(scheduler.submit(fixture.getHot() / "newer.txt", "newer.txt", 100, 2));
+    //already waiting
+    CHECK(!scheduler.submit(fixture.getHot() / "old.txt", "old.txt", 100, 1));
+
+    const auto order = waitForBackups(fixture, {"first.txt", "old.txt", "newest.txt", "newer.txt"});
+    CHECK(order == (vector<string>{"first.txt", "newest.txt", "newer.txt", "old.txt"}));
+    scheduler.waitUntilIdle();
+
+    //backed up file can be queued again
+    CHECK(scheduler.submit(fixture.getHot() / "old.txt", "old.txt", 100, 1));
+    scheduler.waitUntilIdle();
+}
+
+TEST(BackupSchedulerKeepsWorkerForSmallFiles)
+{
+    BackupFixture fixture("scheduler_lanes", true);
+    GlobalData::getInstance().setLatencyLaneThreshold(MegaByte);
+    auto& fileSystem = fixture.getMemoryFileSystem();
+    fileSystem.setLatency(MemoryFileSystem::Operation::Copy, {}, chrono::milliseconds(200));
+
+    vector<string> small;
+    fileSystem.writeFile(fixture.getHot() / "big1.img", 2 * MegaByte);
+    fileSystem.writeFile(fixture.getHot() / "big2.img", 2 * MegaByte);
+    for (int i = 0; i < 5; i++)
+    {
+        small.push_back("small" + to_string(i) + ".txt");
+        fileSystem.writeFile(fixture.getHot() / small.back(), 1000);
+    }
+
+    BackupScheduler scheduler(fixture.getFsHelper(), 2);
+    CHECK(scheduler.submit(fixture.getHot() / "big1.img", "big1.img", 2 * MegaByte, 1));
+    CHECK(scheduler.submit(fixture.getHot() / "big2.img", "big2.img", 2 * MegaByte, 2));
+    for (const auto& name : small)
+    {
+        CHECK(scheduler.submit(fixture.getHot() / name, name, 1000, 1));
+    }
+
+    //one worker is busy with a big file for 400 ms, the other one never takes the second big file
+    const atomic<bool> stopRequested{false};
+    scheduler.waitForLatencyLane(stopRequested);
+    for (const auto& name : small)
+    {
+        CHECK(fixture.hasBackup(name));
+    }
+    CHECK(!fixture.hasBackup("big2.img"));
+
+    scheduler.waitUntilIdle();
+    CHECK(fixture.hasBackup("big1.img") && fixture.hasBackup("big2.img"));
+}
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include "BackupVerifier.h"
+#include "GlobalData.h"
+#include "Crc32c.h"
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <chrono>
+#include <unordered_set>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+const uintmax_t BackupVerifier::RangeSize{64 * 1024 * 1024};
+const size_t BackupVerifier::ReadBufferSize{4 * 1024 * 1024};
+
+BackupVerifier::BackupVerifier(const ChecksumStore& checksumStore, const PackStore& packStore):
+    m_checksumStore(checksumStore),
+    m_packStore(packStore)
+{
+
+}
+
+BackupVerifier::~BackupVerifier()
+{
+
+}
+
+BackupVerifier::Result BackupVerifier::verify(const fs::path& backupFolder, unsigned int threadCount) const
+{
+    struct FileToCheck
+    {
+        string backupName;
+        ChecksumStore::Entry expected;
+        optional<PackStore::Entry> packed;
+        vector<uint32_t> rangeChecksums;
+        atomic<bool> failed{false};
+    };
+    struct RangeToCheck
+    {
+        size_t fileIndex;
+        size_t rangeIndex;
+        uintmax_t offset;
+        uintmax_t length;
+    };
+
+    const auto start = chrono::steady_clock::now();
+    Result result;
+
+    const auto entries = m_checksumStore.getAll();
+    const auto packedEntries = m_packStore.getAll();
+
+    vector<FileToCheck> files(entries.size() + packedEntries.size());
+    vector<RangeToCheck> ranges;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        if (i < entries.size())
+        {
+            files[i].backupName = entries[i].first;
+            files[i].expected = entries[i].second;
+        }
+        else
+        {
+            const auto& [backupName, packed] = packedEntries[i - entries.size()];
+            files[i].backupName = backupName;
+            files[i].expected = ChecksumStore::Entry{packed.checksum, packed.length, packed.sourcePath};
+            files[i].packed = packed;
+        }
+
+        const auto size = files[i].expected.size;
+        const auto rangeCount = max<uintmax_t>(1, (size + RangeSize - 1) / RangeSize);
+        files[i].rangeChecksums.resize(static_cast<size_t>(rangeCount));
+        for (uintmax_t range = 0; range < rangeCount; range++)
+        {
+            const auto offset = range * RangeSize;
+            ranges.push_back(RangeToCheck{i, static_cast<size_t>(range), offset, min(RangeSize, size - offset)});
+        }
+    }
+
+    atomic<size_t> nextRange{0};
+    atomic<uintmax_t> checkedBytes{0};
+
+    auto worker = [&]()
+    {
+        vector<char> buffer(ReadBufferSize);
+        while (true)
+        {
+            const auto index = nextRange.fetch_add(1);
+            if (index >= ranges.size())
+            {
+                return;
+            }
+
+            const auto& range = ranges[index];
+            auto& file = files[range.fileIndex];
+            if (file.failed.load())
+            {
+                continue;
+            }
+
+            //packed file is a range of its pack
+            ifstream input(file.packed ? m_packStore.getPackPath(file.packed->pack) : backupFolder / file.backupName, ios::binary);
+            const auto offset = range.offset + (file.packed ? file.packed->offset : 0);
+            if (offset > 0)
+            {
+                input.seekg(static_cast<streamoff>(offset));
+            }
+
+            uint32_t checksum = 0;
+            uintmax_t remaining = range.length;
+            while (remaining > 0 && input)
+            {
+                const auto toRead = static_cast<size_t>(min<uintmax_t>(buffer.size(), remaining));
+                input.read(buffer.data(), static_cast<streamsize>(toRead));
+                const auto bytesRead = static_cast<size_t>(input.gcount());
+                checksum = Crc32c::update(checksum, buffer.data(), bytesRead);
+                remaining -= bytesRead;
+            }
+
+            if (remaining > 0)
+            {
+                file.failed.store(true);
+                continue;
+            }
+
+            file.rangeChecksums[range.rangeIndex] = checksum;
+            checkedBytes.fetch_add(range.length);
+        }
+    };
+
+    if (threadCount == 0)
+    {
+        threadCount = 1;
+    }
+
+    vector<thread> workers;
+    for (unsigned int i = 1; i < threadCount; i++)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& workerThread : workers)
+    {
+        workerThread.join();
+    }
+
+    unordered_set<string> knownBackups;
+    for (auto& file : files)
+    {
+        knownBackups.insert(file.backupName);
+
+        const auto backupPath = file.packed ? m_packStore.getPackPath(file.packed->pack) : backupFolder / file.backupName;
+        error_code ec;
+        auto actualSize = fs::file_size(backupPath, ec);
+        if (file.packed && !ec)
+        {
+            //pack cut short leaves only part of the file
+            const auto packedEnd = file.packed->offset + file.packed->length;
+            actualSize = actualSize >= packedEnd ? file.packed->length : actualSize - min(actualSize, file.packed->offset);
+        }
+        const auto reportedPath = file.packed ? backupPath.string() + " (" + file.backupName + ")" : backupPath.string();
+        if (ec)
+        {
+            result.missing++;
+            cout << "MISSING " << reportedPath << "\n";
+            continue;
+        }
+
+        result.checkedFiles++;
+
+        if (actualSize != file.expected.size || file.failed.load())
+        {
+            result.mismatches++;
+            cout << "MISMATCH " << reportedPath << " expected size " << file.expected.size
+                << " actual size " << actualSize << "\n";
+            continue;
+        }
+
+        uint32_t checksum = 0;
+        for (size_t range = 0; range < file.rangeChecksums.size(); range++)
+        {
+            const auto length = min(RangeSize, file.expected.size - range * RangeSize);
+            checksum = Crc32c::combine(checksum, file.rangeChecksums[range], length);
+        }
+
+        if (checksum != file.expected.checksum)
+        {
+            result.mismatches++;
+            cout << "MISMATCH " << reportedPath << " expected checksum " << Crc32c::toString(file.expected.checksum)
+                << " actual checksum " << Crc32c::toString(checksum) << "\n";
+        }
+    }
+
+    auto& gd = GlobalData::getInstance();
+    error_code ec;
+    for (const auto& backup : fs::directory_iterator(backupFolder, ec))
+    {
+        if (backup.path().extension() == gd.getBackupExtension() &&
+            knownBackups.find(backup.path().filename().string()) == knownBackups.end())
+        {
+            result.withoutChecksum++;
+        }
+    }
+
+    result.checkedBytes = checkedBytes.load();
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <filesystem>
+#include <cstdint>
+#include "ChecksumStore.h"
+#include "PackStore.h"
+/**
+ * @brief Re-hashes backup files and compares them with checksum manifest
+ * Files kept in packs are checked against checksums in pack index.
+ * Files are split into ranges so that all cores are busy even when
+ * backup set is a handful of huge files.
+ */
+class BackupVerifier
+{
+public:
+    /**
+     * @brief Outcome of a verify run
+     * mismatches: checksum or size differs from manifest
+     * missing: manifest has a record but backup file can not be read
+     * withoutChecksum: backup files which have no record in manifest
+     */
+    struct Result
+    {
+        std::size_t checkedFiles = 0;
+        std::size_t mismatches = 0;
+        std::size_t missing = 0;
+        std::size_t withoutChecksum = 0;
+        std::uintmax_t checkedBytes = 0;
+        double seconds = 0;
+    };
+
+    BackupVerifier(const ChecksumStore& checksumStore, const PackStore& packStore);
+    ~BackupVerifier();
+    /**
+     * @brief Verify every backup in folder, problems are printed as they are found
+     * @param backupFolder: folder with backup files
+     * @param threadCount: amount of hashing threads
+     */
+    Result verify(const std::filesystem::path& backupFolder, unsigned int threadCount) const;
+private:
+    const ChecksumStore& m_checksumStore;
+    const PackStore& m_packStore;
+    static const std::uintmax_t RangeSize;
+    static const std::size_t ReadBufferSize;
+};
\ No newline at end of file
@@ -0,0 +1,596 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <regex>
+#include <random>
+#include <functional>
+#include "GlobalData.h"
+#include "FSHelper.h"
+#include "LogUtility.h"
+#include "BackupRunner.h"
+#include "FileCopier.h"
+#include "MemoryFileSystem.h"
+#include "Metrics.h"
+#include "TimestampFormatter.h"
+#include "Crc32c.h"
+#include "WorkloadGenerator.h"
+#include "AllocationCounter.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+/**
+ * @brief Outcome of a single benchmark
+ * items: files, log records or lines processed
+ * bytes: data copied, 0 when benchmark is not about data
+ */
+struct BenchmarkResult
+{
+    string name;
+    uint64_t items = 0;
+    uint64_t bytes = 0;
+    double seconds = 0;
+    uint64_t allocations = 0;
+};
+
+/**
+ * @brief Benchmark settings, can be changed from command line
+ */
+struct BenchmarkOptions
+{
+    fs::path workDir;
+    fs::path jsonOutput;
+    fs::path baseline;
+    size_t tinyFiles = 20000;
+    size_t hugeFiles = 2;
+    uintmax_t hugeFileMb = 256;
+    size_t deepTreeDepth = 6;
+    size_t logRecords = 100000;
+    size_t logWriteRecords = 2000;
+    size_t logSearchLines = 200000;
+    size_t memoryFiles = 200000;
+    unsigned int memoryLatencyUs = 5;
+    unsigned int repeat = 3;
+    bool keepWorkDir = false;
+};
+
+double secondsSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Run func repeat times and keep the fastest run
+ * Use only for benchmarks which leave the environment unchanged.
+ */
+BenchmarkResult measure(const string& name, uint64_t items, uint64_t bytes, unsigned int repeat,
+    const function<void()>& func)
+{
+    BenchmarkResult result{name, items, bytes, 0, 0};
+    for (unsigned int i = 0; i < max(1u, repeat); i++)
+    {
+        const auto allocationsBefore = AllocationCounter::getCount();
+        const auto start = chrono::steady_clock::now();
+        func();
+        const auto seconds = secondsSince(start);
+        const auto allocations = AllocationCounter::getCount() - allocationsBefore;
+        if (i == 0 || seconds < result.seconds)
+        {
+            result.seconds = seconds;
+        }
+        if (i == 0 || allocations < result.allocations)
+        {
+            result.allocations = allocations;
+        }
+    }
+
+    cout << "  " << name << ": " << result.seconds << " s";
+    if (result.seconds > 0)
+    {
+        cout << ", " << static_cast<double>(items) / result.seconds << " items/s";
+        if (bytes > 0)
+        {
+            cout << ", " << static_cast<double>(bytes) / result.seconds / (1024 * 1024) << " MB/s";
+        }
+    }
+    if (items > 0)
+    {
+        cout << ", " << static_cast<double>(result.allocations) / static_cast<double>(items) << " allocations/item";
+    }
+    cout << endl;
+
+    return result;
+}
+
+void useFolders(const fs::path& hot, const fs::path& backup)
+{
+    fs::create_directories(hot);
+    GlobalData::removeInstance();
+    GlobalData::getInstance(hot.string(), backup.string());
+}
+
+void runLogBenchmarks(const BenchmarkOptions& options, vector<BenchmarkResult>& results)
+{
+    cout << "Log benchmarks" << endl;
+
+    {
+        LogUtility writerLog;
+        auto& writer = writerLog.getLogWriter();
+        for (size_t i = 0; i < options.logWriteRecords; i++)
+        {
+            writer.addMessageToLog("/bench/hot/file_" + to_string(i) + ".txt", LogUtility::Action::Update);
+        }
+
+        thread writeToFileThread(&LogUtility::writeToFileThread, &writerLog);
+        results.push_back(measure("log_write", options.logWriteRecords, 0, 1, [&]()
+        {
+            while (writerLog.getQueueSize() > 0)
+            {
+                this_thread::sleep_for(chrono::microseconds(100));
+            }
+        }));
+        writerLog.stopThreads();
+        writeToFileThread.join();
+    }
+
+    //timestamp of every record as formatted before TimestampFormatter, kept here as the baseline
+    size_t timestampBytes = 0;
+    results.push_back(measure("log_timestamp_strftime", options.logRecords, 0, options.repeat, [&]()
+    {
+        for (size_t i = 0; i < options.logRecords; i++)
+        {
+            time_t now;
+            time(&now);
+            char buf[256];
+            strftime(buf, sizeof buf, "%Y-%m-%dT%H:%M:%S+00:00", gmtime(&now));
+            string timestamp = buf;
+            timestampBytes += timestamp.size();
+        }
+    }));
+
+    TimestampFormatter formatter;
+    string record;
+    record.reserve(TimestampFormatter::Length);
+    results.push_back(measure("log_timestamp_cached", options.logRecords, 0, options.repeat, [&]()
+    {
+        for (size_t i = 0; i < options.logRecords; i++)
+        {
+            record.clear();
+            formatter.append(record);
+            timestampBytes += record.size();
+        }
+    }));
+
+    LogUtility log;
+    auto& writer = log.getLogWriter();
+    const string source{"/bench/hot/some/deeper/folder/document.txt"};
+    const string destination{"/bench/backup/document.txt.bak"};
+    results.push_back(measure("log_enqueue", options.logRecords, 0, 1, [&]()
+    {
+        for (size_t i = 0; i < options.logRecords; i++)
+        {
+            writer.addMessageToLog(source, destination, LogUtility::Action::Backup);
+        }
+    }));
+
+    {
+        ofstream logFile("FolderBackupLog.txt", fstream::app);
+        for (size_t i = 0; i < options.logSearchLines; i++)
+        {
+            logFile << "2023-02-12T12:20:55+00:00 /bench/hot/folder_" << i % 100 << "/file_" << i
+                << ".txt was backed up to: /bench/backup/file_" << i << ".txt.bak\n";
+        }
+    }
+
+    //records appended behind LogUtility's back are only seen by a new instance
+    LogUtility searchedLog;
+    size_t matches = 0;
+    const auto logLines = options.logSearchLines + options.logWriteRecords;
+    results.push_back(measure("log_search_simple", logLines, 0, options.repeat, [&]()
+    {
+        matches = 0;
+        searchedLog.searchLog([&matches](const string& line)
+        {
+            if (line.find("file_4242.txt", 0) != string::npos)
+            {
+                matches++;
+            }
+        });
+    }));
+
+    const regex searchRegex{"folder_4[0-9]/file_[0-9]*7\\.txt"};
+    results.push_back(measure("log_search_regex", logLines, 0, options.repeat, [&]()
+    {
+        matches = 0;
+        searchedLog.searchLog([&matches, &searchRegex](const string& line)
+        {
+            if (regex_search(line, searchRegex))
+            {
+                matches++;
+            }
+        });
+    }));
+
+    //same queries answered by path index, items are still log lines to compare with full scans
+    results.push_back(measure("log_search_file_name", logLines, 0, options.repeat, [&]()
+    {
+        matches = 0;
+        searchedLog.searchLogByFileName("file_4242.txt", [&matches](const string&)
+        {
+            matches++;
+        });
+    }));
+
+    results.push_back(measure("log_search_file_name_regex", logLines, 0, options.repeat, [&]()
+    {
+        matches = 0;
+        searchedLog.searchLogByFileNameRegex("folder_4[0-9]/file_[0-9]*7\\.txt", [&matches](const string&)
+        {
+            matches++;
+        });
+    }));
+}
+
+void runPassBenchmarks(const BenchmarkOptions& options, vector<BenchmarkResult>& results)
+{
+    cout << "Backup pass benchmarks" << endl;
+
+    WorkloadGenerator generator(options.workDir / "hot", 42);
+    LogUtility log;
+    FSHelper fsHelper(log.getLogWriter());
+    atomic<bool> stopRequested{false};
+    BackupRunner runner(fsHelper, stopRequested);
+
+    auto tiny = generator.createTinyFiles("tiny", options.tinyFiles, 4096);
+    useFolders(options.workDir / "hot" / "tiny", options.workDir / "backup_tiny");
+    fsHelper.initEnvironment();
+    results.push_back(measure("pass_tiny_initial", tiny.files, tiny.bytes, 1, [&]() { runner.runPass(); }));
+    results.push_back(measure("pass_tiny_unchanged", tiny.files, 0, options.repeat, [&]() { runner.runPass(); }));
+
+    auto churn = generator.applyChurn("tiny", 0.1, 0.02, options.tinyFiles / 50);
+    results.push_back(measure("pass_tiny_churn", tiny.files, churn.bytes, 1, [&]() { runner.runPass(); }));
+
+    //same tiny files appended into packs instead of a backup file each
+    GlobalData::getInstance().setPackThreshold(8 * 1024);
+    useFolders(options.workDir / "hot" / "tiny", options.workDir / "backup_tiny_packed");
+    fsHelper.initEnvironment();
+    results.push_back(measure("pass_tiny_packed_initial", tiny.files, tiny.bytes, 1, [&]() { runner.runPass(); }));
+    results.push_back(measure("pass_tiny_packed_unchanged", tiny.files, 0, options.repeat, [&]() { runner.runPass(); }));
+    GlobalData::getInstance().setPackThreshold(0);
+
+    auto deep = generator.createDeepTree("deep", options.deepTreeDepth, 2, 4, 256);
+    useFolders(options.workDir / "hot" / "deep", options.workDir / "backup_deep");
+    fsHelper.initEnvironment();
+    results.push_back(measure("pass_deep_initial", deep.files, deep.bytes, 1, [&]() { runner.runPass(); }));
+    results.push_back(measure("pass_deep_unchanged", deep.files, 0, options.repeat, [&]() { runner.runPass(); }));
+
+    //small files found in the same pass as huge ones are backed up while huge ones are still copied
+    auto mixedHuge = generator.createHugeFiles("mixed", options.hugeFiles, options.hugeFileMb * 1024 * 1024);
+    auto mixedTiny = generator.createTinyFiles("mixed", 1000, 4096);
+    useFolders(options.workDir / "hot" / "mixed", options.workDir / "backup_mixed");
+    fsHelper.initEnvironment();
+    results.push_back(measure("pass_mixed_small_files", mixedTiny.files, mixedTiny.bytes, 1, [&]() { runner.runPass(); }));
+    results.push_back(measure("pass_mixed_large_files", mixedHuge.files, mixedHuge.bytes, 1, [&]() { runner.waitUntilIdle(); }));
+
+    //half of the tree sits below level0_1, it is pruned without being listed
+    GlobalData::getInstance().addFilterRule({PathFilter::RuleType::ExcludeGlob, "level0_1"});
+    GlobalData::getInstance().addFilterRule({PathFilter::RuleType::ExcludeGlob, "*.tmp"});
+    BackupRunner filteredRunner(fsHelper, stopRequested);
+    results.push_back(measure("pass_deep_filtered", deep.files, 0, options.repeat, [&]() { filteredRunner.runPass(); }));
+}
+
+void runMemoryBenchmarks(const BenchmarkOptions& options, vector<BenchmarkResult>& results)
+{
+    cout << "In-memory file system benchmarks" << endl;
+
+    //hot and backup folders exist only in memory, checksum manifest and pack index are still real files
+    const auto hot = options.workDir / "memory_hot";
+    const auto backup = options.workDir / "memory_backup";
+    fs::create_directories(backup);
+    GlobalData::removeInstance();
+    GlobalData::getInstance(hot.string(), backup.string());
+
+    const size_t filesPerFolder = 1000;
+    const uintmax_t fileSize = 4096;
+    MemoryFileSystem fileSystem;
+    auto filePath = [&](size_t i) { return hot / ("folder_" + to_string(i / filesPerFolder)) / ("file_" + to_string(i) + ".txt"); };
+    for (size_t i = 0; i < options.memoryFiles; i++)
+    {
+        fileSystem.writeFile(filePath(i), fileSize);
+    }
+
+    LogUtility log;
+    FSHelper fsHelper(log.getLogWriter(), fileSystem);
+    fsHelper.initEnvironment();
+    atomic<bool> stopRequested{false};
+    BackupRunner runner(fsHelper, stopRequested);
+    auto runPass = [&]() { runner.runPass(); };
+
+    results.push_back(measure("memory_pass_initial", options.memoryFiles, options.memoryFiles * fileSize, 1, runPass));
+    results.push_back(measure("memory_pass_unchanged", options.memoryFiles, 0, options.repeat, runPass));
+
+    size_t changed = 0;
+    for (size_t i = 0; i < options.memoryFiles; i += 10)
+    {
+        fileSystem.writeFile(filePath(i), fileSize * 2);
+        changed++;
+    }
+    results.push_back(measure("memory_pass_churn", options.memoryFiles, changed * fileSize * 2, 1, runPass));
+
+    //every status query waits like a round trip to a file server
+    fileSystem.setLatency(MemoryFileSystem::Operation::Status, chrono::microseconds(options.memoryLatencyUs));
+    const auto statusBefore = fileSystem.getOperationCount(MemoryFileSystem::Operation::Status);
+    results.push_back(measure("memory_pass_unchanged_slow_status", options.memoryFiles, 0, 1, runPass));
+    const auto statusCalls = fileSystem.getOperationCount(MemoryFileSystem::Operation::Status) - statusBefore;
+    cout << "    " << static_cast<double>(statusCalls) / static_cast<double>(max<size_t>(options.memoryFiles, 1))
+        << " status calls per file at " << options.memoryLatencyUs << " us each" << endl;
+    fileSystem.setLatency(MemoryFileSystem::Operation::Status, chrono::nanoseconds::zero());
+
+    //first pass lists every folder and compares backups with them once, later ones only compare listings
+    auto& gd = GlobalData::getInstance();
+    gd.setOrphanMode(GlobalData::OrphanMode::Remove);
+    BackupRunner orphanRunner(fsHelper, stopRequested);
+    orphanRunner.runPass();
+    auto runOrphanPass = [&]() { orphanRunner.runPass(); };
+    results.push_back(measure("memory_pass_unchanged_orphans", options.memoryFiles, 0, options.repeat, runOrphanPass));
+
+    size_t deleted = 0;
+    for (size_t i = 0; i < options.memoryFiles; i += 100)
+    {
+        error_code ec;
+        fileSystem.remove(filePath(i), ec);
+        deleted++;
+    }
+    gd.setOrphanBatch(deleted);
+    const auto removedBefore = Metrics::getInstance().getCounter(Metrics::Counter::OrphansRemoved);
+    results.push_back(measure("memory_pass_orphans_removed", options.memoryFiles, 0, 1, runOrphanPass));
+    cout << "    " << Metrics::getInstance().getCounter(Metrics::Counter::OrphansRemoved) - removedBefore << " of "
+        << deleted << " deleted files had their backups removed" << endl;
+    gd.setOrphanMode(GlobalData::OrphanMode::Off);
+}
+
+void runCopyBenchmarks(const BenchmarkOptions& options, vector<BenchmarkResult>& results)
+{
+    cout << "Copy benchmarks" << endl;
+
+    WorkloadGenerator generator(options.workDir / "hot", 7);
+    const auto hugeSize = options.hugeFileMb * 1024 * 1024;
+    auto huge = generator.createHugeFiles("huge", options.hugeFiles, hugeSize);
+    const auto backup = options.workDir / "backup_huge";
+    useFolders(options.workDir / "hot" / "huge", backup);
+    fs::create_directories(backup);
+
+    auto& gd = GlobalData::getInstance();
+    FileCopier copier;
+    auto copyAll = [&]()
+    {
+        for (size_t i = 0; i < options.hugeFiles; i++)
+        {
+            const string name{"huge_" + to_string(i) + ".img"};
+            FileCopier::CopyStats stats;
+            error_code ec;
+            fs::remove(backup / name, ec);
+            copier.copy(gd.getHotFolderPath() / name, backup / name, stats, ec);
+            if (ec)
+            {
+                cerr << "Copy failed: " << ec.message() << "\n";
+            }
+        }
+    };
+
+    gd.setLargeFileThreshold(UINTMAX_MAX);
+    results.push_back(measure("copy_huge_single", huge.files, huge.bytes, options.repeat, copyAll));
+
+    gd.setLargeFileThreshold(0);
+    results.push_back(measure("copy_huge_parallel", huge.files, huge.bytes, options.repeat, copyAll));
+
+    gd.setChecksumEnabled(false);
+    results.push_back(measure("copy_huge_parallel_no_checksum", huge.files, huge.bytes, options.repeat, copyAll));
+    gd.setChecksumEnabled(true);
+}
+
+/**
+ * @brief Results are written one benchmark per line, so files are easy to diff and to read back
+ */
+void writeJson(const fs::path& output, const vector<BenchmarkResult>& results)
+{
+    ofstream json(output, fstream::trunc);
+
+    json << "{\n  \"context\": {\"crc32c_hardware\": " << (Crc32c::isHardwareAccelerated() ? "true" : "false")
+        << ", \"hardware_threads\": " << thread::hardware_concurrency() << "},\n";
+    json << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const auto& result = results[i];
+        const auto itemsPerSecond = result.seconds > 0 ? static_cast<double>(result.items) / result.seconds : 0;
+        const auto bytesPerSecond = result.seconds > 0 ? static_cast<double>(result.bytes) / result.seconds : 0;
+        json << "    {\"name\": \"" << result.name << "\", \"items\": " << result.items << ", \"bytes\": " << result.bytes
+            << ", \"seconds\": " << result.seconds << ", \"items_per_second\": " << itemsPerSecond
+            << ", \"bytes_per_second\": " << bytesPerSecond << ", \"allocations\": " << result.allocations << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+}
+
+/**
+ * @brief Print throughput change against results of another build
+ */
+void compareWithBaseline(const fs::path& baseline, const vector<BenchmarkResult>& results)
+{
+    ifstream json(baseline);
+    if (!json)
+    {
+        cerr << "Unable to read baseline: " << baseline.string() << "\n";
+        return;
+    }
+
+    const regex benchmarkLine{"\"name\": \"([^\"]+)\".*\"items_per_second\": ([-0-9.eE+]+)"};
+    map<string, double> baselineRates;
+    string line;
+    while (getline(json, line))
+    {
+        smatch match;
+        if (regex_search(line, match, benchmarkLine))
+        {
+            baselineRates[match[1].str()] = stod(match[2].str());
+        }
+    }
+
+    cout << "Compared with " << baseline.string() << " (items/s, positive is faster)" << endl;
+    for (const auto& result : results)
+    {
+        const auto previous = baselineRates.find(result.name);
+        if (previous == baselineRates.end() || previous->second <= 0 || result.seconds <= 0)
+        {
+            continue;
+        }
+        const auto current = static_cast<double>(result.items) / result.seconds;
+        cout << "  " << result.name << ": " << (current / previous->second - 1.0) * 100.0 << " %" << endl;
+    }
+}
+
+void printUsage()
+{
+    cout << "Usage: FolderBackupBench [options]\n";
+    cout << "  --work-dir=<dir>        where workloads are generated (default: temporary folder)\n";
+    cout << "  --json=<file>           write machine readable results\n";
+    cout << "  --baseline=<file>       compare with results of previous run\n";
+    cout << "  --tiny-files=<N>        amount of tiny files (default 20000)\n";
+    cout << "  --huge-files=<N>        amount of huge files (default 2)\n";
+    cout << "  --huge-file-mb=<MB>     size of each huge file (default 256)\n";
+    cout << "  --deep-tree-depth=<N>   levels of deep tree (default 6)\n";
+    cout << "  --log-records=<N>       records queued by log enqueue benchmark (default 100000)\n";
+    cout << "  --memory-files=<N>      files of in-memory file system benchmarks (default 200000)\n";
+    cout << "  --memory-latency-us=<N> delay of every status query in slow in-memory pass (default 5)\n";
+    cout << "  --repeat=<N>            runs of repeatable benchmarks, fastest is reported (default 3)\n";
+    cout << "  --keep                  do not delete generated files\n";
+}
+
+bool parseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const string option{argv[i]};
+        const auto separator = option.find('=');
+        const auto name = option.substr(0, separator);
+        const auto value = separator == string::npos ? string{} : option.substr(separator + 1);
+
+        try
+        {
+            if (name == "--work-dir" && !value.empty())
+            {
+                options.workDir = fs::absolute(value);
+            }
+            else if (name == "--json" && !value.empty())
+            {
+                options.jsonOutput = fs::absolute(value);
+            }
+            else if (name == "--baseline" && !value.empty())
+            {
+                options.baseline = fs::absolute(value);
+            }
+            else if (name == "--tiny-files" && !value.empty())
+            {
+                options.tinyFiles = stoul(value);
+            }
+            else if (name == "--huge-files" && !value.empty())
+            {
+                options.hugeFiles = stoul(value);
+            }
+            else if (name == "--huge-file-mb" && !value.empty())
+            {
+                options.hugeFileMb = stoull(value);
+            }
+            else if (name == "--deep-tree-depth" && !value.empty())
+            {
+                options.deepTreeDepth = stoul(value);
+            }
+            else if (name == "--log-records" && !value.empty())
+            {
+                options.logRecords = stoul(value);
+            }
+            else if (name == "--memory-files" && !value.empty())
+            {
+                options.memoryFiles = stoul(value);
+            }
+            else if (name == "--memory-latency-us" && !value.empty())
+            {
+                options.memoryLatencyUs = static_cast<unsigned int>(stoul(value));
+            }
+            else if (name == "--repeat" && !value.empty())
+            {
+                options.repeat = static_cast<unsigned int>(stoul(value));
+            }
+            else if (name == "--keep")
+            {
+                options.keepWorkDir = true;
+            }
+            else
+            {
+                cerr << "Unknown option: " << option << "\n";
+                return false;
+            }
+        }
+        catch (const exception&)
+        {
+            cerr << "Invalid value for option: " << option << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return -1;
+    }
+
+    if (options.workDir.empty())
+    {
+        random_device random;
+        options.workDir = fs::temp_directory_path() / ("FolderBackupBench_" + to_string(random()));
+    }
+
+    fs::create_directories(options.workDir);
+    const auto originalDir = fs::current_path();
+    //log file is created in current directory
+    fs::current_path(options.workDir);
+
+    cout << "Workload folder: " << options.workDir.string() << endl;
+
+    vector<BenchmarkResult> results;
+    runLogBenchmarks(options, results);
+    runPassBenchmarks(options, results);
+    runMemoryBenchmarks(options, results);
+    runCopyBenchmarks(options, results);
+
+    fs::current_path(originalDir);
+
+    if (!options.jsonOutput.empty())
+    {
+        writeJson(options.jsonOutput, results);
+    }
+
+    if (!options.baseline.empty())
+    {
+        compareWithBaseline(options.baseline, results);
+    }
+
+    if (!options.keepWorkDir)
+    {
+        error_code ec;
+        fs::remove_all(options.workDir, ec);
+    }
+
+    return 0;
+}
\ No newline at end of file
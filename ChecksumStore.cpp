@@ -0,0 +1,193 @@
+#include "ChecksumStore.h"
+#include "Crc32c.h"
+#include <iostream>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+const string ChecksumStore::RemovedMarker{"-"};
+
+ChecksumStore::ChecksumStore():
+    m_mutex{},
+    m_entries{},
+    m_manifestPath{},
+    m_manifest{}
+{
+
+}
+
+ChecksumStore::~ChecksumStore()
+{
+
+}
+
+void ChecksumStore::load(const fs::path& manifestPath)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    const auto lineCount = readLocked(manifestPath);
+
+    if (lineCount > m_entries.size())
+    {
+        //drop lines of overwritten and removed backups
+        auto compacted = m_manifestPath;
+        compacted += ".tmp";
+        {
+            ofstream manifest(compacted, fstream::trunc);
+            for (const auto& [backupName, entry] : m_entries)
+            {
+                manifest << formatLine(backupName, entry) << "\n";
+            }
+        }
+
+        error_code ec;
+        fs::rename(compacted, m_manifestPath, ec);
+        if (ec)
+        {
+            cerr << "Failed to compact checksum manifest: " << m_manifestPath.string() << " - Due to Error: " << ec.message() << "\n";
+        }
+    }
+
+    m_manifest.open(m_manifestPath, fstream::app);
+}
+
+void ChecksumStore::loadReadOnly(const fs::path& manifestPath)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    readLocked(manifestPath);
+}
+
+size_t ChecksumStore::readLocked(const fs::path& manifestPath)
+{
+    m_manifestPath = manifestPath;
+    m_entries.clear();
+    if (m_manifest.is_open())
+    {
+        m_manifest.close();
+    }
+
+    size_t lineCount = 0;
+    ifstream manifest(m_manifestPath, fstream::in);
+    string line;
+    while (getline(manifest, line))
+    {
+        string backupName;
+        optional<Entry> entry;
+        if (!parseLine(line, backupName, entry))
+        {
+            continue;
+        }
+
+        lineCount++;
+        if (entry)
+        {
+            m_entries[backupName] = entry.value();
+        }
+        else
+        {
+            m_entries.erase(backupName);
+        }
+    }
+
+    return lineCount;
+}
+
+void ChecksumStore::set(const string& backupName, const Entry& entry)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    m_entries[backupName] = entry;
+    appendLine(formatLine(backupName, entry));
+}
+
+void ChecksumStore::remove(const string& backupName)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    if (m_entries.erase(backupName) > 0)
+    {
+        appendLine(backupName + "\t" + RemovedMarker);
+    }
+}
+
+optional<ChecksumStore::Entry> ChecksumStore::get(const string& backupName) const
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    const auto entry = m_entries.find(backupName);
+    if (entry == m_entries.end())
+    {
+        return nullopt;
+    }
+
+    return entry->second;
+}
+
+vector<pair<string, ChecksumStore::Entry>> ChecksumStore::getAll() const
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    return {m_entries.begin(), m_entries.end()};
+}
+
+void ChecksumStore::appendLine(const string& line)
+{
+    if (!m_manifest.is_open())
+    {
+        return;
+    }
+
+    m_manifest << line << "\n";
+    m_manifest.flush();
+}
+
+string ChecksumStore::formatLine(const string& backupName, const Entry& entry) const
+{
+    return backupName + "\t" + Crc32c::toString(entry.checksum) + "\t" + to_string(entry.size) + "\t" + entry.sourcePath;
+}
+
+bool ChecksumStore::parseLine(const string& line, string& backupName, optional<Entry>& entry) const
+{
+    const auto nameEnd = line.find('\t');
+    if (nameEnd == string::npos || nameEnd == 0)
+    {
+        return false;
+    }
+
+    backupName = line.substr(0, nameEnd);
+
+    if (line.compare(nameEnd + 1, string::npos, RemovedMarker) == 0)
+    {
+        entry = nullopt;
+        return true;
+    }
+
+    const auto checksumEnd = line.find('\t', nameEnd + 1);
+    const auto sizeEnd = checksumEnd == string::npos ? string::npos : line.find('\t', checksumEnd + 1);
+    if (sizeEnd == string::npos)
+    {
+        return false;
+    }
+
+    const auto checksum = Crc32c::fromString(line.substr(nameEnd + 1, checksumEnd - nameEnd - 1));
+    if (!checksum)
+    {
+        return false;
+    }
+
+    Entry parsed;
+    parsed.checksum = checksum.value();
+    try
+    {
+        parsed.size = stoull(line.substr(checksumEnd + 1, sizeEnd - checksumEnd - 1));
+    }
+    catch (const exception&)
+    {
+        return false;
+    }
+    parsed.sourcePath = line.substr(sizeEnd + 1);
+
+    entry = parsed;
+    return true;
+}
\ No newline at end of file
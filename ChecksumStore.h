@@ -0,0 +1,76 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <optional>
+#include <mutex>
+#include <fstream>
+#include <cstdint>
+/**
+ * @brief Keeps checksum of every backup file in a manifest inside backup folder
+ * Manifest is an append only text file, newest line of a backup wins.
+ * It is rewritten without stale lines when loaded by the process writing backups.
+ */
+class ChecksumStore
+{
+public:
+    /**
+     * @brief Checksum record of a single backup file
+     * sourcePath: location of original file relative to hot folder
+     */
+    struct Entry
+    {
+        std::uint32_t checksum = 0;
+        std::uintmax_t size = 0;
+        std::string sourcePath;
+    };
+
+    ChecksumStore(const ChecksumStore&) = delete;
+    ChecksumStore& operator=(const ChecksumStore&) = delete;
+    ChecksumStore& operator==(const ChecksumStore&) = delete;
+
+    ChecksumStore();
+    ~ChecksumStore();
+    /**
+     * @brief Read manifest from given file, compacting it if it has stale lines
+     * Only the process writing backups may call it, compaction replaces the manifest file.
+     * @param manifestPath: manifest file, created on first write if missing
+     */
+    void load(const std::filesystem::path& manifestPath);
+    /**
+     * @brief Read manifest from given file without changing it
+     * Safe while a running backup appends to the manifest, set and remove are not written to the file.
+     */
+    void loadReadOnly(const std::filesystem::path& manifestPath);
+    /**
+     * @brief Remember checksum of a backup file
+     * @param backupName: backup file name relative to backup folder
+     */
+    void set(const std::string& backupName, const Entry& entry);
+    /**
+     * @brief Forget checksum of a deleted backup file
+     */
+    void remove(const std::string& backupName);
+
+    std::optional<Entry> get(const std::string& backupName) const;
+    /**
+     * @brief Copy of all records, safe to use while backup keeps running
+     */
+    std::vector<std::pair<std::string, Entry>> getAll() const;
+private:
+    /**
+     * @return number of valid lines in manifest
+     */
+    std::size_t readLocked(const std::filesystem::path& manifestPath);
+    void appendLine(const std::string& line);
+    bool parseLine(const std::string& line, std::string& backupName, std::optional<Entry>& entry) const;
+    std::string formatLine(const std::string& backupName, const Entry& entry) const;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+    std::filesystem::path m_manifestPath;
+    std::ofstream m_manifest;
+    static const std::string RemovedMarker;
+};
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "Tests.h"
+#include "ChecksumStore.h"
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+    string readText(const fs::path& path)
+    {
+        ifstream input(path, ios::binary);
+        stringstream text;
+        text << input.rdbuf();
+        return text.str();
+    }
+
+    size_t countLines(const string& text)
+    {
+        size_t lines = 0;
+        for (const auto c : text)
+        {
+            lines += c == '\n' ? 1 : 0;
+        }
+        return lines;
+    }
+}
+
+TEST(ChecksumStoreManifestRoundTrip)
+{
+    const auto manifest = TestRegistry::makeTempFolder("checksums") / "FolderBackup.crc";
+    {
+        ChecksumStore store;
+        store.load(manifest);
+        store.set("a.txt.bak", {0xE3069283u, 9, "folder/a.txt"});
+        store.set("b.txt.bak", {1, 0, "b.txt"});
+        store.set("c.txt.bak", {2, 2, "sub folder/c.txt"});
+        store.set("a.txt.bak", {3, 10, "folder/a.txt"});
+        store.remove("b.txt.bak");
+    }
+
+    const auto written = readText(manifest);
+    CHECK(countLines(written) == 5);
+
+    ChecksumStore reader;
+    reader.loadReadOnly(manifest);
+    const auto a = reader.get("a.txt.bak");
+    CHECK(a && a->checksum == 3 && a->size == 10 && a->sourcePath == "folder/a.txt");
+    CHECK(!reader.get("b.txt.bak"));
+    const auto c = reader.get("c.txt.bak");
+    CHECK(c && c->checksum == 2 && c->size == 2 && c->sourcePath == "sub folder/c.txt");
+    CHECK(reader.getAll().size() == 2);
+
+    //read only load leaves stale lines in place, writers compact them
+    reader.set("d.txt.bak", {4, 4, "d.txt"});
+    CHECK(readText(manifest) == written);
+
+    ChecksumStore writer;
+    writer.load(manifest);
+    CHECK(countLines(readText(manifest)) == 2);
+    CHECK(writer.getAll().size() == 2);
+    const auto compacted = writer.get("a.txt.bak");
+    CHECK(compacted && compacted->checksum == 3);
+}
+
+TEST(ChecksumStoreSkipsDamagedLines)
+{
+    const auto manifest = TestRegistry::makeTempFolder("checksums_damaged") / "FolderBackup.crc";
+    {
+        ofstream output(manifest, ios::binary);
+        output << "good.bak\t0000000a\t5\tgood\n";
+        output << "no tabs at all\n";
+        output << "bad.bak\tzz\t5\tbad\n";
+        output << "\t00000001\t1\tnameless\n";
+        output << "cut.bak\t0000000b";
+    }
+
+    ChecksumStore store;
+    store.loadReadOnly(manifest);
+    const auto good = store.get("good.bak");
+    CHECK(good && good->checksum == 10 && good->size == 5);
+    CHECK(store.getAll().size() == 1);
+}
\ No newline at end of file
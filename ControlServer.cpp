@@ -0,0 +1,392 @@
+#include "ControlServer.h"
+#include "GlobalData.h"
+#include "Metrics.h"
+#include <iostream>
+#include <sstream>
+#include <regex>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+    const size_t MaxCommandLength{64 * 1024};
+    const size_t SendBufferSize{64 * 1024};
+
+#ifndef _WIN32
+    bool fillAddress(const fs::path& socketPath, sockaddr_un& address)
+    {
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        const auto& native = socketPath.native();
+        if (native.size() >= sizeof(address.sun_path))
+        {
+            cerr << "Socket path is too long: " << socketPath.string() << endl;
+            return false;
+        }
+        memcpy(address.sun_path, native.c_str(), native.size());
+        return true;
+    }
+
+    bool writeAll(int descriptor, const char* data, size_t size)
+    {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        while (size > 0)
+        {
+            const auto written = send(descriptor, data, size, flags);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+#endif
+}
+
+ControlServer::ControlServer(const LogUtility& log, const BackupRunner& backupRunner, atomic<bool>& stopRequested):
+    m_log(log),
+    m_backupRunner(backupRunner),
+    m_stopRequested(stopRequested),
+    m_socketPath{},
+    m_socket(-1),
+    m_startTime(chrono::steady_clock::now())
+{
+
+}
+
+ControlServer::~ControlServer()
+{
+#ifndef _WIN32
+    if (m_socket >= 0)
+    {
+        close(m_socket);
+        error_code ec;
+        fs::remove(m_socketPath, ec);
+    }
+#endif
+}
+
+bool ControlServer::start(const fs::path& socketPath)
+{
+#ifdef _WIN32
+    cerr << "Daemon mode needs Unix domain sockets, it is not supported on this platform" << endl;
+    return false;
+#else
+    sockaddr_un address;
+    if (!fillAddress(socketPath, address))
+    {
+        return false;
+    }
+
+    //a daemon still answering on the socket must not be replaced, a stale socket file is
+    if (runClient(socketPath, "") != -1)
+    {
+        cerr << "Another instance is already listening on: " << socketPath.string() << endl;
+        return false;
+    }
+    error_code ec;
+    fs::remove(socketPath, ec);
+
+    m_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_socket < 0)
+    {
+        cerr << "Unable to create socket - Due to Error: " << strerror(errno) << endl;
+        return false;
+    }
+
+    //only the owner may control the daemon
+    const auto previousMask = umask(0077);
+    const bool bound = bind(m_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+    umask(previousMask);
+
+    if (!bound || listen(m_socket, 16) != 0)
+    {
+        cerr << "Unable to listen on " << socketPath.string() << " - Due to Error: " << strerror(errno) << endl;
+        close(m_socket);
+        m_socket = -1;
+        return false;
+    }
+
+    m_socketPath = socketPath;
+    return true;
+#endif
+}
+
+void ControlServer::serve()
+{
+#ifndef _WIN32
+    while (!m_stopRequested.load() && m_socket >= 0)
+    {
+        pollfd request{m_socket, POLLIN, 0};
+        if (poll(&request, 1, 200) <= 0)
+        {
+            continue;
+        }
+
+        const int connection = accept(m_socket, nullptr, nullptr);
+        if (connection < 0)
+        {
+            continue;
+        }
+
+        handleConnection(connection);
+        close(connection);
+    }
+#endif
+}
+
+void ControlServer::handleConnection(int connection) const
+{
+#ifndef _WIN32
+    //a client which does not finish its command must not block the daemon
+    timeval timeout{5, 0};
+    setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    string commandLine;
+    char buffer[4096];
+    while (commandLine.find('\n') == string::npos && commandLine.size() < MaxCommandLength)
+    {
+        const auto received = recv(connection, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+        {
+            break;
+        }
+        commandLine.append(buffer, static_cast<size_t>(received));
+    }
+
+    const auto lineEnd = commandLine.find_first_of("\r\n");
+    if (lineEnd == string::npos)
+    {
+        return;
+    }
+    commandLine.resize(lineEnd);
+
+    string response;
+    bool connected = true;
+    auto send = [&](const string& text)
+    {
+        response += text;
+        if (connected && response.size() >= SendBufferSize)
+        {
+            connected = writeAll(connection, response.data(), response.size());
+            response.clear();
+        }
+    };
+
+    handleCommand(commandLine, send);
+
+    if (connected)
+    {
+        writeAll(connection, response.data(), response.size());
+    }
+#else
+    (void)connection;
+#endif
+}
+
+string ControlServer::getStatus() const
+{
+    auto& gd = GlobalData::getInstance();
+    const auto uptime = chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - m_startTime);
+
+    ostringstream status;
+    status << "Hot folder: " << gd.getHotFolderPath().string() << "\n";
+    status << "Backup folder: " << gd.getBackupFolderPath().string() << "\n";
+    status << "Uptime: " << uptime.count() << " s\n";
+    status << "Log records in memory: " << m_log.getRecordCount() << ", waiting to be written: " << m_log.getQueueSize() << "\n";
+    status << Metrics::getInstance().toText();
+
+    return status.str();
+}
+
+void ControlServer::handleCommand(const string& commandLine, const function<void(const string&)>& send) const
+{
+    const auto separator = commandLine.find(' ');
+    const auto command = commandLine.substr(0, separator);
+    const auto argument = separator == string::npos ? string{} : commandLine.substr(separator + 1);
+
+    auto sendLine = [&send](const string& line)
+    {
+        send(line);
+        send("\n");
+    };
+
+    if (command.empty())
+    {
+        //used by start() to detect a live daemon
+        return;
+    }
+    else if (command == "help")
+    {
+        send("status                    backup folders, uptime and metrics\n"
+             "metrics                   metrics as shown by 'm' menu option\n"
+             "prometheus                metrics in Prometheus text format\n"
+             "print                     whole log\n"
+             "search <text>             log records containing text\n"
+             "regex <regex>             log records matching regex\n"
+             "file <text>               log records of files whose path contains text\n"
+             "fileregex <regex>         log records of files whose path matches regex\n"
+             "time <timestamp prefix>   log records written at given time, for example 2023-02-12T12:20\n"
+             "rescan                    start next backup pass right away\n"
+             "stop                      finish running pass and exit\n");
+    }
+    else if (command == "status")
+    {
+        send(getStatus());
+    }
+    else if (command == "metrics")
+    {
+        send(Metrics::getInstance().toText());
+    }
+    else if (command == "prometheus")
+    {
+        send(Metrics::getInstance().toPrometheus());
+    }
+    else if (command == "print")
+    {
+        m_log.searchLog(sendLine);
+    }
+    else if (command == "search" && !argument.empty())
+    {
+        m_log.searchLog([&](const string& record)
+        {
+            if (record.find(argument) != string::npos)
+            {
+                sendLine(record);
+            }
+        });
+    }
+    else if (command == "regex" && !argument.empty())
+    {
+        regex searchRegex;
+        try
+        {
+            searchRegex.assign(argument);
+        }
+        catch (const exception&)
+        {
+            send("ERROR unsupported regex format\n");
+            return;
+        }
+
+        m_log.searchLog([&](const string& record)
+        {
+            if (regex_search(record, searchRegex))
+            {
+                sendLine(record);
+            }
+        });
+    }
+    else if (command == "file" && !argument.empty())
+    {
+        m_log.searchLogByFileName(argument, sendLine);
+    }
+    else if (command == "fileregex" && !argument.empty())
+    {
+        if (!m_log.searchLogByFileNameRegex(argument, sendLine))
+        {
+            send("ERROR unsupported regex format\n");
+        }
+    }
+    else if (command == "time" && !argument.empty())
+    {
+        m_log.searchLogByTime(argument, sendLine);
+    }
+    else if (command == "rescan")
+    {
+        m_backupRunner.requestRescan();
+        send("Rescan requested\n");
+    }
+    else if (command == "stop")
+    {
+        m_stopRequested.store(true);
+        send("Stopping\n");
+    }
+    else
+    {
+        send("ERROR unknown command or missing argument, send 'help' for the list of commands\n");
+    }
+}
+
+int ControlServer::runClient(const fs::path& socketPath, const string& command)
+{
+#ifdef _WIN32
+    (void)socketPath;
+    (void)command;
+    cerr << "Daemon mode needs Unix domain sockets, it is not supported on this platform" << endl;
+    return -1;
+#else
+    sockaddr_un address;
+    if (!fillAddress(socketPath, address))
+    {
+        return -1;
+    }
+
+    const int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection < 0)
+    {
+        return -1;
+    }
+
+    if (connect(connection, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        close(connection);
+        return -1;
+    }
+
+    const auto request = command + "\n";
+    if (!writeAll(connection, request.data(), request.size()))
+    {
+        close(connection);
+        return -1;
+    }
+    shutdown(connection, SHUT_WR);
+
+    bool failed = false;
+    bool firstChunk = true;
+    char buffer[64 * 1024];
+    while (true)
+    {
+        const auto received = recv(connection, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (received <= 0)
+        {
+            break;
+        }
+        if (firstChunk && string_view(buffer, static_cast<size_t>(received)).substr(0, 5) == "ERROR")
+        {
+            failed = true;
+        }
+        firstChunk = false;
+        cout.write(buffer, received);
+    }
+    cout.flush();
+    close(connection);
+
+    return failed ? 1 : 0;
+#endif
+}
\ No newline at end of file
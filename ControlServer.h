@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include "LogUtility.h"
+#include "BackupRunner.h"
+/**
+ * @brief Control and query API of daemon mode, served over a local Unix domain socket
+ * Client sends a single command line, response text follows until server closes the connection.
+ * Commands: help, status, metrics, prometheus, print, search <text>, regex <regex>, time <timestamp prefix>,
+ * rescan, stop. Failed commands respond with a line starting with "ERROR".
+ */
+class ControlServer
+{
+public:
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+    ControlServer& operator==(const ControlServer&) = delete;
+    /**
+     * @param log: log answering queries from memory
+     * @param backupRunner: runner woken up by rescan command
+     * @param stopRequested: set by stop command, serve() returns once it is set
+     */
+    ControlServer(const LogUtility& log, const BackupRunner& backupRunner, std::atomic<bool>& stopRequested);
+    ~ControlServer();
+    /**
+     * @brief Create socket, stale socket file of previous run is replaced
+     * @return false: socket could not be created, reason is printed
+     */
+    bool start(const std::filesystem::path& socketPath);
+    /**
+     * @brief Answer clients one after another until stop is requested
+     */
+    void serve();
+    /**
+     * @brief Send command to running daemon and print its response
+     * @return 0: command succeeded, 1: daemon reported an error, -1: daemon is not reachable
+     */
+    static int runClient(const std::filesystem::path& socketPath, const std::string& command);
+private:
+    /**
+     * @brief Execute single command
+     * @param send: receives response text in pieces
+     */
+    void handleCommand(const std::string& commandLine, const std::function<void(const std::string&)>& send) const;
+    void handleConnection(int connection) const;
+    std::string getStatus() const;
+
+    const LogUtility& m_log;
+    const BackupRunner& m_backupRunner;
+    std::atomic<bool>& m_stopRequested;
+    std::filesystem::path m_socketPath;
+    int m_socket;
+    const std::chrono::steady_clock::time_point m_startTime;
+};
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include "Crc32c.h"
+#include <array>
+#include <cstring>
+#include <cstdio>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#define CRC32C_X86 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CRC32C_ARM 1
+#endif
+
+using namespace std;
+
+namespace
+{
+    //reversed Castagnoli polynomial
+    const uint32_t Polynomial = 0x82f63b78;
+
+    /**
+     * @brief Tables for slicing-by-8 software implementation
+     */
+    struct SoftwareTables
+    {
+        SoftwareTables()
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; bit++)
+                {
+                    crc = (crc & 1) ? (crc >> 1) ^ Polynomial : crc >> 1;
+                }
+                table[0][i] = crc;
+            }
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                for (size_t slice = 1; slice < 8; slice++)
+                {
+                    table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xff];
+                }
+            }
+        }
+        array<array<uint32_t, 256>, 8> table;
+    };
+
+    uint32_t softwareUpdate(uint32_t crc, const unsigned char* data, size_t length)
+    {
+        static const SoftwareTables tables;
+        const auto& t = tables.table;
+
+        while (length >= 8)
+        {
+            uint32_t low;
+            uint32_t high;
+            memcpy(&low, data, 4);
+            memcpy(&high, data + 4, 4);
+            low ^= crc;
+            crc = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^
+                t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^ t[0][high >> 24];
+            data += 8;
+            length -= 8;
+        }
+        while (length--)
+        {
+            crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xff];
+        }
+        return crc;
+    }
+
+#ifdef CRC32C_X86
+#ifndef _MSC_VER
+    __attribute__((target("sse4.2")))
+#endif
+    uint32_t hardwareUpdate(uint32_t crc, const unsigned char* data, size_t length)
+    {
+        uint64_t crc64 = crc;
+        while (length >= 8)
+        {
+            uint64_t value;
+            memcpy(&value, data, 8);
+            crc64 = _mm_crc32_u64(crc64, value);
+            data += 8;
+            length -= 8;
+        }
+        crc = static_cast<uint32_t>(crc64);
+        while (length--)
+        {
+            crc = _mm_crc32_u8(crc, *data++);
+        }
+        return crc;
+    }
+
+    bool detectHardware()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 20)) != 0;
+#else
+        return __builtin_cpu_supports("sse4.2");
+#endif
+    }
+#elif defined(CRC32C_ARM)
+    uint32_t hardwareUpdate(uint32_t crc, const unsigned char* data, size_t length)
+    {
+        while (length >= 8)
+        {
+            uint64_t value;
+            memcpy(&value, data, 8);
+            crc = __crc32cd(crc, value);
+            data += 8;
+            length -= 8;
+        }
+        while (length--)
+        {
+            crc = __crc32cb(crc, *data++);
+        }
+        return crc;
+    }
+
+    bool detectHardware()
+    {
+        return true;
+    }
+#else
+    uint32_t hardwareUpdate(uint32_t crc, const unsigned char* data, size_t length)
+    {
+        return softwareUpdate(crc, data, length);
+    }
+
+    bool detectHardware()
+    {
+        return false;
+    }
+#endif
+}
+
+bool Crc32c::isHardwareAccelerated()
+{
+    static const bool hasHardware = detectHardware();
+    return hasHardware;
+}
+
+uint32_t Crc32c::update(uint32_t crc, const void* data, size_t length)
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+
+    crc = ~crc;
+    crc = isHardwareAccelerated() ? hardwareUpdate(crc, bytes, length) : softwareUpdate(crc, bytes, length);
+
+    return ~crc;
+}
+
+uint32_t Crc32c::multiplyModulo(uint32_t a, uint32_t b)
+{
+    //a must not be 0, callers always pass a power of x
+    uint32_t mask = 1u << 31;
+    uint32_t product = 0;
+    while (true)
+    {
+        if (a & mask)
+        {
+            product ^= b;
+            if ((a & (mask - 1)) == 0)
+            {
+                break;
+            }
+        }
+        mask >>= 1;
+        b = (b & 1) ? (b >> 1) ^ Polynomial : b >> 1;
+    }
+    return product;
+}
+
+uint32_t Crc32c::powerOfXModulo(uintmax_t bytes)
+{
+    //squares[k] holds x^(2^k) modulo polynomial
+    static const auto squares = []()
+    {
+        array<uint32_t, 64> table{};
+        uint32_t power = 1u << 30;
+        table[0] = power;
+        for (size_t k = 1; k < table.size(); k++)
+        {
+            power = multiplyModulo(power, power);
+            table[k] = power;
+        }
+        return table;
+    }();
+
+    //x^(8 * bytes), 1 << 31 is x^0 in reflected notation
+    uint32_t power = 1u << 31;
+    size_t k = 3;
+    while (bytes != 0 && k < squares.size())
+    {
+        if (bytes & 1)
+        {
+            power = multiplyModulo(squares[k], power);
+        }
+        bytes >>= 1;
+        k++;
+    }
+    return power;
+}
+
+uint32_t Crc32c::combine(uint32_t firstCrc, uint32_t secondCrc, uintmax_t secondLength)
+{
+    return multiplyModulo(powerOfXModulo(secondLength), firstCrc) ^ secondCrc;
+}
+
+uint32_t Crc32c::zeros(uintmax_t length)
+{
+    return multiplyModulo(powerOfXModulo(length), 0xffffffff) ^ 0xffffffff;
+}
+
+string Crc32c::toString(uint32_t crc)
+{
+    char buffer[9];
+    snprintf(buffer, sizeof buffer, "%08x", crc);
+
+    return buffer;
+}
+
+optional<uint32_t> Crc32c::fromString(const string& text)
+{
+    if (text.size() != 8)
+    {
+        return nullopt;
+    }
+
+    uint32_t crc = 0;
+    for (const char c : text)
+    {
+        crc <<= 4;
+        if (c >= '0' && c <= '9')
+        {
+            crc |= static_cast<uint32_t>(c - '0');
+        }
+        else if (c >= 'a' && c <= 'f')
+        {
+            crc |= static_cast<uint32_t>(c - 'a' + 10);
+        }
+        else
+        {
+            return nullopt;
+        }
+    }
+    return crc;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <optional>
+/**
+ * @brief CRC32C (Castagnoli) checksum
+ * Uses SSE4.2 / ARMv8 crc instructions when CPU has them, table based version otherwise.
+ * Checksums of separate parts of a file can be combined, so ranges copied by
+ * different workers do not have to be read a second time.
+ */
+class Crc32c
+{
+public:
+    /**
+     * @brief Extend checksum with more data
+     * @param crc: checksum of preceding data, 0 for empty
+     * @param data: bytes to add
+     * @param length: amount of bytes
+     * @return checksum of preceding data followed by provided bytes
+     */
+    static std::uint32_t update(std::uint32_t crc, const void* data, std::size_t length);
+    /**
+     * @brief Checksum of two concatenated blocks
+     * @param firstCrc: checksum of first block
+     * @param secondCrc: checksum of second block
+     * @param secondLength: length of second block in bytes
+     */
+    static std::uint32_t combine(std::uint32_t firstCrc, std::uint32_t secondCrc, std::uintmax_t secondLength);
+    /**
+     * @brief Checksum of a block of zeros, used for holes of sparse files
+     */
+    static std::uint32_t zeros(std::uintmax_t length);
+    /**
+     * @return true: hardware instructions are used
+     */
+    static bool isHardwareAccelerated();
+
+    static std::string toString(std::uint32_t crc);
+
+    static std::optional<std::uint32_t> fromString(const std::string& text);
+private:
+    static std::uint32_t multiplyModulo(std::uint32_t a, std::uint32_t b);
+    static std::uint32_t powerOfXModulo(std::uintmax_t bytes);
+};
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "Tests.h"
+#include "Crc32c.h"
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    uint32_t checksumOf(const vector<uint8_t>& data)
+    {
+        return Crc32c::update(0, data.data(), data.size());
+    }
+}
+
+TEST(Crc32cKnownVectors)
+{
+    //check values of RFC 3720 (iSCSI) and the usual "123456789" check value
+    const char* digits = "123456789";
+    CHECK(Crc32c::update(0, digits, strlen(digits)) == 0xE3069283u);
+    CHECK(Crc32c::update(0, digits, 0) == 0u);
+    CHECK(checksumOf(vector<uint8_t>(32, 0x00)) == 0x8A9136AAu);
+    CHECK(checksumOf(vector<uint8_t>(32, 0xFF)) == 0x62A8AB43u);
+
+    vector<uint8_t> ascending(32);
+    iota(ascending.begin(), ascending.end(), uint8_t{0});
+    CHECK(checksumOf(ascending) == 0x46DD794Eu);
+
+    vector<uint8_t> descending(32);
+    iota(descending.rbegin(), descending.rend(), uint8_t{0});
+    CHECK(checksumOf(descending) == 0x113FDB5Cu);
+}
+
+TEST(Crc32cUpdateInPartsAtAnyAlignment)
+{
+    vector<uint8_t> data(4099);
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+    const auto whole = checksumOf(data);
+
+    for (size_t split : {size_t{1}, size_t{3}, size_t{8}, size_t{13}, size_t{1024}, size_t{4098}})
+    {
+        const auto first = Crc32c::update(0, data.data(), split);
+        CHECK(Crc32c::update(first, data.data() + split, data.size() - split) == whole);
+    }
+
+    //unaligned start goes through the same code as aligned data
+    for (size_t offset = 1; offset < 8; offset++)
+    {
+        const vector<uint8_t> shifted(data.begin() + static_cast<ptrdiff_t>(offset), data.end());
+        CHECK(Crc32c::update(0, data.data() + offset, data.size() - offset) == checksumOf(shifted));
+    }
+}
+
+TEST(Crc32cCombineAndZeros)
+{
+    vector<uint8_t> data(10000);
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = static_cast<uint8_t>(i ^ (i >> 8));
+    }
+
+    for (size_t split : {size_t{0}, size_t{1}, size_t{4096}, size_t{9999}})
+    {
+        const auto first = Crc32c::update(0, data.data(), split);
+        const auto second = Crc32c::update(0, data.data() + split, data.size() - split);
+        CHECK(Crc32c::combine(first, second, data.size() - split) == checksumOf(data));
+    }
+
+    for (size_t length : {size_t{0}, size_t{1}, size_t{32}, size_t{65536}})
+    {
+        CHECK(Crc32c::zeros(length) == checksumOf(vector<uint8_t>(length, 0)));
+    }
+}
+
+TEST(Crc32cTextRoundTrip)
+{
+    for (uint32_t crc : {0u, 1u, 0xE3069283u, 0xFFFFFFFFu})
+    {
+        const auto parsed = Crc32c::fromString(Crc32c::toString(crc));
+        CHECK(parsed && *parsed == crc);
+    }
+    CHECK(!Crc32c::fromString("not hex"));
+    CHECK(!Crc32c::fromString(""));
+}
\ No newline at end of file
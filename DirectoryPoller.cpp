@@ -0,0 +1,155 @@
+#include "DirectoryPoller.h"
+#include <algorithm>
+
+using namespace std;
+
+DirectoryPoller::DirectoryPoller(chrono::seconds minInterval, chrono::seconds maxInterval, uint64_t budget):
+    m_minInterval(minInterval),
+    m_maxInterval(max(minInterval, maxInterval)),
+    m_budgetPerSecond(budget),
+    m_folders{},
+    m_lookupKey{},
+    m_passStart{},
+    m_lastPassStart{},
+    m_pass(0),
+    m_scanAll(false),
+    m_budget(0),
+    m_deferredCost(0),
+    m_scannedFolders(0),
+    m_idleFolders(0),
+    m_deferredFolders(0)
+{
+
+}
+
+bool DirectoryPoller::isEnabled() const
+{
+    return m_maxInterval > m_minInterval || m_budgetPerSecond > 0;
+}
+
+void DirectoryPoller::beginPass(bool scanAll)
+{
+    m_passStart = chrono::steady_clock::now();
+    m_pass++;
+    m_scanAll = scanAll;
+    m_scannedFolders = 0;
+    m_idleFolders = 0;
+    m_deferredFolders = 0;
+
+    if (m_budgetPerSecond > 0)
+    {
+        //unused budget does not pile up, overdraft is paid back by next passes
+        const auto elapsed = m_pass == 1 ? chrono::seconds(1) : m_passStart - m_lastPassStart;
+        const auto refill = static_cast<int64_t>(static_cast<double>(m_budgetPerSecond) * chrono::duration<double>(elapsed).count());
+        //folders deferred by previous pass are checked this time anyway, their files are paid for first
+        m_budget = min<int64_t>(m_budget, 0) + refill - m_deferredCost;
+    }
+    m_lastPassStart = m_passStart;
+}
+
+DirectoryPoller::Folder& DirectoryPoller::visitFolder(string_view relativePath, int64_t modificationTime, Decision& decision)
+{
+    //key buffer is reused, known folders are looked up without allocating
+    m_lookupKey.assign(relativePath);
+    auto found = m_folders.find(m_lookupKey);
+    if (found == m_folders.end())
+    {
+        Folder folder;
+        folder.interval = m_minInterval;
+        folder.nextDue = m_passStart;
+        folder.modificationTime = modificationTime;
+        found = m_folders.emplace(m_lookupKey, folder).first;
+    }
+
+    auto& folder = found->second;
+    folder.pass = m_pass;
+
+    if (m_scanAll || folder.modificationTime != modificationTime)
+    {
+        folder.interval = m_minInterval;
+        folder.nextDue = m_passStart;
+    }
+    folder.modificationTime = modificationTime;
+
+    folder.scanned = folder.nextDue <= m_passStart;
+    if (folder.scanned && m_budgetPerSecond > 0 && m_budget <= 0 && !folder.deferred && !m_scanAll)
+    {
+        folder.scanned = false;
+        folder.deferred = true;
+        m_deferredFolders++;
+    }
+
+    if (folder.scanned)
+    {
+        m_budget -= static_cast<int64_t>(folder.fileCount);
+        folder.deferred = false;
+        folder.changedFiles = 0;
+        m_scannedFolders++;
+        decision = Decision::Scan;
+    }
+    else
+    {
+        m_idleFolders++;
+        //adding a subfolder changes modification time, so a folder without them has nothing to be listed for
+        decision = folder.subfolderCount > 0 ? Decision::List : Decision::Skip;
+    }
+
+    if (decision != Decision::Skip)
+    {
+        folder.fileCount = 0;
+        folder.subfolderCount = 0;
+    }
+
+    return folder;
+}
+
+void DirectoryPoller::countEntry(Folder& folder, bool isDirectory) const
+{
+    (isDirectory ? folder.subfolderCount : folder.fileCount)++;
+}
+
+void DirectoryPoller::countChange(Folder& folder) const
+{
+    folder.changedFiles++;
+}
+
+void DirectoryPoller::endPass()
+{
+    m_deferredCost = 0;
+
+    for (auto it = m_folders.begin(); it != m_folders.end();)
+    {
+        auto& folder = it->second;
+        if (folder.pass != m_pass)
+        {
+            it = m_folders.erase(it);
+            continue;
+        }
+
+        if (folder.scanned)
+        {
+            folder.interval = folder.changedFiles > 0 ? m_minInterval : min(folder.interval * 2, m_maxInterval);
+            folder.nextDue = m_passStart + folder.interval;
+        }
+        if (folder.deferred)
+        {
+            m_deferredCost += static_cast<int64_t>(folder.fileCount);
+        }
+        ++it;
+    }
+}
+
+uint64_t DirectoryPoller::getScannedFolders() const
+{
+    return m_scannedFolders;
+}
+
+uint64_t DirectoryPoller::getIdleFolders() const
+{
+    return m_idleFolders;
+}
+
+uint64_t DirectoryPoller::getDeferredFolders() const
+{
+    return m_deferredFolders;
+}
\ No newline at end of file
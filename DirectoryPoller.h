@@ -0,0 +1,104 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+/**
+ * @brief Decides which folders a pass checks file by file, for file systems where changes can only be found by polling
+ * Folder where a pass found a change is checked again on every pass, quiet folder is checked half as often after every
+ * quiet check, up to max interval. Folder whose modification time changed (entries added, removed or renamed) is due
+ * right away. Quiet folders without subfolders are not even listed.
+ * Optional budget limits file checks per second, due folders over budget are deferred, but never for more than one pass.
+ * Used by a single thread.
+ */
+class DirectoryPoller
+{
+public:
+    /**
+     * @brief What a pass does with a folder
+     * Scan: list it and check its files, List: list it only to reach subfolders, Skip: do not descend into it
+     */
+    enum class Decision
+    {
+        Scan,
+        List,
+        Skip
+    };
+    /**
+     * @brief Polling state of a folder
+     */
+    struct Folder
+    {
+        std::chrono::steady_clock::duration interval{};
+        std::chrono::steady_clock::time_point nextDue{};
+        std::int64_t modificationTime = 0;
+        std::uint64_t pass = 0;
+        std::uint64_t fileCount = 0;
+        std::uint64_t subfolderCount = 0;
+        std::uint64_t changedFiles = 0;
+        bool scanned = false;
+        bool deferred = false;
+    };
+
+    DirectoryPoller(const DirectoryPoller&) = delete;
+    DirectoryPoller& operator=(const DirectoryPoller&) = delete;
+    DirectoryPoller& operator==(const DirectoryPoller&) = delete;
+    /**
+     * @param minInterval: interval of folders with changes, time between passes
+     * @param maxInterval: longest interval of a quiet folder, not above minInterval disables backing off
+     * @param budget: file checks per second, 0 for unlimited
+     */
+    DirectoryPoller(std::chrono::seconds minInterval, std::chrono::seconds maxInterval, std::uint64_t budget);
+    /**
+     * @brief false: every folder is checked on every pass, there is no need to ask the poller
+     */
+    bool isEnabled() const;
+    /**
+     * @param scanAll: every folder is due this pass, for example on rescan request
+     */
+    void beginPass(bool scanAll);
+    /**
+     * @brief Called for every folder the pass reaches, root included with empty path
+     * @param modificationTime: folder modification time, any unit, only compared to previous one
+     * @return state of folder, valid till endPass
+     */
+    Folder& visitFolder(std::string_view relativePath, std::int64_t modificationTime, Decision& decision);
+    /**
+     * @brief Count an entry listed in folder
+     */
+    void countEntry(Folder& folder, bool isDirectory) const;
+    /**
+     * @brief Count a file of folder which needs backup, keeps folder checked on every pass
+     */
+    void countChange(Folder& folder) const;
+    /**
+     * @brief Schedules next check of every folder checked by the pass, forgets folders the pass did not reach
+     * Not called for interrupted passes.
+     */
+    void endPass();
+
+    std::uint64_t getScannedFolders() const;
+    /**
+     * @brief Folders which were reached but not checked, deferred ones included
+     */
+    std::uint64_t getIdleFolders() const;
+
+    std::uint64_t getDeferredFolders() const;
+private:
+    const std::chrono::steady_clock::duration m_minInterval;
+    const std::chrono::steady_clock::duration m_maxInterval;
+    const std::uint64_t m_budgetPerSecond;
+    std::unordered_map<std::string, Folder> m_folders;
+    std::string m_lookupKey;
+    std::chrono::steady_clock::time_point m_passStart;
+    std::chrono::steady_clock::time_point m_lastPassStart;
+    std::uint64_t m_pass;
+    bool m_scanAll;
+    std::int64_t m_budget;
+    std::int64_t m_deferredCost;
+    std::uint64_t m_scannedFolders;
+    std::uint64_t m_idleFolders;
+    std::uint64_t m_deferredFolders;
+};
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "Tests.h"
+#include "DirectoryPoller.h"
+#include <thread>
+
+using namespace std;
+
+namespace
+{
+    using Decision = DirectoryPoller::Decision;
+    /**
+     * @brief Visit folder and count its entries like a pass which lists it does
+     */
+    Decision visit(DirectoryPoller& poller, string_view path, int64_t modificationTime, uint64_t files,
+        uint64_t subfolders, bool changed = false)
+    {
+        Decision decision;
+        auto& folder = poller.visitFolder(path, modificationTime, decision);
+        if (decision != Decision::Skip)
+        {
+            for (uint64_t i = 0; i < files; i++)
+            {
+                poller.countEntry(folder, false);
+            }
+            for (uint64_t i = 0; i < subfolders; i++)
+            {
+                poller.countEntry(folder, true);
+            }
+        }
+        if (decision == Decision::Scan && changed)
+        {
+            poller.countChange(folder);
+        }
+        return decision;
+    }
+}
+
+TEST(DirectoryPollerSkipsQuietFolders)
+{
+    DirectoryPoller poller(chrono::seconds(1), chrono::seconds(60), 0);
+    CHECK(poller.isEnabled());
+
+    //new folders are scanned
+    poller.beginPass(false);
+    CHECK(visit(poller, "", 1, 2, 1) == Decision::Scan);
+    CHECK(visit(poller, "leaf", 1, 5, 0) == Decision::Scan);
+    CHECK(visit(poller, "gone", 1, 5, 0) == Decision::Scan);
+    poller.endPass();
+    CHECK(poller.getScannedFolders() == 3 && poller.getIdleFolders() == 0);
+
+    //quiet folders are not due yet, folder with subfolders is only listed to reach them
+    poller.beginPass(false);
+    CHECK(visit(poller, "", 1, 2, 1) == Decision::List);
+    CHECK(visit(poller, "leaf", 1, 5, 0) == Decision::Skip);
+    poller.endPass();
+    CHECK(poller.getScannedFolders() == 0 && poller.getIdleFolders() == 2);
+
+    //changed modification time makes folder due, folder the previous pass did not reach is new again
+    poller.beginPass(false);
+    CHECK(visit(poller, "", 1, 2, 1) == Decision::List);
+    CHECK(visit(poller, "leaf", 2, 6, 0) == Decision::Scan);
+    CHECK(visit(poller, "gone", 1, 5, 0) == Decision::Scan);
+    poller.endPass();
+
+    poller.beginPass(true);
+    CHECK(visit(poller, "", 1, 2, 1) == Decision::Scan);
+    CHECK(visit(poller, "leaf", 2, 6, 0) == Decision::Scan);
+    poller.endPass();
+}
+
+TEST(DirectoryPollerChecksChangedFoldersMoreOften)
+{
+    DirectoryPoller poller(chrono::seconds(1), chrono::seconds(60), 0);
+    poller.beginPass(false);
+    CHECK(visit(poller, "busy", 1, 3, 0, true) == Decision::Scan);
+    CHECK(visit(poller, "quiet", 1, 3, 0) == Decision::Scan);
+    poller.endPass();
+
+    //folder with a change is due after min interval, quiet one backed off to twice as long
+    this_thread::sleep_for(chrono::milliseconds(1100));
+    poller.beginPass(false);
+    CHECK(visit(poller, "busy", 1, 3, 0) == Decision::Scan);
+    CHECK(visit(poller, "quiet", 1, 3, 0) == Decision::Skip);
+    poller.endPass();
+}
+
+TEST(DirectoryPollerDefersFoldersOverBudget)
+{
+    DirectoryPoller poller(chrono::seconds(1), chrono::seconds(1), 10);
+    CHECK(poller.isEnabled());
+
+    poller.beginPass(false);
+    for (const auto* path : {"a", "b", "c"})
+    {
+        CHECK(visit(poller, path, 1, 20, 0) == Decision::Scan);
+    }
+    poller.endPass();
+
+    //budget of the first second is spent, changed folders wait
+    poller.beginPass(false);
+    for (const auto* path : {"a", "b", "c"})
+    {
+        CHECK(visit(poller, path, 2, 20, 0) == Decision::Skip);
+    }
+    poller.endPass();
+    CHECK(poller.getDeferredFolders() == 3);
+
+    //but never for more than one pass
+    poller.beginPass(false);
+    for (const auto* path : {"a", "b", "c"})
+    {
+        CHECK(visit(poller, path, 2, 20, 0) == Decision::Scan);
+    }
+    poller.endPass();
+    CHECK(poller.getDeferredFolders() == 0 && poller.getScannedFolders() == 3);
+
+    DirectoryPoller disabled(chrono::seconds(1), chrono::seconds(1), 0);
+    CHECK(!disabled.isEnabled());
+}
\ No newline at end of file
@@ -0,0 +1,323 @@
+#include "DirectoryWalker.h"
+#include "NativeFileSystem.h"
+#include <iostream>
+#include <cstring>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+#ifdef __linux__
+
+DirectoryWalker::DirectoryWalker(const fs::path& root, pmr::memory_resource* memory):
+    m_root(root),
+    m_recursionPending(false),
+    m_openFailed(false),
+    m_incomplete(false),
+    m_frames(memory),
+    m_relativePath(memory),
+    m_name{},
+    m_entryDescriptor(-1),
+    m_isDirectory(false),
+    m_isRealDirectory(false),
+    m_isRegularFile(false)
+{
+    m_frames.reserve(32);
+    m_relativePath.reserve(256);
+    m_incomplete = !openDirectory(AT_FDCWD, m_root.c_str(), 0);
+}
+
+DirectoryWalker::~DirectoryWalker()
+{
+    for (auto& frame : m_frames)
+    {
+        closedir(frame.directory);
+    }
+}
+
+bool DirectoryWalker::openDirectory(int parentDescriptor, const char* name, size_t relativeLength)
+{
+    //folders inside root are opened relative to their parent, symlinked folders are not followed
+    const int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC | (parentDescriptor == AT_FDCWD ? 0 : O_NOFOLLOW);
+    const int descriptor = openat(parentDescriptor, name, flags);
+    DIR* directory = descriptor >= 0 ? fdopendir(descriptor) : nullptr;
+
+    if (!directory)
+    {
+        if (descriptor >= 0)
+        {
+            close(descriptor);
+        }
+        //missing root is noticed by the caller, there is nothing to walk through
+        if (parentDescriptor != AT_FDCWD)
+        {
+            cerr << "Unable to open folder " << getPath().string() << " - Due to Error: " << strerror(errno) << "\n";
+        }
+        return false;
+    }
+
+    m_frames.push_back(Frame{directory, relativeLength});
+    return true;
+}
+
+void DirectoryWalker::resolveType(const dirent& entry)
+{
+    m_isDirectory = false;
+    m_isRealDirectory = false;
+    m_isRegularFile = false;
+
+    struct stat status;
+    switch (entry.d_type)
+    {
+    case DT_DIR:
+        m_isDirectory = true;
+        m_isRealDirectory = true;
+        return;
+    case DT_REG:
+        m_isRegularFile = true;
+        return;
+    case DT_LNK:
+        break;
+    case DT_UNKNOWN:
+        //some file systems do not fill in the type
+        if (fstatat(m_entryDescriptor, entry.d_name, &status, AT_SYMLINK_NOFOLLOW) != 0)
+        {
+            return;
+        }
+        if (!S_ISLNK(status.st_mode))
+        {
+            m_isDirectory = S_ISDIR(status.st_mode);
+            m_isRealDirectory = m_isDirectory;
+            m_isRegularFile = S_ISREG(status.st_mode);
+            return;
+        }
+        break;
+    default:
+        return;
+    }
+
+    if (fstatat(m_entryDescriptor, entry.d_name, &status, 0) == 0)
+    {
+        m_isDirectory = S_ISDIR(status.st_mode);
+        m_isRegularFile = S_ISREG(status.st_mode);
+    }
+}
+
+bool DirectoryWalker::next()
+{
+    m_openFailed = false;
+    if (m_recursionPending && m_isRealDirectory && !m_frames.empty())
+    {
+        //name still points into the dirent of the parent, which is valid till next readdir
+        m_openFailed = !openDirectory(m_entryDescriptor, m_name.data(), m_relativePath.size());
+    }
+    m_recursionPending = false;
+
+    while (!m_frames.empty())
+    {
+        auto& frame = m_frames.back();
+        const dirent* entry = readdir(frame.directory);
+        if (!entry)
+        {
+            closedir(frame.directory);
+            m_frames.pop_back();
+            continue;
+        }
+
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+
+        m_name = entry->d_name;
+        m_relativePath.resize(frame.relativeLength);
+        if (frame.relativeLength > 0)
+        {
+            m_relativePath.push_back('/');
+        }
+        m_relativePath.append(m_name);
+        m_entryDescriptor = dirfd(frame.directory);
+        resolveType(*entry);
+        m_recursionPending = true;
+
+        return true;
+    }
+
+    return false;
+}
+
+void DirectoryWalker::disableRecursionPending()
+{
+    m_recursionPending = false;
+}
+
+string_view DirectoryWalker::getName() const
+{
+    return m_name;
+}
+
+string_view DirectoryWalker::getRelativePath() const
+{
+    return m_relativePath;
+}
+
+size_t DirectoryWalker::getDepth() const
+{
+    return m_frames.empty() ? 0 : m_frames.size() - 1;
+}
+
+bool DirectoryWalker::isDirectory() const
+{
+    return m_isDirectory;
+}
+
+bool DirectoryWalker::isRegularFile() const
+{
+    return m_isRegularFile;
+}
+
+bool DirectoryWalker::getStatus(FileSystem::Status& status) const
+{
+    struct stat entryStatus;
+    if (fstatat(m_entryDescriptor, m_name.data(), &entryStatus, 0) != 0)
+    {
+        return false;
+    }
+    NativeFileSystem::toStatus(entryStatus, status);
+
+    return true;
+}
+
+fs::path DirectoryWalker::getPath() const
+{
+    return m_root / fs::path(string_view(m_relativePath));
+}
+
+bool DirectoryWalker::hasOpenFailed() const
+{
+    return m_openFailed;
+}
+
+bool DirectoryWalker::isIncomplete() const
+{
+    return m_incomplete;
+}
+
+#else
+
+DirectoryWalker::DirectoryWalker(const fs::path& root, pmr::memory_resource*):
+    m_root(root),
+    m_recursionPending(false),
+    m_openFailed(false),
+    m_incomplete(false),
+    m_iterator{},
+    m_started(false),
+    m_name{},
+    m_relativePath{}
+{
+    error_code ec;
+    m_iterator = fs::recursive_directory_iterator(m_root, ec);
+    m_incomplete = static_cast<bool>(ec);
+}
+
+DirectoryWalker::~DirectoryWalker()
+{
+
+}
+
+bool DirectoryWalker::next()
+{
+    error_code ec;
+    m_openFailed = false;
+    if (m_started && m_iterator != fs::recursive_directory_iterator())
+    {
+        //iterator can not step over a folder it fails to open, so folders are tried before descending into them
+        if (m_iterator.recursion_pending() && m_iterator->is_directory(ec) && !m_iterator->is_symlink(ec))
+        {
+            fs::directory_iterator folder(m_iterator->path(), ec);
+            if (ec)
+            {
+                cerr << "Unable to open folder " << m_iterator->path().string() << " - Due to Error: " << ec.message() << "\n";
+                m_iterator.disable_recursion_pending();
+                m_openFailed = true;
+            }
+        }
+        m_iterator.increment(ec);
+    }
+    m_started = true;
+
+    if (ec)
+    {
+        cerr << "Unable to list folder " << m_root.string() << " - Due to Error: " << ec.message() << "\n";
+        m_incomplete = true;
+        return false;
+    }
+    if (m_iterator == fs::recursive_directory_iterator())
+    {
+        return false;
+    }
+
+    m_name = m_iterator->path().filename().string();
+    m_relativePath = m_iterator->path().lexically_relative(m_root).generic_string();
+
+    return true;
+}
+
+void DirectoryWalker::disableRecursionPending()
+{
+    m_iterator.disable_recursion_pending();
+}
+
+string_view DirectoryWalker::getName() const
+{
+    return m_name;
+}
+
+string_view DirectoryWalker::getRelativePath() const
+{
+    return m_relativePath;
+}
+
+size_t DirectoryWalker::getDepth() const
+{
+    return static_cast<size_t>(m_iterator.depth());
+}
+
+bool DirectoryWalker::isDirectory() const
+{
+    error_code ec;
+    return m_iterator->is_directory(ec);
+}
+
+bool DirectoryWalker::isRegularFile() const
+{
+    error_code ec;
+    return m_iterator->is_regular_file(ec);
+}
+
+fs::path DirectoryWalker::getPath() const
+{
+    return m_iterator->path();
+}
+
+bool DirectoryWalker::getStatus(FileSystem::Status& status) const
+{
+    error_code ec;
+    return NativeFileSystem::getInstance().getStatus(m_iterator->path(), status, ec);
+}
+
+bool DirectoryWalker::hasOpenFailed() const
+{
+    return m_openFailed;
+}
+
+bool DirectoryWalker::isIncomplete() const
+{
+    return m_incomplete;
+}
+
+#endif
\ No newline at end of file
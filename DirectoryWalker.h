@@ -0,0 +1,105 @@
+#pragma once
+
+#include <filesystem>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "FileSystem.h"
+
+#ifdef __linux__
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+/**
+ * @brief Depth-first walk through a folder tree, visits entries in the same order as recursive_directory_iterator
+ * On Linux folders are read with openat/readdir relative to their parent, names and paths are kept in
+ * buffers from the given memory resource, so visiting an entry does not allocate once buffers have grown.
+ * Other platforms wrap recursive_directory_iterator. Folder symlinks are listed but not descended into.
+ * Walker of NativeFileSystem.
+ */
+class DirectoryWalker : public FileSystem::Walker
+{
+public:
+    DirectoryWalker(const DirectoryWalker&) = delete;
+    DirectoryWalker& operator=(const DirectoryWalker&) = delete;
+    DirectoryWalker& operator==(const DirectoryWalker&) = delete;
+    /**
+     * @param root: folder to walk through, it is not visited itself
+     * @param memory: resource for internal buffers, for example a per pass arena
+     */
+    DirectoryWalker(const std::filesystem::path& root, std::pmr::memory_resource* memory);
+    ~DirectoryWalker() override;
+    /**
+     * @brief Move to next entry, contents of a folder follow right after it unless disableRecursionPending is called
+     * Folders which can not be opened are reported and skipped, see hasOpenFailed.
+     * @return false: no more entries
+     */
+    bool next() override;
+    /**
+     * @brief Do not descend into current folder
+     */
+    void disableRecursionPending() override;
+    /**
+     * @brief File or folder name of current entry
+     */
+    std::string_view getName() const override;
+    /**
+     * @brief Path of current entry relative to root with '/' separators
+     */
+    std::string_view getRelativePath() const override;
+    /**
+     * @brief 0 for entries directly in root
+     */
+    std::size_t getDepth() const override;
+    /**
+     * @brief Symlinks are resolved
+     */
+    bool isDirectory() const override;
+
+    bool isRegularFile() const override;
+    /**
+     * @brief Full path of current entry, allocates
+     */
+    std::filesystem::path getPath() const override;
+    /**
+     * @brief Status of current entry, symlinks are resolved
+     * @return false: entry vanished or is not accessible
+     */
+    bool getStatus(FileSystem::Status& status) const override;
+
+    bool hasOpenFailed() const override;
+
+    bool isIncomplete() const override;
+private:
+    std::filesystem::path m_root;
+    bool m_recursionPending;
+    bool m_openFailed;
+    bool m_incomplete;
+#ifdef __linux__
+    /**
+     * @brief Open folder and length of its relative path
+     */
+    struct Frame
+    {
+        DIR* directory;
+        std::size_t relativeLength;
+    };
+
+    bool openDirectory(int parentDescriptor, const char* name, std::size_t relativeLength);
+    void resolveType(const dirent& entry);
+
+    std::pmr::vector<Frame> m_frames;
+    std::pmr::string m_relativePath;
+    std::string_view m_name;
+    int m_entryDescriptor;
+    bool m_isDirectory;
+    bool m_isRealDirectory;
+    bool m_isRegularFile;
+#else
+    std::filesystem::recursive_directory_iterator m_iterator;
+    bool m_started;
+    std::string m_name;
+    std::string m_relativePath;
+#endif
+};
\ No newline at end of file
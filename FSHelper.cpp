@@ -1,22 +1,61 @@
 #include "FSHelper.h"
 #include <iostream>
 #include "GlobalData.h"
+#include "NativeFileSystem.h"
+#include "Metrics.h"
+#include "Tracer.h"
+#include "Crc32c.h"
 #include <chrono>
 #include <thread>
 #include <string>
+#include <string_view>
+#include <fstream>
+#include <memory_resource>
 
 using namespace std;
 namespace fs = std::filesystem;
 //#define DEBUG 1; //uncomment for extended output
-void FSHelper::debugLog(string& logLine) const
+
+namespace
+{
+    /**
+     * @brief Compares file name with delete prefix without copying it out of the path
+     */
+    template <typename Character>
+    bool startsWithDeletePrefix(basic_string_view<Character> fileName)
+    {
+        const auto& deletePrefix = GlobalData::getInstance().getDeletePrefix();
+        if (fileName.size() < deletePrefix.size())
+        {
+            return false;
+        }
+        return equal(deletePrefix.begin(), deletePrefix.end(), fileName.begin(),
+            [](char prefixCharacter, Character nameCharacter) { return static_cast<Character>(prefixCharacter) == nameCharacter; });
+    }
+}
+void FSHelper::debugLog(const function<string()>& logLine) const
 {
 #ifdef DEBUG
-    cout<<logLine<<"\n";
+    cout<<logLine()<<"\n";
+#else
+    (void)logLine;
 #endif
 }
 
 FSHelper::FSHelper(LogUtility::LogWriter& logWriter):
-    m_logWriter(logWriter)
+    FSHelper(logWriter, NativeFileSystem::getInstance())
+{
+
+}
+
+FSHelper::FSHelper(LogUtility::LogWriter& logWriter, const FileSystem& fileSystem):
+    m_logWriter(logWriter),
+    m_fileSystem(fileSystem),
+    m_copiedLogicalBytes{0},
+    m_copiedPhysicalBytes{0},
+    m_checksumStore(),
+    m_packStore(),
+    m_startTime(fs::file_time_type::clock::now())
 {
 
 }
@@ -28,7 +67,7 @@ FSHelper::~FSHelper()
 
 bool FSHelper::initEnvironment() const
 {
-    const auto& gd = GlobalData::getInstance();
+    auto& gd = GlobalData::getInstance();
 
     if (!checkIfFolderExists(gd.getHotFolderDir()))
     {
@@ -50,19 +89,176 @@ bool FSHelper::initEnvironment() const
         return false;
     }
 
+    m_checksumStore.load(gd.getBackupFolderPath() / gd.getChecksumFileName());
+    m_packStore.load(gd.getBackupFolderPath());
+
+    return true;
+}
+
+const ChecksumStore& FSHelper::getChecksumStore() const
+{
+    return m_checksumStore;
+}
+
+const PackStore& FSHelper::getPackStore() const
+{
+    return m_packStore;
+}
+
+const FileSystem& FSHelper::getFileSystem() const
+{
+    return m_fileSystem;
+}
+
+void FSHelper::flushPacks() const
+{
+    TraceSpan span("flushPacks");
+
+    if (!m_packStore.flush())
+    {
+        Metrics::getInstance().countError(Metrics::ErrorCategory::Copy);
+    }
+}
+
+void FSHelper::maintainPacks() const
+{
+    TraceSpan span("maintainPacks");
+
+    m_packStore.maintain();
+}
+
+FileCopier::CopyStats FSHelper::getCopyTotals() const
+{
+    FileCopier::CopyStats totals;
+    totals.logicalBytes = m_copiedLogicalBytes.load();
+    totals.physicalBytes = m_copiedPhysicalBytes.load();
+
+    return totals;
+}
+
+void FSHelper::getBackupNames(vector<string>& backupNames) const
+{
+    TraceSpan span("getBackupNames");
+
+    auto& gd = GlobalData::getInstance();
+    const auto extension = gd.getBackupExtension().string();
+
+    pmr::monotonic_buffer_resource memory;
+    const auto walker = m_fileSystem.walk(gd.getBackupFolderPath(), &memory);
+    while (walker->next())
+    {
+        //quarantine folder is not part of the backup set
+        if (walker->isDirectory())
+        {
+            walker->disableRecursionPending();
+            continue;
+        }
+
+        const auto name = walker->getName();
+        if (walker->isRegularFile() && name.size() > extension.size() &&
+            name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+        {
+            backupNames.emplace_back(name);
+        }
+    }
+
+    for (const auto& packed : m_packStore.getAll())
+    {
+        backupNames.push_back(packed.first);
+    }
+}
+
+bool FSHelper::removeOrphan(const string& backupName, bool quarantine) const
+{
+    TraceSpan span("removeOrphan");
+
+    auto& gd = GlobalData::getInstance();
+    const auto backupPath = gd.getBackupFolderPath() / backupName;
+    const auto quarantinePath = gd.getBackupFolderPath() / gd.getQuarantineFolderName() / backupName;
+
+    FileSystem::Status status;
+    error_code ec;
+    const bool ownBackup = m_fileSystem.getStatus(backupPath, status, ec) && status.type == FileSystem::FileType::Regular;
+    const auto packed = m_packStore.get(backupName);
+    if (!ownBackup && !packed)
+    {
+        return false;
+    }
+
+    if (quarantine)
+    {
+        m_fileSystem.createDirectories(quarantinePath.parent_path(), ec);
+        errorCodeHandler(Metrics::ErrorCategory::CreateDirectory, [&]() { return quarantinePath.parent_path().string() + " could not be created"; }, ec);
+        if (ec)
+        {
+            return false;
+        }
+    }
+
+    if (ownBackup && quarantine)
+    {
+        m_fileSystem.rename(backupPath, quarantinePath, ec);
+        errorCodeHandler(Metrics::ErrorCategory::Delete, [&]() { return "Failed to quarantine file: " + backupPath.string(); }, ec);
+        if (ec)
+        {
+            return false;
+        }
+        m_logWriter.addMessageToLog(backupPath.string(), quarantinePath.string(), LogUtility::Action::Move);
+    }
+    else if (ownBackup && !removeFile(backupPath))
+    {
+        return false;
+    }
+
+    if (packed)
+    {
+        //packs are files of the machine, so is the file written out of them
+        if (quarantine && !ownBackup)
+        {
+            thread_local string content;
+            if (!m_packStore.read(*packed, content, ec))
+            {
+                errorCodeHandler(Metrics::ErrorCategory::Copy, [&]() { return backupName + " was not read from its pack"; }, ec);
+                return false;
+            }
+            ofstream quarantineFile(quarantinePath, ios::binary | ios::trunc);
+            quarantineFile.write(content.data(), static_cast<streamsize>(content.size()));
+            quarantineFile.close();
+            if (!quarantineFile)
+            {
+                errorCodeHandler(Metrics::ErrorCategory::Copy, [&]() { return quarantinePath.string() + " was not written"; },
+                    make_error_code(errc::io_error));
+                return false;
+            }
+            FileTime::setModificationTime(quarantinePath, packed->lastWriteTime);
+            m_logWriter.addMessageToLog(m_packStore.getPackPath(packed->pack).string(), quarantinePath.string(), LogUtility::Action::Move);
+        }
+        else if (!ownBackup)
+        {
+            m_logWriter.addMessageToLog(backupPath.string(), LogUtility::Action::Delete);
+            Metrics::getInstance().increment(Metrics::Counter::FilesDeleted);
+        }
+        m_packStore.remove(backupName);
+    }
+
+    m_checksumStore.remove(backupName);
+    Metrics::getInstance().increment(quarantine ? Metrics::Counter::OrphansQuarantined : Metrics::Counter::OrphansRemoved);
+
     return true;
 }
 
 bool FSHelper::checkIfFileExists(const fs::directory_entry& dir) const
 {
-    GlobalData::getInstance().updatePaths();
-    return dir.exists() && dir.is_regular_file();
+    FileSystem::Status status;
+    error_code ec;
+    return m_fileSystem.getStatus(dir.path(), status, ec) && status.type == FileSystem::FileType::Regular;
 }
 
 bool FSHelper::checkIfFolderExists(const fs::directory_entry& dir) const
 {
-    GlobalData::getInstance().updatePaths();
-    return dir.exists() && dir.is_directory();
+    FileSystem::Status status;
+    error_code ec;
+    return m_fileSystem.getStatus(dir.path(), status, ec) && status.type == FileSystem::FileType::Directory;
 }
 
 bool FSHelper::waitForDirectoryCreation(const fs::directory_entry& dir) const
@@ -90,11 +286,11 @@ bool FSHelper::checkIfFolderExistsOrCreate(const fs::directory_entry& dir) const
 
     error_code ec;
 
-    fs::create_directories(dir.path(), ec);
+    m_fileSystem.createDirectories(dir.path(), ec);
 
     if (ec) 
     {
-        errorCodeHandler("Unable to create 'backup' dir" + dir.path().string(), ec);
+        errorCodeHandler(Metrics::ErrorCategory::CreateDirectory, [&]() { return "Unable to create 'backup' dir" + dir.path().string(); }, ec);
         return false;
     }
 
@@ -111,242 +307,377 @@ void FSHelper::setPermissions(const fs::directory_entry& dir) const
 {
     error_code ec;
 
-    fs::permissions(dir, fs::perms::all, fs::perm_options::replace, ec);
+    m_fileSystem.setPermissions(dir.path(), ec);
 
-    errorCodeHandler(dir.path().string() + " permission were not applied'", ec);
+    errorCodeHandler(Metrics::ErrorCategory::Permissions, [&]() { return dir.path().string() + " permission were not applied'"; }, ec);
 }
 
-bool FSHelper::doesHotFileNeedToBeDeleted(const fs::directory_entry& fileToBackup) const
+bool FSHelper::doesHotFileNeedToBeDeleted(const fs::path& fileToBackup) const
 {
-    if (!fileToBackup.is_regular_file())
+    //name starting with the prefix has a stem starting with it as well, prefix holds no '.'
+    const basic_string_view<fs::path::value_type> path{fileToBackup.native()};
+#ifdef _WIN32
+    const auto nameStart = path.find_last_of(L"\\/");
+#else
+    const auto nameStart = path.find_last_of('/');
+#endif
+    const auto fileName = nameStart == path.npos ? path : path.substr(nameStart + 1);
+
+    return startsWithDeletePrefix(fileName);
+}
+
+void FSHelper::deleteBackupFile(string sourceFilename) const
+{
+    auto& gd = GlobalData::getInstance();
+    gd.updatePaths();
+
+
+    if (sourceFilename.size() <= gd.getDeletePrefixSize())
     {
-        string log = fileToBackup.path().string() + " is not a file skipping";
-        debugLog(log);
-        return false;
+        debugLog([&]() { return sourceFilename + " source file name too short could not find backup"; });
+        return;
     }
 
-    if (!fileToBackup.path().has_filename())
+    sourceFilename.erase(sourceFilename.begin(), sourceFilename.begin() + gd.getDeletePrefixSize());
+
+    auto backUpToDelete = gd.getBackupFolderPath();
+    backUpToDelete /= sourceFilename;
+    backUpToDelete += gd.getBackupExtension();
+
+    removeFile(backUpToDelete);
+    m_checksumStore.remove(backUpToDelete.filename().string());
+
+    if (m_packStore.remove(backUpToDelete.filename().string()))
     {
-        return false;
+        m_logWriter.addMessageToLog(backUpToDelete.string(), LogUtility::Action::Delete);
+        Metrics::getInstance().increment(Metrics::Counter::FilesDeleted);
     }
+}
 
-    if (!fileToBackup.path().has_stem())
+void FSHelper::backupSingleFile(const FileSystem::Walker& entry) const
+{
+    if (needsBackup(entry))
     {
-        return false;
+        backupSingleFile(entry.getPath());
     }
+}
 
-    const auto fileStem = fileToBackup.path().stem().string();
-
-    auto& gd = GlobalData::getInstance();
-    const auto deletePrefixSize = gd.getDeletePrefixSize();
-
-    if (fileStem.size() < deletePrefixSize)
+bool FSHelper::needsBackup(const FileSystem::Walker& entry) const
+{
+    if (!entry.isRegularFile())
     {
+        debugLog([&]() { return string(entry.getRelativePath()) + " is not a file skipping"; });
         return false;
     }
 
-    const auto& deletePrefix = gd.getDeletePrefix();
-
-    auto cmp = deletePrefix.compare(0, deletePrefixSize, fileStem, 0, deletePrefixSize);
+    if (!startsWithDeletePrefix(entry.getName()) && isBackupUpToDate(entry))
+    {
+        Metrics::getInstance().increment(Metrics::Counter::FilesSkipped);
+        return false;
+    }
 
-    return cmp == 0;
+    return true;
 }
 
-void FSHelper::deleteBackupFile(string sourceFilename) const
+bool FSHelper::isBackupUpToDate(const FileSystem::Walker& entry) const
 {
-    auto& gd = GlobalData::getInstance();
-    gd.updatePaths();
+    TraceSpan span("isBackupUpToDate");
 
+    FileSystem::Status source;
+    if (!entry.getStatus(source))
+    {
+        return false;
+    }
 
-    if (sourceFilename.size() <= gd.getDeletePrefixSize())
+    //same checks as fileDoesNotExistOrNeedsUpdate, done on reused buffers instead of paths
+    auto& gd = GlobalData::getInstance();
+    thread_local fs::path::string_type backupFolder;
+    thread_local string backupFolderPrefix;
+    thread_local string backupExtension;
+    if (backupFolderPrefix.empty() || gd.getBackupFolderPath().native() != backupFolder)
     {
-        string log = sourceFilename + " source file name too short could not find backup";
-        debugLog(log);
-        return;
+        backupFolder = gd.getBackupFolderPath().native();
+        backupFolderPrefix = gd.getBackupFolderPath().u8string();
+        const auto separator = static_cast<char>(fs::path::preferred_separator);
+        if (!backupFolderPrefix.empty() && backupFolderPrefix.back() != '/' && backupFolderPrefix.back() != separator)
+        {
+            backupFolderPrefix.push_back(separator);
+        }
+        backupExtension = gd.getBackupExtension().u8string();
     }
 
-    sourceFilename.erase(sourceFilename.begin(), sourceFilename.begin() + gd.getDeletePrefixSize());
+    thread_local string backupPath;
+    backupPath.assign(backupFolderPrefix);
+    backupPath.append(entry.getName());
+    backupPath.append(backupExtension);
 
-    auto backUpToDelete = gd.getBackupFolderPath();
-    backUpToDelete /= sourceFilename;
-    backUpToDelete += gd.getBackupExtension();
+    FileSystem::Status backup;
+    error_code ec;
+    if (!m_fileSystem.getStatus(backupPath, backup, ec))
+    {
+        if (ec)
+        {
+            //reported by fileDoesNotExistOrNeedsUpdate on the slow path
+            return false;
+        }
+        //name of the own backup file is the key of pack index
+        const auto nameLength = entry.getName().size() + backupExtension.size();
+        return m_packStore.isUpToDate(string_view(backupPath).substr(backupPath.size() - nameLength),
+            static_cast<uint64_t>(source.size), source.modificationTime);
+    }
+    if (backup.type != FileSystem::FileType::Regular)
+    {
+        return false;
+    }
 
-    removeFile(backUpToDelete);
+    return source.size == backup.size && source.modificationTime == backup.modificationTime;
 }
 
-void FSHelper::backupSingleFile(const fs::directory_entry& fileToBackup) const
+void FSHelper::backupSingleFile(const fs::path& fileToBackup) const
 {
+    TraceSpan span("backupSingleFile");
+
+    FileSystem::Status source;
+    error_code ec;
+    if (!m_fileSystem.getStatus(fileToBackup, source, ec) || source.type != FileSystem::FileType::Regular)
+    {
+        errorCodeHandler(Metrics::ErrorCategory::FileSize, [&]() { return fileToBackup.string() + " failed to read it's size."; }, ec);
+        debugLog([&]() { return fileToBackup.string() + " is not a file skipping"; });
+        return;
+    }
+
     if (doesHotFileNeedToBeDeleted(fileToBackup))
     {
         removeFile(fileToBackup);
-        deleteBackupFile(fileToBackup.path().filename().string());
+        deleteBackupFile(fileToBackup.filename().string());
 
         return;
     }
 
     auto& gd = GlobalData::getInstance();
 
-    if (fileToBackup.is_regular_file())
-    {
-        gd.updatePaths();
-        auto destination = gd.getBackupFolderPath();
-        destination /= fileToBackup.path().filename();
-        destination += gd.getBackupExtension();
+    auto destination = gd.getBackupFolderPath();
+    destination /= fileToBackup.filename();
+    destination += gd.getBackupExtension();
 
-        fs::directory_entry dest_dir{destination};
-        LogUtility::Action logAction = LogUtility::Action::Backup;
-        if (!fileDoesNotExistOrNeedsUpdate(fileToBackup, dest_dir, logAction))
-        {
-            return;
-        }
-
-        copyFile(fileToBackup, destination, logAction);
+    if (source.size < gd.getPackThreshold())
+    {
+        packFile(fileToBackup, destination, source);
+        return;
+    }
 
-        updateTimeFromSourceToDestination(fileToBackup, destination);
+    LogUtility::Action logAction = LogUtility::Action::Backup;
+    if (!fileDoesNotExistOrNeedsUpdate(source, destination, logAction))
+    {
+        Metrics::getInstance().increment(Metrics::Counter::FilesSkipped);
+        return;
     }
-    else
+
+    //previous backup keeps its own time when copy fails, so next pass tries again
+    if (copyFile(fileToBackup, destination, logAction))
     {
-        string log = fileToBackup.path().string() + " is not a file skipping";
-        debugLog(log);
+        //time read before copying, a file changed while being copied gets copied again by next pass
+        updateFileDate(destination, source.modificationTime);
+        observeBackupLatency(source.modificationTime);
     }
 }
 
-bool FSHelper::fileDoesNotExistOrNeedsUpdate(const fs::path& fileToBackup, const fs::directory_entry& destination,
+bool FSHelper::fileDoesNotExistOrNeedsUpdate(const FileSystem::Status& source, const fs::path& destination,
     LogUtility::Action& logAction) const
 {
-    if (!destination.exists())
+    TraceSpan span("fileDoesNotExistOrNeedsUpdate");
+
+    FileSystem::Status backup;
+    error_code ec;
+    if (!m_fileSystem.getStatus(destination, backup, ec))
     {
+        errorCodeHandler(Metrics::ErrorCategory::ReadTime, [&]() { return destination.string() + " failed to read it's last write time."; }, ec);
         return true;
     }
 
     //copy_options::update_existing does not work with MSYS on windows
     //@see https://github.com/msys2/MSYS2-packages/issues/1937#issuecomment-1002694786
-    //So we will check modification date and size then delete file manually
-    if (getLastWriteTime(fileToBackup) != getLastWriteTime(destination.path()))
+    //So we will check modification date and size, the new copy is renamed over the old backup
+    if (source.modificationTime != backup.modificationTime || source.size != backup.size)
     {
-        removeFile(destination, false);
         logAction = LogUtility::Action::Update;
         return true;
     }
-    else if (getFileSize(fileToBackup) != getFileSize(destination))
-    {
-        logAction = LogUtility::Action::Update;
-        removeFile(destination, false);
-        return true;
-    }
 
     return false;
 }
 
-uintmax_t FSHelper::getFileSize(const fs::directory_entry& file) const
-{
-    error_code ec;
-    auto size = file.file_size(ec);
-
-    errorCodeHandler(file.path().string() + " failed to read it's size.", ec);
-
-    return size;
-}
-
-uintmax_t FSHelper::getFileSize(const fs::path& file) const
+bool FSHelper::removeFile(const fs::path& fileToRemove, bool logMessage) const
 {
-    fs::directory_entry fileDir{file};
-
-    return getFileSize(fileDir);
-}
+    TraceSpan span("removeFile");
 
-void FSHelper::removeFile(const fs::path& fileToRemove, bool logMessage) const
-{
-    const fs::directory_entry entry{fileToRemove};
-    if (!entry.exists())
+    FileSystem::Status status;
+    error_code ec;
+    if (!m_fileSystem.getStatus(fileToRemove, status, ec))
     {
-        string log = fileToRemove.string() + " - does not exist, will not be removed";
-        debugLog(log);
+        debugLog([&]() { return fileToRemove.string() + " - does not exist, will not be removed"; });
 
-        return;
+        return false;
     }
 
-    error_code ec;
+    m_fileSystem.remove(fileToRemove, ec);
 
-    fs::remove(fileToRemove, ec);
-
-    errorCodeHandler("Failed to delete file: " + fileToRemove.string(), ec);
+    errorCodeHandler(Metrics::ErrorCategory::Delete, [&]() { return "Failed to delete file: " + fileToRemove.string(); }, ec);
 
     if (!ec)
     {
         if (logMessage)
         {
             m_logWriter.addMessageToLog(fileToRemove.string(), LogUtility::Action::Delete);
+            Metrics::getInstance().increment(Metrics::Counter::FilesDeleted);
         }
 
-        string log = fileToRemove.string() + " - was deleted";
-        debugLog(log);
+        debugLog([&]() { return fileToRemove.string() + " - was deleted"; });
     }
+
+    return !ec;
 }
 
 
-void FSHelper::updateTimeFromSourceToDestination(const fs::path& source, const fs::path& destination) const
+void FSHelper::observeBackupLatency(int64_t modificationTime) const
 {
-    const auto originalTime = getLastWriteTime(source);
+    const auto lastWriteTime = FileTime::toFileTime(modificationTime);
+    if (lastWriteTime < m_startTime)
+    {
+        return;
+    }
 
-    updateFileDate(destination, originalTime);
+    const auto latency = fs::file_time_type::clock::now() - lastWriteTime;
+    Metrics::getInstance().observe(Metrics::Histogram::BackupLatency,
+        chrono::duration_cast<chrono::nanoseconds>(max(latency, fs::file_time_type::duration::zero())));
 }
 
-fs::file_time_type FSHelper::getLastWriteTime(const fs::path& path) const
+void FSHelper::updateFileDate(const fs::path& pathToFile, int64_t modificationTime) const
 {
-    error_code ec;
-
-    auto lastWriteTime = fs::last_write_time(path, ec);
+    TraceSpan span("updateFileDate");
 
-    errorCodeHandler("Failed to read last modification time for: " + path.string(), ec);
-
-    return lastWriteTime;
-}
-
-void FSHelper::updateFileDate(const fs::path& pathToFile, const fs::file_time_type& time) const
-{
     error_code ec;
 
-    fs::last_write_time(pathToFile, time, ec);
+    m_fileSystem.setModificationTime(pathToFile, modificationTime, ec);
 
-    errorCodeHandler(pathToFile.string() + " updating last write time failed'", ec);
+    errorCodeHandler(Metrics::ErrorCategory::WriteTime, [&]() { return pathToFile.string() + " updating last write time failed'"; }, ec);
 }
 
 
 bool FSHelper::copyFile(const filesystem::path& source, 
     const filesystem::path& destination, LogUtility::Action& logAction) const
 {
+    TraceSpan span("copyFile");
+
     error_code errorCode;
-    fs::copy_options copyOption = fs::copy_options::update_existing;
+    FileCopier::CopyStats copyStats;
 
-    fs::copy_file(source, destination, copyOption, errorCode);
+    const auto copyStart = chrono::steady_clock::now();
+    m_fileSystem.copyFile(source, destination, copyStats, errorCode);
+    const auto copyDuration = chrono::steady_clock::now() - copyStart;
 
     if (errorCode) 
     {
-        if (errorCode == errc::file_exists)
-        {
-            string log = destination.string() + " skipped because it already exists";
-            debugLog(log);
-        }
-        else
-        {
-            errorCodeHandler(source.string() + " was not copied to 'backup''", errorCode);
-            return false;
-        }
+        errorCodeHandler(Metrics::ErrorCategory::Copy, [&]() { return source.string() + " was not copied to 'backup''"; }, errorCode);
+        return false;
+    }
+
+    m_copiedLogicalBytes.fetch_add(copyStats.logicalBytes);
+    m_copiedPhysicalBytes.fetch_add(copyStats.physicalBytes);
+
+    auto& metrics = Metrics::getInstance();
+    metrics.increment(Metrics::Counter::FilesBackedUp);
+    metrics.increment(Metrics::Counter::BytesCopied, copyStats.logicalBytes);
+    metrics.increment(Metrics::Counter::PhysicalBytesCopied, copyStats.physicalBytes);
+    metrics.increment(Metrics::Counter::CopyNanoseconds, static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(copyDuration).count()));
+    metrics.observe(Metrics::Histogram::CopyDuration, copyDuration);
+
+    if (copyStats.checksum)
+    {
+        ChecksumStore::Entry entry;
+        entry.checksum = copyStats.checksum.value();
+        entry.size = copyStats.logicalBytes;
+        entry.sourcePath = source.lexically_relative(GlobalData::getInstance().getHotFolderPath()).generic_string();
+        m_checksumStore.set(destination.filename().string(), entry);
+    }
+    else
+    {
+        m_checksumStore.remove(destination.filename().string());
     }
+    //file grew over pack threshold, its own backup file replaces the packed one
+    m_packStore.remove(destination.filename().string());
 
     m_logWriter.addMessageToLog(source.string(), destination.string(), logAction);
 
-    string log = destination.string() + " was copied";
-    debugLog(log);
+    debugLog([&]() { return destination.string() + " was copied, logical bytes: " + to_string(copyStats.logicalBytes) +
+        " physical bytes: " + to_string(copyStats.physicalBytes); });
 
     return true;
 }
 
-void FSHelper::errorCodeHandler(std::string userText, std::error_code errorCode) const
+void FSHelper::packFile(const fs::path& sourcePath, const fs::path& destination, const FileSystem::Status& source) const
+{
+    TraceSpan span("packFile");
+
+    const auto backupName = destination.filename().string();
+    const auto lastWriteTime = source.modificationTime;
+
+    FileSystem::Status ownBackupStatus;
+    error_code ec;
+    const bool ownBackup = m_fileSystem.getStatus(destination, ownBackupStatus, ec);
+    if (!ownBackup && m_packStore.isUpToDate(backupName, source.size, lastWriteTime))
+    {
+        Metrics::getInstance().increment(Metrics::Counter::FilesSkipped);
+        return;
+    }
+
+    const auto copyStart = chrono::steady_clock::now();
+
+    //small files are read whole, buffer keeps its capacity between files
+    thread_local string content;
+    if (!m_fileSystem.readFile(sourcePath, content, ec))
+    {
+        errorCodeHandler(Metrics::ErrorCategory::Copy, [&]() { return sourcePath.string() + " was not packed into 'backup''"; }, ec);
+        return;
+    }
+
+    const auto logAction = ownBackup || m_packStore.get(backupName) ? LogUtility::Action::Update : LogUtility::Action::Backup;
+    const auto checksum = Crc32c::update(0, content.data(), content.size());
+    const auto relativePath = sourcePath.lexically_relative(GlobalData::getInstance().getHotFolderPath()).generic_string();
+
+    if (!m_packStore.store(backupName, relativePath, content.data(), content.size(), lastWriteTime, checksum, ec))
+    {
+        errorCodeHandler(Metrics::ErrorCategory::Copy, [&]() { return sourcePath.string() + " was not packed into 'backup''"; }, ec);
+        return;
+    }
+    const auto copyDuration = chrono::steady_clock::now() - copyStart;
+
+    if (ownBackup)
+    {
+        removeFile(destination, false);
+        m_checksumStore.remove(backupName);
+    }
+
+    auto& metrics = Metrics::getInstance();
+    metrics.increment(Metrics::Counter::FilesBackedUp);
+    metrics.increment(Metrics::Counter::FilesPacked);
+    metrics.increment(Metrics::Counter::BytesCopied, content.size());
+    metrics.increment(Metrics::Counter::PhysicalBytesCopied, content.size());
+    metrics.increment(Metrics::Counter::CopyNanoseconds, static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(copyDuration).count()));
+    metrics.observe(Metrics::Histogram::CopyDuration, copyDuration);
+    observeBackupLatency(lastWriteTime);
+
+    const auto packed = m_packStore.get(backupName);
+    m_logWriter.addMessageToLog(sourcePath.string(), packed ? m_packStore.getPackPath(packed->pack).string() : destination.string(), logAction);
+
+    debugLog([&]() { return sourcePath.string() + " was packed, bytes: " + to_string(content.size()); });
+}
+
+void FSHelper::errorCodeHandler(Metrics::ErrorCategory category, const function<string()>& userText, error_code errorCode) const
 {
     if (errorCode)
     {
-        cerr<<userText<<" - Due to Error: "<< errorCode.message()<<"\n";
+        Metrics::getInstance().countError(category);
+        cerr<<userText()<<" - Due to Error: "<< errorCode.message()<<"\n";
     }
 }
\ No newline at end of file
@@ -1,12 +1,31 @@
+#pragma once
+
+#include <atomic>
 #include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
 #include "LogUtility.h"
+#include "FileSystem.h"
+#include "FileCopier.h"
+#include "ChecksumStore.h"
+#include "PackStore.h"
+#include "Metrics.h"
 /**
  * @brief Helper for various file system operations
+ * Files are accessed through FileSystem, checksum and pack stores use files of the machine.
  */
 class FSHelper
 {
 public: 
+    /**
+     * @brief Works with NativeFileSystem
+     */
     FSHelper(LogUtility::LogWriter& logWriter);
+    /**
+     * @param fileSystem: file system of hot and backup folders, has to outlive helper
+     */
+    FSHelper(LogUtility::LogWriter& logWriter, const FileSystem& fileSystem);
     ~FSHelper();
     /**
      * @brief checks if file exists
@@ -33,12 +52,24 @@ public:
      * files with 'delete_' prefix are deleted.
      * @param fileTobackup: source file which needs backup
      */
-    void backupSingleFile(const std::filesystem::directory_entry& fileTobackup) const;
+    void backupSingleFile(const std::filesystem::path& fileTobackup) const;
+    /**
+     * @brief Bakcup current entry of directory walk
+     * Unchanged files are recognized without allocating, others go through the path version.
+     * @param entry: walker positioned at source file
+     */
+    void backupSingleFile(const FileSystem::Walker& entry) const;
+    /**
+     * @brief Current entry of directory walk has to go through backupSingleFile
+     * Unchanged files are recognized without allocating and counted as skipped.
+     * @return true: regular file which is new, changed or carries delete prefix
+     */
+    bool needsBackup(const FileSystem::Walker& entry) const;
     /**
      * @brief With compilation flag set prints out some info to help with debugging
-     * @param logLine: message to print
+     * @param logLine: builds message to print, not called without the flag
      */
-    void debugLog(std::string& logLine) const;
+    void debugLog(const std::function<std::string()>& logLine) const;
     /**
      * @brief Check prerequisites of environment
      * For example that hot folder exists and backup folder is possible to create
@@ -46,6 +77,38 @@ public:
      * @return false: abort application due to environment issues
      */
     bool initEnvironment() const;
+    /**
+     * @brief Checksums of backup files, loaded by initEnvironment
+     */
+    const ChecksumStore& getChecksumStore() const;
+    /**
+     * @brief Index of files kept in packs, loaded by initEnvironment
+     */
+    const PackStore& getPackStore() const;
+
+    const FileSystem& getFileSystem() const;
+    /**
+     * @brief Write out files packed since last call, called at the end of every pass
+     */
+    void flushPacks() const;
+    /**
+     * @brief Housekeeping of pack files (garbage collection, compaction), called between passes
+     */
+    void maintainPacks() const;
+    /**
+     * @brief Logical (file size) and physical (without holes) amount of bytes backed up so far
+     */
+    FileCopier::CopyStats getCopyTotals() const;
+    /**
+     * @brief Names of all backups, own backup files in backup folder and packed files
+     */
+    void getBackupNames(std::vector<std::string>& backupNames) const;
+    /**
+     * @brief Remove backup whose file is no longer in hot folder, or move it to quarantine folder inside backup folder
+     * Packed backup is written out of its pack when quarantined.
+     * @return true: there was a backup with this name
+     */
+    bool removeOrphan(const std::string& backupName, bool quarantine) const;
 private:
     /**
      * @brief Waits till folder is created as it might take some time for folder to be created and visible for the program.
@@ -56,17 +119,43 @@ private:
      */
     bool waitForDirectoryCreation(const std::filesystem::directory_entry& dir) const;
     bool copyFile(const std::filesystem::path& source, const std::filesystem::path& destination, LogUtility::Action& logAction) const;
+    /**
+     * @brief Append file smaller than pack threshold into current pack, replacing its own backup file if it had one
+     * @param destination: backup file the source would have outside of pack
+     * @param source: status of source taken before reading it
+     */
+    void packFile(const std::filesystem::path& sourcePath, const std::filesystem::path& destination,
+        const FileSystem::Status& source) const;
     void setPermissions(const std::filesystem::directory_entry& dir) const;
-    void updateTimeFromSourceToDestination(const std::filesystem::path& source, const std::filesystem::path& destination) const;
-    void updateFileDate(const std::filesystem::path& pathToFile, const std::filesystem::file_time_type& time) const;
-    bool fileDoesNotExistOrNeedsUpdate(const std::filesystem::path& fileTobackup, 
-        const std::filesystem::directory_entry& destination, LogUtility::Action& logAction) const;
-    std::filesystem::file_time_type getLastWriteTime(const std::filesystem::path& path) const;
-    bool doesHotFileNeedToBeDeleted(const std::filesystem::directory_entry& fileToBackup) const;
-    void removeFile(const std::filesystem::path& fileToRemove, bool logMessage = true) const;
+    void updateFileDate(const std::filesystem::path& pathToFile, std::int64_t modificationTime) const;
+    /**
+     * @brief Records time from modification of source till its backup is complete
+     * Files last modified before application started are not recorded, their backup was not waited for.
+     */
+    void observeBackupLatency(std::int64_t modificationTime) const;
+    /**
+     * @brief Backup exists with the same size and modification time as source, checked by status only (Linux)
+     * Files without own backup file are looked up in pack index.
+     */
+    bool isBackupUpToDate(const FileSystem::Walker& entry) const;
+    bool fileDoesNotExistOrNeedsUpdate(const FileSystem::Status& source,
+        const std::filesystem::path& destination, LogUtility::Action& logAction) const;
+    bool doesHotFileNeedToBeDeleted(const std::filesystem::path& fileToBackup) const;
+    /**
+     * @return true: file was removed
+     */
+    bool removeFile(const std::filesystem::path& fileToRemove, bool logMessage = true) const;
     void deleteBackupFile(std::string sourceFile) const;
-    void errorCodeHandler(std::string userText, std::error_code errorCode) const;
-    uintmax_t getFileSize(const std::filesystem::directory_entry& file) const;
-    uintmax_t getFileSize(const std::filesystem::path& file) const;
+    /**
+     * @brief Reports error, userText is only called when there is an error
+     */
+    void errorCodeHandler(Metrics::ErrorCategory category, const std::function<std::string()>& userText,
+        std::error_code errorCode) const;
     LogUtility::LogWriter& m_logWriter;
+    const FileSystem& m_fileSystem;
+    mutable std::atomic<std::uintmax_t> m_copiedLogicalBytes;
+    mutable std::atomic<std::uintmax_t> m_copiedPhysicalBytes;
+    mutable ChecksumStore m_checksumStore;
+    mutable PackStore m_packStore;
+    const std::filesystem::file_time_type m_startTime;
 };
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "Tests.h"
+#include "BackupFixture.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+    void writeText(const fs::path& path, const string& text)
+    {
+        ofstream output(path, ios::binary | ios::trunc);
+        output << text;
+    }
+
+    string readText(const fs::path& path)
+    {
+        ifstream input(path, ios::binary);
+        stringstream text;
+        text << input.rdbuf();
+        return text.str();
+    }
+}
+
+TEST(FSHelperUpdatesExistingBackupInMemory)
+{
+    BackupFixture fixture("fshelper_update_memory", true);
+    auto& fileSystem = fixture.getMemoryFileSystem();
+    fileSystem.writeFile(fixture.getHot() / "file.txt", 100);
+    fixture.runPasses(1);
+    FileSystem::Status backup;
+    CHECK(fixture.getBackupStatus("file.txt", backup) && backup.size == 100);
+
+    fileSystem.writeFile(fixture.getHot() / "file.txt", 200);
+    const auto copiesBefore = fileSystem.getOperationCount(MemoryFileSystem::Operation::Copy);
+    fixture.runPasses(3);
+    CHECK(fixture.getBackupStatus("file.txt", backup) && backup.size == 200);
+    //backed up once, later passes find the backup up to date
+    CHECK(fileSystem.getOperationCount(MemoryFileSystem::Operation::Copy) == copiesBefore + 1);
+
+    FileSystem::Status source;
+    error_code ec;
+    CHECK(fileSystem.getStatus(fixture.getHot() / "file.txt", source, ec));
+    CHECK(backup.modificationTime == source.modificationTime);
+}
+
+TEST(FSHelperUpdatesExistingBackupOnDisk)
+{
+    BackupFixture fixture("fshelper_update_disk", false);
+    const auto file = fixture.getHot() / "file.txt";
+    writeText(file, "first version");
+    fixture.runPasses(1);
+    CHECK(readText(fixture.getBackupPath("file.txt")) == "first version");
+
+    writeText(file, "second, longer version of the file");
+    fs::last_write_time(file, fs::last_write_time(file) + chrono::seconds(5));
+    fixture.runPasses(2);
+    CHECK(readText(fixture.getBackupPath("file.txt")) == "second, longer version of the file");
+    CHECK(fs::last_write_time(fixture.getBackupPath("file.txt")) == fs::last_write_time(file));
+
+    //shorter content must not leave the tail of the previous backup behind
+    writeText(file, "short");
+    fs::last_write_time(file, fs::last_write_time(file) + chrono::seconds(5));
+    fixture.runPasses(1);
+    CHECK(readText(fixture.getBackupPath("file.txt")) == "short");
+
+    //no temporary file is left next to the backup
+    size_t files = 0;
+    for (const auto& entry : fs::directory_iterator(fixture.getBackup()))
+    {
+        files += entry.path().extension() == ".part" ? 100 : 1;
+    }
+    CHECK(files < 100);
+}
\ No newline at end of file
@@ -0,0 +1,468 @@
+#include "FileCopier.h"
+#include "GlobalData.h"
+#include "Crc32c.h"
+#include "Tracer.h"
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cerrno>
+#else
+#include <fstream>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+const uintmax_t FileCopier::ChunkSize{8 * 1024 * 1024};
+const size_t FileCopier::DirectIoAlignment{4096};
+
+FileCopier::FileCopier()
+{
+
+}
+
+FileCopier::~FileCopier()
+{
+
+}
+
+#ifdef __linux__
+bool FileCopier::copy(const fs::path& source, const fs::path& destination, CopyStats& stats, error_code& errorCode) const
+{
+    errorCode.clear();
+    stats = CopyStats{};
+
+    auto& gd = GlobalData::getInstance();
+
+    int sourceFd = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if (sourceFd < 0)
+    {
+        errorCode.assign(errno, system_category());
+        return false;
+    }
+
+    struct stat sourceStat;
+    if (fstat(sourceFd, &sourceStat) != 0)
+    {
+        errorCode.assign(errno, system_category());
+        close(sourceFd);
+        return false;
+    }
+
+    const auto size = static_cast<uintmax_t>(sourceStat.st_size);
+    const bool isLargeFile = size >= gd.getLargeFileThreshold();
+    const bool withChecksum = gd.isChecksumEnabled();
+    bool directIo = isLargeFile && gd.isDirectIoEnabled();
+
+    auto ranges = findDataRanges(sourceFd, size);
+
+    //copies are committed by rename so a half copied backup never replaces the previous one
+    auto target = destination;
+    target += gd.getPartialExtension();
+
+    //destination is probed first, source is switched to O_DIRECT only when both ends support it
+    int destinationFd = open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | (directIo ? O_DIRECT : 0), 0666);
+    if (destinationFd < 0 && directIo)
+    {
+        //file system does not support O_DIRECT (tmpfs for example), fall back to buffered io
+        directIo = false;
+        destinationFd = open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    }
+    if (destinationFd < 0)
+    {
+        errorCode.assign(errno, system_category());
+        close(sourceFd);
+        return false;
+    }
+
+    if (directIo)
+    {
+        int directFd = open(source.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+        if (directFd >= 0)
+        {
+            close(sourceFd);
+            sourceFd = directFd;
+            //O_DIRECT needs block aligned offsets, the extra bytes are zeros from holes
+            vector<Range> alignedRanges;
+            for (const auto& range : ranges)
+            {
+                const auto end = min(size, (range.offset + range.length + DirectIoAlignment - 1) / DirectIoAlignment * DirectIoAlignment);
+                const auto start = range.offset / DirectIoAlignment * DirectIoAlignment;
+                if (!alignedRanges.empty() && alignedRanges.back().offset + alignedRanges.back().length >= start)
+                {
+                    alignedRanges.back().length = end - alignedRanges.back().offset;
+                }
+                else
+                {
+                    alignedRanges.push_back(Range{start, end - start});
+                }
+            }
+            ranges = move(alignedRanges);
+        }
+        else
+        {
+            //source can not be read directly, destination goes back to buffered writes as well
+            directIo = false;
+            fcntl(destinationFd, F_SETFL, fcntl(destinationFd, F_GETFL) & ~O_DIRECT);
+        }
+    }
+
+    int result = 0;
+
+    //setting the size first leaves every range which is not written as a hole
+    if (ftruncate(destinationFd, static_cast<off_t>(size)) != 0)
+    {
+        result = errno;
+    }
+
+    if (result == 0 && isLargeFile)
+    {
+        //reserve space for data so workers writing at different offsets do not fragment the file,
+        //not every file system supports it, so failure here is not an error
+        for (const auto& range : ranges)
+        {
+            fallocate(destinationFd, 0, static_cast<off_t>(range.offset), static_cast<off_t>(range.length));
+        }
+    }
+
+    uint32_t checksum = 0;
+    if (result == 0)
+    {
+        const unsigned int workerCount = isLargeFile ? gd.getCopyThreads() : 1;
+        result = copyRanges(sourceFd, destinationFd, ranges, size, workerCount, directIo, withChecksum ? &checksum : nullptr);
+    }
+
+    //direct io writes whole blocks, so the tail has to be cut back to real size
+    if (result == 0 && directIo && ftruncate(destinationFd, static_cast<off_t>(size)) != 0)
+    {
+        result = errno;
+    }
+
+    if (result == 0)
+    {
+        fchmod(destinationFd, sourceStat.st_mode & 07777);
+    }
+
+    close(sourceFd);
+    if (close(destinationFd) != 0 && result == 0)
+    {
+        result = errno;
+    }
+
+    if (result == 0 && rename(target.c_str(), destination.c_str()) != 0)
+    {
+        result = errno;
+    }
+
+    if (result != 0)
+    {
+        unlink(target.c_str());
+        errorCode.assign(result, system_category());
+        return false;
+    }
+
+    stats.logicalBytes = size;
+    for (const auto& range : ranges)
+    {
+        stats.physicalBytes += range.length;
+    }
+    if (withChecksum)
+    {
+        stats.checksum = checksum;
+    }
+
+    return true;
+}
+
+vector<FileCopier::Range> FileCopier::findDataRanges(int fd, uintmax_t size) const
+{
+    vector<Range> ranges;
+    off_t offset = 0;
+
+    while (static_cast<uintmax_t>(offset) < size)
+    {
+        const off_t dataStart = lseek(fd, offset, SEEK_DATA);
+        if (dataStart < 0)
+        {
+            if (errno == ENXIO)
+            {
+                //only a hole is left till the end of file
+                break;
+            }
+            //SEEK_DATA is not supported, treat the whole file as data
+            return {Range{0, size}};
+        }
+
+        off_t dataEnd = lseek(fd, dataStart, SEEK_HOLE);
+        if (dataEnd < 0)
+        {
+            return {Range{0, size}};
+        }
+        dataEnd = min<off_t>(dataEnd, static_cast<off_t>(size));
+
+        ranges.push_back(Range{static_cast<uintmax_t>(dataStart), static_cast<uintmax_t>(dataEnd - dataStart)});
+        offset = dataEnd;
+    }
+
+    return ranges;
+}
+
+int FileCopier::copyRanges(int sourceFd, int destinationFd, const vector<Range>& ranges, uintmax_t size,
+    unsigned int workerCount, bool directIo, uint32_t* checksum) const
+{
+    vector<Range> chunks;
+    for (const auto& range : ranges)
+    {
+        for (uintmax_t offset = 0; offset < range.length; offset += ChunkSize)
+        {
+            chunks.push_back(Range{range.offset + offset, min(ChunkSize, range.length - offset)});
+        }
+    }
+    vector<uint32_t> chunkChecksums(checksum ? chunks.size() : 0);
+
+    atomic<size_t> nextChunk{0};
+    atomic<int> firstError{0};
+
+    auto worker = [&]()
+    {
+        while (firstError.load() == 0)
+        {
+            const auto index = nextChunk.fetch_add(1);
+            if (index >= chunks.size())
+            {
+                return;
+            }
+
+            TraceSpan span("copyRange");
+            const int result = copyRange(sourceFd, destinationFd, chunks[index].offset, chunks[index].length,
+                directIo, checksum ? &chunkChecksums[index] : nullptr);
+            if (result != 0)
+            {
+                int noError = 0;
+                firstError.compare_exchange_strong(noError, result);
+            }
+        }
+    };
+
+    workerCount = static_cast<unsigned int>(min<size_t>(workerCount, chunks.size()));
+
+    vector<thread> workers;
+    for (unsigned int i = 1; i < workerCount; i++)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& workerThread : workers)
+    {
+        workerThread.join();
+    }
+
+    if (checksum && firstError.load() == 0)
+    {
+        //stitch chunk checksums together in file order, holes count as zeros
+        uint32_t fileChecksum = 0;
+        uintmax_t position = 0;
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            if (chunks[i].offset > position)
+            {
+                const auto gap = chunks[i].offset - position;
+                fileChecksum = Crc32c::combine(fileChecksum, Crc32c::zeros(gap), gap);
+            }
+            fileChecksum = Crc32c::combine(fileChecksum, chunkChecksums[i], chunks[i].length);
+            position = chunks[i].offset + chunks[i].length;
+        }
+        if (size > position)
+        {
+            fileChecksum = Crc32c::combine(fileChecksum, Crc32c::zeros(size - position), size - position);
+        }
+        *checksum = fileChecksum;
+    }
+
+    return firstError.load();
+}
+
+int FileCopier::copyRange(int sourceFd, int destinationFd, uintmax_t offset, uintmax_t length,
+    bool directIo, uint32_t* checksum) const
+{
+    if (directIo || checksum)
+    {
+        return copyRangeWithBuffer(sourceFd, destinationFd, offset, length, directIo, checksum);
+    }
+
+    auto sourceOffset = static_cast<off_t>(offset);
+    auto destinationOffset = static_cast<off_t>(offset);
+
+    while (length > 0)
+    {
+        const auto copied = copy_file_range(sourceFd, &sourceOffset, destinationFd, &destinationOffset, length, 0);
+        if (copied < 0)
+        {
+            if (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)
+            {
+                //kernel can not copy between these file systems, do it in user space
+                return copyRangeWithBuffer(sourceFd, destinationFd, static_cast<uintmax_t>(sourceOffset), length, directIo, nullptr);
+            }
+            return errno;
+        }
+        if (copied == 0)
+        {
+            //source was truncated while copying
+            return EIO;
+        }
+        length -= static_cast<uintmax_t>(copied);
+    }
+
+    return 0;
+}
+
+int FileCopier::copyRangeWithBuffer(int sourceFd, int destinationFd, uintmax_t offset, uintmax_t length,
+    bool directIo, uint32_t* checksum) const
+{
+    if (checksum)
+    {
+        *checksum = 0;
+    }
+
+    const size_t bufferSize = static_cast<size_t>(min(ChunkSize, length) + DirectIoAlignment - 1) / DirectIoAlignment * DirectIoAlignment;
+    unique_ptr<char, decltype(&free)> buffer{static_cast<char*>(aligned_alloc(DirectIoAlignment, bufferSize)), &free};
+
+    if (!buffer)
+    {
+        return ENOMEM;
+    }
+
+    while (length > 0)
+    {
+        const auto toRead = directIo ? bufferSize : static_cast<size_t>(min<uintmax_t>(bufferSize, length));
+        const auto bytesRead = pread(sourceFd, buffer.get(), toRead, static_cast<off_t>(offset));
+        if (bytesRead < 0)
+        {
+            return errno;
+        }
+        if (bytesRead == 0)
+        {
+            return EIO;
+        }
+
+        auto usefulBytes = min<uintmax_t>(static_cast<uintmax_t>(bytesRead), length);
+        //O_DIRECT requires whole blocks, padding past the end is cut off by ftruncate
+        auto toWrite = directIo ? (usefulBytes + DirectIoAlignment - 1) / DirectIoAlignment * DirectIoAlignment : usefulBytes;
+
+        if (checksum)
+        {
+            *checksum = Crc32c::update(*checksum, buffer.get(), static_cast<size_t>(usefulBytes));
+        }
+
+        size_t written = 0;
+        while (written < toWrite)
+        {
+            const auto result = pwrite(destinationFd, buffer.get() + written, toWrite - written, static_cast<off_t>(offset + written));
+            if (result < 0)
+            {
+                return errno;
+            }
+            written += static_cast<size_t>(result);
+        }
+
+        offset += usefulBytes;
+        length -= usefulBytes;
+    }
+
+    return 0;
+}
+#else
+bool FileCopier::copy(const fs::path& source, const fs::path& destination, CopyStats& stats, error_code& errorCode) const
+{
+    errorCode.clear();
+    stats = CopyStats{};
+
+    const auto size = fs::file_size(source, errorCode);
+
+    if (errorCode)
+    {
+        return false;
+    }
+
+    auto& gd = GlobalData::getInstance();
+    uint32_t checksum = 0;
+
+    //no positional io here, copy to temporary file and commit it when done,
+    //previous backup stays in place until the copy is complete
+    auto partialDestination = destination;
+    partialDestination += gd.getPartialExtension();
+
+    if (gd.isChecksumEnabled())
+    {
+        copyWithChecksum(source, partialDestination, checksum, errorCode);
+    }
+    else
+    {
+        fs::copy_file(source, partialDestination, fs::copy_options::overwrite_existing, errorCode);
+    }
+    if (!errorCode)
+    {
+        fs::rename(partialDestination, destination, errorCode);
+    }
+
+    if (errorCode)
+    {
+        error_code ignored;
+        fs::remove(partialDestination, ignored);
+    }
+
+    if (errorCode)
+    {
+        return false;
+    }
+
+    stats.logicalBytes = size;
+    stats.physicalBytes = size;
+    if (gd.isChecksumEnabled())
+    {
+        stats.checksum = checksum;
+    }
+
+    return true;
+}
+
+bool FileCopier::copyWithChecksum(const fs::path& source, const fs::path& destination,
+    uint32_t& checksum, error_code& errorCode) const
+{
+    ifstream input(source, ios::binary);
+    ofstream output(destination, ios::binary | ios::trunc);
+    if (!input || !output)
+    {
+        errorCode = make_error_code(errc::io_error);
+        return false;
+    }
+
+    vector<char> buffer(static_cast<size_t>(ChunkSize));
+    checksum = 0;
+    while (input)
+    {
+        input.read(buffer.data(), static_cast<streamsize>(buffer.size()));
+        const auto bytesRead = static_cast<size_t>(input.gcount());
+        if (bytesRead == 0)
+        {
+            break;
+        }
+        checksum = Crc32c::update(checksum, buffer.data(), bytesRead);
+        output.write(buffer.data(), static_cast<streamsize>(bytesRead));
+    }
+
+    if (input.bad() || !output)
+    {
+        errorCode = make_error_code(errc::io_error);
+        return false;
+    }
+
+    return true;
+}
+#endif
\ No newline at end of file
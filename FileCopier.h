@@ -0,0 +1,75 @@
+#pragma once
+
+#include <filesystem>
+#include <system_error>
+#include <cstdint>
+#include <vector>
+#include "FileMetadata.h"
+/**
+ * @brief Copies file contents to the backup folder
+ * Only allocated ranges of sparse files are copied, holes are recreated in the copy.
+ * Files bigger than GlobalData large file threshold are split into byte ranges
+ * which are copied by several workers at once, so that RAID/NVMe storage gets
+ * enough outstanding requests.
+ */
+class FileCopier
+{
+public:
+    /**
+     * @brief Amount of data a copy represents, shared with FileSystem implementations
+     */
+    using CopyStats = ::CopyStats;
+
+    FileCopier();
+    ~FileCopier();
+    /**
+     * @brief Copy file contents from source to destination
+     * Data is written to a temporary file next to destination
+     * which replaces destination only after every range is copied.
+     * @param source: file to copy
+     * @param destination: path of the copy
+     * @param stats: filled with logical and physical size of the copy
+     * @param errorCode: set to the failure reason
+     * @return true: file copied
+     * @return false: copy failed, destination is left untouched
+     */
+    bool copy(const std::filesystem::path& source, const std::filesystem::path& destination,
+        CopyStats& stats, std::error_code& errorCode) const;
+private:
+    /**
+     * @brief Continuous range of file data
+     */
+    struct Range
+    {
+        std::uintmax_t offset;
+        std::uintmax_t length;
+    };
+#ifdef __linux__
+    /**
+     * @brief Find allocated ranges of a file, whole file is returned if file system can not tell
+     */
+    std::vector<Range> findDataRanges(int fd, std::uintmax_t size) const;
+    /**
+     * @brief Copy given ranges between opened files using up to workerCount threads
+     * @param size: size of the whole file, data outside of ranges is zeros
+     * @param checksum: when not null receives checksum of the whole file
+     * @return 0 on success, errno value otherwise
+     */
+    int copyRanges(int sourceFd, int destinationFd, const std::vector<Range>& ranges, std::uintmax_t size,
+        unsigned int workerCount, bool directIo, std::uint32_t* checksum) const;
+    /**
+     * @brief Copy [offset, offset + length) between already opened files
+     * @param checksum: when not null data goes through user space buffer and receives its checksum
+     * @return 0 on success, errno value otherwise
+     */
+    int copyRange(int sourceFd, int destinationFd, std::uintmax_t offset, std::uintmax_t length,
+        bool directIo, std::uint32_t* checksum) const;
+    int copyRangeWithBuffer(int sourceFd, int destinationFd, std::uintmax_t offset, std::uintmax_t length,
+        bool directIo, std::uint32_t* checksum) const;
+#else
+    bool copyWithChecksum(const std::filesystem::path& source, const std::filesystem::path& destination,
+        std::uint32_t& checksum, std::error_code& errorCode) const;
+#endif
+    static const std::uintmax_t ChunkSize;
+    static const std::size_t DirectIoAlignment;
+};
\ No newline at end of file
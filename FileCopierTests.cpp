@@ -0,0 +1,137 @@
+#include "Tests.h"
+#include "BackupFixture.h"
+#include "FileCopier.h"
+#include "Crc32c.h"
+#include "GlobalData.h"
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+    const uintmax_t MegaByte{1024 * 1024};
+
+    string readText(const fs::path& path)
+    {
+        ifstream input(path, ios::binary);
+        stringstream text;
+        text << input.rdbuf();
+        return text.str();
+    }
+    /**
+     * @brief File of given size with data written only at offsets, rest of it is left as holes
+     */
+    void writeSparseFile(const fs::path& path, uintmax_t size, const vector<uintmax_t>& offsets)
+    {
+        {
+            ofstream output(path, ios::binary | ios::trunc);
+            for (const auto offset : offsets)
+            {
+                output.seekp(static_cast<streamoff>(offset));
+                output << "data at " << offset;
+            }
+        }
+        fs::resize_file(path, size);
+    }
+
+    string makeRandomData(size_t size)
+    {
+        mt19937 generator(static_cast<unsigned int>(size));
+        string data(size, '\0');
+        for (auto& c : data)
+        {
+            c = static_cast<char>(generator());
+        }
+        return data;
+    }
+
+#ifdef __linux__
+    uintmax_t getAllocatedBytes(const fs::path& path)
+    {
+        struct stat status{};
+        return stat(path.c_str(), &status) == 0 ? static_cast<uintmax_t>(status.st_blocks) * 512 : 0;
+    }
+#endif
+}
+
+#ifdef __linux__
+TEST(FileCopierKeepsHolesOfSparseFile)
+{
+    BackupFixture fixture("copier_sparse", false);
+    const auto source = fixture.getHot() / "sparse.bin";
+    const auto size = 64 * MegaByte;
+    writeSparseFile(source, size, {0, 20 * MegaByte, size - 100});
+    //file system without holes stores every byte, then there is nothing to check
+    const bool hasHoles = getAllocatedBytes(source) < size / 2;
+
+    const auto destination = fixture.getBackup() / "sparse.bin.copy";
+    FileCopier copier;
+    FileCopier::CopyStats stats;
+    error_code ec;
+    CHECK(copier.copy(source, destination, stats, ec));
+    CHECK(stats.logicalBytes == size);
+    CHECK(readText(destination) == readText(source));
+    CHECK(stats.checksum == Crc32c::update(0, readText(source).data(), static_cast<size_t>(size)));
+    if (hasHoles)
+    {
+        CHECK(stats.physicalBytes < size / 2);
+        CHECK(getAllocatedBytes(destination) < size / 2);
+    }
+}
+#endif
+
+TEST(FileCopierTotalsCountedByFsHelper)
+{
+    BackupFixture fixture("copier_totals", false);
+    writeSparseFile(fixture.getHot() / "sparse.bin", 32 * MegaByte, {MegaByte});
+    writeSparseFile(fixture.getHot() / "small.bin", MegaByte, {0});
+    fixture.runPasses(1);
+
+    const auto totals = fixture.getFsHelper().getCopyTotals();
+    CHECK(totals.logicalBytes == 33 * MegaByte);
+    CHECK(totals.physicalBytes <= totals.logicalBytes);
+    CHECK(readText(fixture.getBackupPath("sparse.bin")) == readText(fixture.getHot() / "sparse.bin"));
+}
+
+TEST(FileCopierSplitsLargeFileIntoRanges)
+{
+    BackupFixture fixture("copier_large", false);
+    auto& gd = GlobalData::getInstance();
+    gd.setLargeFileThreshold(MegaByte);
+    gd.setCopyThreads(4);
+    gd.setDirectIoEnabled(true);
+
+    //several chunks for the workers and a tail which is not block aligned
+    const auto data = makeRandomData(static_cast<size_t>(27 * MegaByte + 1234));
+    const auto source = fixture.getHot() / "large.bin";
+    {
+        ofstream output(source, ios::binary | ios::trunc);
+        output << data;
+    }
+
+    const auto destination = fixture.getBackup() / "large.bin.copy";
+    {
+        ofstream previous(destination, ios::binary | ios::trunc);
+        previous << "previous copy";
+    }
+
+    FileCopier copier;
+    FileCopier::CopyStats stats;
+    error_code ec;
+    CHECK(copier.copy(source, destination, stats, ec));
+    CHECK(!ec);
+    CHECK(stats.logicalBytes == data.size());
+    CHECK(stats.checksum == Crc32c::update(0, data.data(), data.size()));
+    CHECK(readText(destination) == data);
+
+    auto partial = destination;
+    partial += gd.getPartialExtension();
+    CHECK(!fs::exists(partial));
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "FileMetadata.h"
+#include <chrono>
+
+#ifdef __linux__
+#include <fcntl.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+bool FileTime::getModificationTime(const fs::path& path, int64_t& lastWriteTime)
+{
+#ifdef __linux__
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0)
+    {
+        return false;
+    }
+    lastWriteTime = getModificationTime(status);
+    return true;
+#else
+    error_code ec;
+    const auto time = fs::last_write_time(path, ec);
+    lastWriteTime = static_cast<int64_t>(time.time_since_epoch().count());
+    return !ec;
+#endif
+}
+
+bool FileTime::setModificationTime(const fs::path& path, int64_t lastWriteTime)
+{
+#ifdef __linux__
+    //nanoseconds of times before epoch still have to be positive
+    const int64_t nanosecondsPerSecond = 1000000000;
+    auto seconds = lastWriteTime / nanosecondsPerSecond;
+    auto nanoseconds = lastWriteTime % nanosecondsPerSecond;
+    if (nanoseconds < 0)
+    {
+        seconds--;
+        nanoseconds += nanosecondsPerSecond;
+    }
+    const struct timespec times[2] = {{0, UTIME_OMIT}, {static_cast<time_t>(seconds), static_cast<long>(nanoseconds)}};
+    return utimensat(AT_FDCWD, path.c_str(), times, 0) == 0;
+#else
+    error_code ec;
+    fs::last_write_time(path, fs::file_time_type(fs::file_time_type::duration(lastWriteTime)), ec);
+    return !ec;
+#endif
+}
+
+fs::file_time_type FileTime::toFileTime(int64_t lastWriteTime)
+{
+#ifdef __linux__
+    //file clock epoch is implementation defined, so move between clocks relative to now
+    const chrono::system_clock::time_point systemTime{chrono::duration_cast<chrono::system_clock::duration>(chrono::nanoseconds(lastWriteTime))};
+    const auto fileNow = fs::file_time_type::clock::now();
+    const auto systemNow = chrono::system_clock::now();
+    return fileNow + chrono::duration_cast<fs::file_time_type::duration>(systemTime - systemNow);
+#else
+    return fs::file_time_type(fs::file_time_type::duration(lastWriteTime));
+#endif
+}
+
+#ifdef __linux__
+int64_t FileTime::getModificationTime(const struct stat& status)
+{
+    return static_cast<int64_t>(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+}
+#endif
\ No newline at end of file
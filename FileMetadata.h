@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
+/**
+ * @brief Amount of data a copy represents
+ * logicalBytes: size of the file
+ * physicalBytes: bytes which were actually read and written, holes excluded
+ * checksum: CRC32C of copied data, computed while copying when checksums are enabled
+ */
+struct CopyStats
+{
+    std::uintmax_t logicalBytes = 0;
+    std::uintmax_t physicalBytes = 0;
+    std::optional<std::uint32_t> checksum;
+};
+/**
+ * @brief Modification times in the unit kept by FileSystem and pack index (nanoseconds on Linux, file clock ticks elsewhere)
+ */
+class FileTime
+{
+public:
+    FileTime() = delete;
+
+    static bool getModificationTime(const std::filesystem::path& path, std::int64_t& lastWriteTime);
+
+    static bool setModificationTime(const std::filesystem::path& path, std::int64_t lastWriteTime);
+    /**
+     * @brief Modification time as file clock time, for comparing with times of other files
+     */
+    static std::filesystem::file_time_type toFileTime(std::int64_t lastWriteTime);
+#ifdef __linux__
+    static std::int64_t getModificationTime(const struct stat& status);
+#endif
+};
\ No newline at end of file
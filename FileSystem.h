@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include "FileMetadata.h"
+/**
+ * @brief File system operations backup logic goes through, so it can run against storage other than the real one
+ * Modification times are in the unit of FileTime::getModificationTime (nanoseconds on Linux, file clock ticks elsewhere).
+ * Implementations are used by several threads at once.
+ */
+class FileSystem
+{
+public:
+    enum class FileType
+    {
+        NotFound,
+        Regular,
+        Directory,
+        Other
+    };
+    /**
+     * @brief Metadata of a file or folder, symlinks are resolved
+     */
+    struct Status
+    {
+        FileType type = FileType::NotFound;
+        std::uintmax_t size = 0;
+        std::int64_t modificationTime = 0;
+    };
+    /**
+     * @brief Depth-first walk through a folder tree, contents of a folder follow right after it
+     */
+    class Walker
+    {
+    public:
+        virtual ~Walker() = default;
+        /**
+         * @brief Move to next entry, contents of a folder follow right after it unless disableRecursionPending is called
+         * @return false: no more entries
+         */
+        virtual bool next() = 0;
+        /**
+         * @brief Do not descend into current folder
+         */
+        virtual void disableRecursionPending() = 0;
+        /**
+         * @brief File or folder name of current entry
+         */
+        virtual std::string_view getName() const = 0;
+        /**
+         * @brief Path of current entry relative to root with '/' separators
+         */
+        virtual std::string_view getRelativePath() const = 0;
+        /**
+         * @brief 0 for entries directly in root
+         */
+        virtual std::size_t getDepth() const = 0;
+
+        virtual bool isDirectory() const = 0;
+
+        virtual bool isRegularFile() const = 0;
+        /**
+         * @brief Full path of current entry, allocates
+         */
+        virtual std::filesystem::path getPath() const = 0;
+        /**
+         * @return false: entry vanished or is not accessible
+         */
+        virtual bool getStatus(Status& status) const = 0;
+        /**
+         * @brief Last call of next could not open the folder it was to descend into, the entry current before that call
+         * Contents of that folder are missing from the walk, the rest of the tree is still visited.
+         */
+        virtual bool hasOpenFailed() const = 0;
+        /**
+         * @brief Root could not be opened or walk ended early, entries not visited may still exist
+         */
+        virtual bool isIncomplete() const = 0;
+    };
+
+    virtual ~FileSystem() = default;
+    /**
+     * @return false: path does not exist (type is NotFound, errorCode is not set) or can not be read (errorCode is set)
+     */
+    virtual bool getStatus(const std::filesystem::path& path, Status& status, std::error_code& errorCode) const = 0;
+    /**
+     * @brief Same as above for path kept in a reused buffer, looking it up does not allocate
+     */
+    virtual bool getStatus(const std::string& path, Status& status, std::error_code& errorCode) const = 0;
+    /**
+     * @brief Walk through folder tree below root, root itself is not visited
+     * @param memory: resource for buffers of the walk, for example a per pass arena
+     */
+    virtual std::unique_ptr<Walker> walk(const std::filesystem::path& root, std::pmr::memory_resource* memory) const = 0;
+    /**
+     * @brief Create folder and every missing folder above it
+     */
+    virtual bool createDirectories(const std::filesystem::path& path, std::error_code& errorCode) const = 0;
+    /**
+     * @brief Give everyone every permission
+     */
+    virtual void setPermissions(const std::filesystem::path& path, std::error_code& errorCode) const = 0;
+    /**
+     * @brief Remove file or empty folder
+     * @return false: nothing was removed
+     */
+    virtual bool remove(const std::filesystem::path& path, std::error_code& errorCode) const = 0;
+    /**
+     * @brief Move file to another name, file already there is replaced
+     */
+    virtual void rename(const std::filesystem::path& source, const std::filesystem::path& destination,
+        std::error_code& errorCode) const = 0;
+
+    virtual void setModificationTime(const std::filesystem::path& path, std::int64_t modificationTime,
+        std::error_code& errorCode) const = 0;
+    /**
+     * @brief Copy file contents, file already at destination is replaced atomically once the copy is complete
+     * Destination never shows a partial copy, a failed copy leaves the previous file in place.
+     * @param stats: filled with logical and physical size of the copy and checksum when computed
+     * @return false: copy failed, errorCode holds the reason
+     */
+    virtual bool copyFile(const std::filesystem::path& source, const std::filesystem::path& destination,
+        CopyStats& stats, std::error_code& errorCode) const = 0;
+    /**
+     * @brief Read whole file into content, content keeps its capacity
+     */
+    virtual bool readFile(const std::filesystem::path& path, std::string& content, std::error_code& errorCode) const = 0;
+};
\ No newline at end of file
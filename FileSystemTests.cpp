@@ -0,0 +1,194 @@
+#include "Tests.h"
+#include "DirectoryWalker.h"
+#include "MemoryFileSystem.h"
+#include "NativeFileSystem.h"
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+    /**
+     * @brief Entries of a walk as "depth path/" for folders and "depth path size" for files
+     * @param pruned: folder whose contents are not visited
+     */
+    vector<string> walkTree(FileSystem::Walker& walker, const string& pruned = {})
+    {
+        vector<string> entries;
+        FileSystem::Status status;
+        while (walker.next())
+        {
+            auto entry = to_string(walker.getDepth()) + " " + string(walker.getRelativePath());
+            if (walker.isDirectory())
+            {
+                entry += "/";
+                if (walker.getRelativePath() == pruned)
+                {
+                    walker.disableRecursionPending();
+                }
+            }
+            else
+            {
+                CHECK(walker.getStatus(status) && walker.isRegularFile());
+                entry += " " + to_string(status.size);
+            }
+            CHECK(walker.getPath().filename().string() == walker.getName());
+            entries.push_back(entry);
+        }
+        CHECK(!walker.isIncomplete());
+        return entries;
+    }
+
+    const vector<pair<string, uintmax_t>> TreeFiles{{"a.txt", 1}, {"b/c.txt", 22}, {"b/d/e.txt", 333}, {"b/d/f.txt", 4},
+        {"g/h.txt", 55}, {"g/i/j/k.txt", 6}};
+
+    void createTree(const fs::path& root, MemoryFileSystem* memory)
+    {
+        for (const auto& [path, size] : TreeFiles)
+        {
+            if (memory)
+            {
+                memory->writeFile(root / path, size);
+            }
+            else
+            {
+                fs::create_directories((root / path).parent_path());
+                ofstream(root / path) << string(size, 'x');
+            }
+        }
+    }
+}
+
+TEST(DirectoryWalkerMatchesRecursiveDirectoryIterator)
+{
+    const auto root = TestRegistry::makeTempFolder("walker_native");
+    createTree(root, nullptr);
+
+    vector<string> expected;
+    vector<string> expectedPruned;
+    for (auto it = fs::recursive_directory_iterator(root); it != fs::recursive_directory_iterator(); ++it)
+    {
+        auto entry = to_string(it.depth()) + " " + fs::relative(it->path(), root).generic_string();
+        entry += it->is_directory() ? "/" : " " + to_string(it->file_size());
+        expected.push_back(entry);
+    }
+    for (auto it = fs::recursive_directory_iterator(root); it != fs::recursive_directory_iterator(); ++it)
+    {
+        const auto relative = fs::relative(it->path(), root).generic_string();
+        expectedPruned.push_back(to_string(it.depth()) + " " + relative + (it->is_directory() ? "/" : " " + to_string(it->file_size())));
+        if (relative == "b")
+        {
+            it.disable_recursion_pending();
+        }
+    }
+
+    pmr::monotonic_buffer_resource arena;
+    DirectoryWalker walker(root, &arena);
+    CHECK(walkTree(walker) == expected);
+    DirectoryWalker prunedWalker(root, &arena);
+    CHECK(walkTree(prunedWalker, "b") == expectedPruned);
+    CHECK(expected.size() == 11 && expectedPruned.size() == 7);
+}
+
+TEST(MemoryFileSystemWalksLikeNativeOne)
+{
+    const auto root = TestRegistry::makeTempFolder("walker_memory");
+    createTree(root, nullptr);
+    MemoryFileSystem memory;
+    createTree(root, &memory);
+
+    pmr::monotonic_buffer_resource arena;
+    auto memoryWalker = memory.walk(root, &arena);
+    const auto memoryEntries = walkTree(*memoryWalker);
+    //memory folders keep children sorted, depth first
+    CHECK(memoryEntries == (vector<string>{"0 a.txt 1", "0 b/", "1 b/c.txt 22", "1 b/d/", "2 b/d/e.txt 333", "2 b/d/f.txt 4",
+        "0 g/", "1 g/h.txt 55", "1 g/i/", "2 g/i/j/", "3 g/i/j/k.txt 6"}));
+    //root and every folder below it are listed
+    CHECK(memory.getOperationCount(MemoryFileSystem::Operation::List) == 6);
+
+    auto nativeEntries = walkTree(*NativeFileSystem::getInstance().walk(root, &arena));
+    sort(nativeEntries.begin(), nativeEntries.end());
+    auto sortedMemoryEntries = memoryEntries;
+    sort(sortedMemoryEntries.begin(), sortedMemoryEntries.end());
+    CHECK(nativeEntries == sortedMemoryEntries);
+
+    auto prunedWalker = memory.walk(root, &arena);
+    CHECK(walkTree(*prunedWalker, "g/i").size() == 9);
+}
+
+TEST(MemoryFileSystemReportsUnreadableFolder)
+{
+    MemoryFileSystem memory;
+    const fs::path root{"/hot"};
+    createTree(root, &memory);
+    memory.setUnreadable(root / "b", true);
+
+    pmr::monotonic_buffer_resource arena;
+    auto walker = memory.walk(root, &arena);
+    vector<string> visited;
+    bool openFailed = false;
+    while (walker->next())
+    {
+        openFailed = openFailed || walker->hasOpenFailed();
+        visited.emplace_back(walker->getRelativePath());
+    }
+    CHECK(openFailed);
+    CHECK(visited == (vector<string>{"a.txt", "b", "g", "g/h.txt", "g/i", "g/i/j", "g/i/j/k.txt"}));
+
+    FileSystem::Status status;
+    error_code ec;
+    CHECK(memory.getStatus(root / "b" / "c.txt", status, ec) && status.size == 22);
+    CHECK(memory.walk(root / "missing", &arena)->isIncomplete());
+}
+
+TEST(MemoryFileSystemLatencyOverlapsBetweenThreads)
+{
+    MemoryFileSystem memory;
+    memory.writeFile("/hot/file.txt", 10);
+    memory.setLatency(MemoryFileSystem::Operation::Status, chrono::milliseconds(50));
+
+    const auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int i = 0; i < 8; i++)
+    {
+        threads.emplace_back([&memory]()
+        {
+            FileSystem::Status status;
+            error_code ec;
+            CHECK(memory.getStatus(fs::path("/hot/file.txt"), status, ec) && status.size == 10);
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    const auto elapsed = chrono::steady_clock::now() - start;
+
+    CHECK(memory.getOperationCount(MemoryFileSystem::Operation::Status) == 8);
+    //every call waits its delay, but not behind the others
+    CHECK(elapsed >= chrono::milliseconds(50));
+    CHECK(elapsed < chrono::milliseconds(8 * 50));
+}
+
+TEST(MemoryFileSystemUpdatesFolderTimes)
+{
+    MemoryFileSystem memory;
+    memory.writeFile("/hot/a.txt", 1);
+    FileSystem::Status folder;
+    error_code ec;
+    CHECK(memory.getStatus(fs::path("/hot"), folder, ec) && folder.type == FileSystem::FileType::Directory);
+    const auto created = folder.modificationTime;
+
+    this_thread::sleep_for(chrono::milliseconds(2));
+    memory.rename("/hot/a.txt", "/hot/b.txt", ec);
+    CHECK(!ec);
+    CHECK(memory.getStatus(fs::path("/hot"), folder, ec) && folder.modificationTime > created);
+
+    FileSystem::Status file;
+    CHECK(!memory.getStatus(fs::path("/hot/a.txt"), file, ec) && file.type == FileSystem::FileType::NotFound);
+    CHECK(memory.remove("/hot/b.txt", ec));
+    CHECK(!memory.getStatus(fs::path("/hot/b.txt"), file, ec));
+}
\ No newline at end of file
@@ -7,11 +7,32 @@ unique_ptr<GlobalData> GlobalData::s_instance = nullptr;
 const fs::path GlobalData::BackupExtension{".bak"};
 const string GlobalData::DeletePrefix{"delete_"};
 const size_t GlobalData::DeletePrefixSize{DeletePrefix.size()};
+const fs::path GlobalData::PartialExtension{".part"};
+const fs::path GlobalData::ChecksumFileName{"FolderBackupChecksums.txt"};
+const fs::path GlobalData::QuarantineFolderName{"FolderBackupOrphans"};
 
 GlobalData::GlobalData(optional<const string> hotFolderPath,
     optional<const string> backupFolderPath) :
     m_hotFolderDir{},
-    m_backupFolderDir{}
+    m_backupFolderDir{},
+    m_largeFileThreshold{256 * 1024 * 1024},
+    m_packThreshold{0},
+    m_copyThreads{4},
+    m_backupThreads{2},
+    m_latencyLaneThreshold{1024 * 1024},
+    m_pollMaxInterval{1},
+    m_pollBudget{0},
+    m_orphanMode{OrphanMode::Off},
+    m_orphanBatch{100},
+    m_logRecordCapacity{100000},
+    m_directIoEnabled{false},
+    m_checksumEnabled{true},
+    m_metricsFilePath{},
+    m_metricsInterval{15},
+    m_traceFilePath{},
+    m_filterRules{},
+    m_daemonMode{false},
+    m_socketPath{"FolderBackup.sock"}
 {
     if (hotFolderPath)
     {
@@ -66,4 +87,184 @@ void GlobalData::updatePaths()
 {
     m_hotFolderDir.refresh();
     m_backupFolderDir.refresh();
+}
+
+uintmax_t GlobalData::getLargeFileThreshold() const
+{
+    return m_largeFileThreshold;
+}
+
+void GlobalData::setLargeFileThreshold(uintmax_t threshold)
+{
+    m_largeFileThreshold = threshold;
+}
+
+uintmax_t GlobalData::getPackThreshold() const
+{
+    return m_packThreshold;
+}
+
+void GlobalData::setPackThreshold(uintmax_t threshold)
+{
+    m_packThreshold = threshold;
+}
+
+unsigned int GlobalData::getCopyThreads() const
+{
+    return m_copyThreads;
+}
+
+void GlobalData::setCopyThreads(unsigned int threads)
+{
+    m_copyThreads = threads > 0 ? threads : 1;
+}
+
+unsigned int GlobalData::getBackupThreads() const
+{
+    return m_backupThreads;
+}
+
+void GlobalData::setBackupThreads(unsigned int threads)
+{
+    m_backupThreads = threads > 0 ? threads : 1;
+}
+
+uintmax_t GlobalData::getLatencyLaneThreshold() const
+{
+    return m_latencyLaneThreshold;
+}
+
+void GlobalData::setLatencyLaneThreshold(uintmax_t threshold)
+{
+    m_latencyLaneThreshold = threshold;
+}
+
+chrono::seconds GlobalData::getPollMaxInterval() const
+{
+    return m_pollMaxInterval;
+}
+
+void GlobalData::setPollMaxInterval(chrono::seconds interval)
+{
+    m_pollMaxInterval = interval;
+}
+
+uint64_t GlobalData::getPollBudget() const
+{
+    return m_pollBudget;
+}
+
+void GlobalData::setPollBudget(uint64_t budget)
+{
+    m_pollBudget = budget;
+}
+
+GlobalData::OrphanMode GlobalData::getOrphanMode() const
+{
+    return m_orphanMode;
+}
+
+void GlobalData::setOrphanMode(OrphanMode mode)
+{
+    m_orphanMode = mode;
+}
+
+size_t GlobalData::getOrphanBatch() const
+{
+    return m_orphanBatch;
+}
+
+void GlobalData::setOrphanBatch(size_t batch)
+{
+    m_orphanBatch = batch;
+}
+
+size_t GlobalData::getLogRecordCapacity() const
+{
+    return m_logRecordCapacity;
+}
+
+void GlobalData::setLogRecordCapacity(size_t capacity)
+{
+    m_logRecordCapacity = capacity;
+}
+
+bool GlobalData::isDirectIoEnabled() const
+{
+    return m_directIoEnabled;
+}
+
+void GlobalData::setDirectIoEnabled(bool enabled)
+{
+    m_directIoEnabled = enabled;
+}
+
+bool GlobalData::isChecksumEnabled() const
+{
+    return m_checksumEnabled;
+}
+
+void GlobalData::setChecksumEnabled(bool enabled)
+{
+    m_checksumEnabled = enabled;
+}
+
+const fs::path& GlobalData::getMetricsFilePath() const
+{
+    return m_metricsFilePath;
+}
+
+void GlobalData::setMetricsFilePath(const fs::path& path)
+{
+    m_metricsFilePath = path;
+}
+
+chrono::seconds GlobalData::getMetricsInterval() const
+{
+    return m_metricsInterval;
+}
+
+void GlobalData::setMetricsInterval(chrono::seconds interval)
+{
+    m_metricsInterval = interval.count() > 0 ? interval : chrono::seconds(1);
+}
+
+const fs::path& GlobalData::getTraceFilePath() const
+{
+    return m_traceFilePath;
+}
+
+void GlobalData::setTraceFilePath(const fs::path& path)
+{
+    m_traceFilePath = path;
+}
+
+const vector<PathFilter::Rule>& GlobalData::getFilterRules() const
+{
+    return m_filterRules;
+}
+
+void GlobalData::addFilterRule(const PathFilter::Rule& rule)
+{
+    m_filterRules.push_back(rule);
+}
+
+bool GlobalData::isDaemonMode() const
+{
+    return m_daemonMode;
+}
+
+void GlobalData::setDaemonMode(bool enabled)
+{
+    m_daemonMode = enabled;
+}
+
+const fs::path& GlobalData::getSocketPath() const
+{
+    return m_socketPath;
+}
+
+void GlobalData::setSocketPath(const fs::path& path)
+{
+    m_socketPath = path;
 }
\ No newline at end of file
@@ -3,10 +3,23 @@
 #include <memory>
 #include <filesystem>
 #include <optional>
+#include <cstdint>
+#include <chrono>
+#include <vector>
+#include "PathFilter.h"
 
 class GlobalData
 {
 public:
+    /**
+     * @brief What happens to backups whose file is no longer in hot folder
+     */
+    enum class OrphanMode
+    {
+        Off,
+        Remove,
+        Quarantine
+    };
     /**
      * @brief Creates if not already created and returns reference to GlobalData instance
      * @note First call initializes it and should provide the required paths
@@ -37,6 +50,109 @@ public:
 
     void updatePaths();
 
+    /**
+     * @brief Files of this size or bigger are copied by several workers in parallel
+     */
+    std::uintmax_t getLargeFileThreshold() const;
+
+    void setLargeFileThreshold(std::uintmax_t threshold);
+    /**
+     * @brief Files smaller than this are appended into pack files instead of own backup files, 0 disables packing
+     */
+    std::uintmax_t getPackThreshold() const;
+
+    void setPackThreshold(std::uintmax_t threshold);
+    /**
+     * @brief Amount of workers used to copy a single large file
+     */
+    unsigned int getCopyThreads() const;
+
+    void setCopyThreads(unsigned int threads);
+    /**
+     * @brief Amount of workers backing up files found by a pass, one of them is always left for small files
+     */
+    unsigned int getBackupThreads() const;
+
+    void setBackupThreads(unsigned int threads);
+    /**
+     * @brief Files smaller than this go to latency lane of backup scheduler, others to bulk lane
+     */
+    std::uintmax_t getLatencyLaneThreshold() const;
+
+    void setLatencyLaneThreshold(std::uintmax_t threshold);
+    /**
+     * @brief Longest time a folder without changes goes unchecked, default of 1 s checks every folder on every pass
+     */
+    std::chrono::seconds getPollMaxInterval() const;
+
+    void setPollMaxInterval(std::chrono::seconds interval);
+    /**
+     * @brief Files checked per second by passes, due folders over it are checked a pass later, 0 for unlimited
+     */
+    std::uint64_t getPollBudget() const;
+
+    void setPollBudget(std::uint64_t budget);
+
+    OrphanMode getOrphanMode() const;
+
+    void setOrphanMode(OrphanMode mode);
+    /**
+     * @brief Orphaned backups removed or quarantined after a pass at most, others wait for next passes
+     */
+    std::size_t getOrphanBatch() const;
+
+    void setOrphanBatch(std::size_t batch);
+    /**
+     * @brief Newest log records kept in memory for searches, older ones are read from log file
+     */
+    std::size_t getLogRecordCapacity() const;
+
+    void setLogRecordCapacity(std::size_t capacity);
+    /**
+     * @brief When enabled large files are copied bypassing page cache (O_DIRECT)
+     */
+    bool isDirectIoEnabled() const;
+
+    void setDirectIoEnabled(bool enabled);
+    /**
+     * @brief When enabled CRC32C of every backup is computed while copying and stored in checksum manifest
+     */
+    bool isChecksumEnabled() const;
+
+    void setChecksumEnabled(bool enabled);
+    /**
+     * @brief File periodically rewritten with metrics in Prometheus text format, empty when disabled
+     */
+    const std::filesystem::path& getMetricsFilePath() const;
+
+    void setMetricsFilePath(const std::filesystem::path& path);
+
+    std::chrono::seconds getMetricsInterval() const;
+
+    void setMetricsInterval(std::chrono::seconds interval);
+    /**
+     * @brief Chrome trace file written on exit and on request, empty when tracing is disabled
+     */
+    const std::filesystem::path& getTraceFilePath() const;
+
+    void setTraceFilePath(const std::filesystem::path& path);
+    /**
+     * @brief Include/exclude rules applied to entries of hot folder, in the order they were given
+     */
+    const std::vector<PathFilter::Rule>& getFilterRules() const;
+
+    void addFilterRule(const PathFilter::Rule& rule);
+    /**
+     * @brief In daemon mode there is no menu, application is controlled over Unix domain socket
+     */
+    bool isDaemonMode() const;
+
+    void setDaemonMode(bool enabled);
+
+    const std::filesystem::path& getSocketPath() const;
+
+    void setSocketPath(const std::filesystem::path& path);
+
     constexpr const std::filesystem::path& getBackupExtension()
     {
         return BackupExtension;
@@ -51,6 +167,23 @@ public:
     {
         return DeletePrefixSize;
     }
+
+    constexpr const std::filesystem::path& getPartialExtension()
+    {
+        return PartialExtension;
+    }
+
+    constexpr const std::filesystem::path& getChecksumFileName()
+    {
+        return ChecksumFileName;
+    }
+    /**
+     * @brief Folder inside backup folder where quarantined orphans are moved
+     */
+    constexpr const std::filesystem::path& getQuarantineFolderName()
+    {
+        return QuarantineFolderName;
+    }
 protected:
     GlobalData(std::optional<const std::string> hotFolderPath = std::nullopt,
         std::optional<const std::string> backupFolderPath = std::nullopt);
@@ -59,8 +192,29 @@ private:
 
     std::filesystem::directory_entry m_hotFolderDir;
     std::filesystem::directory_entry m_backupFolderDir;
+    std::uintmax_t m_largeFileThreshold;
+    std::uintmax_t m_packThreshold;
+    unsigned int m_copyThreads;
+    unsigned int m_backupThreads;
+    std::uintmax_t m_latencyLaneThreshold;
+    std::chrono::seconds m_pollMaxInterval;
+    std::uint64_t m_pollBudget;
+    OrphanMode m_orphanMode;
+    std::size_t m_orphanBatch;
+    std::size_t m_logRecordCapacity;
+    bool m_directIoEnabled;
+    bool m_checksumEnabled;
+    std::filesystem::path m_metricsFilePath;
+    std::chrono::seconds m_metricsInterval;
+    std::filesystem::path m_traceFilePath;
+    std::vector<PathFilter::Rule> m_filterRules;
+    bool m_daemonMode;
+    std::filesystem::path m_socketPath;
 
     static const std::filesystem::path BackupExtension;
     static const std::string DeletePrefix;
     static const std::size_t DeletePrefixSize;
+    static const std::filesystem::path PartialExtension;
+    static const std::filesystem::path ChecksumFileName;
+    static const std::filesystem::path QuarantineFolderName;
 };
\ No newline at end of file
@@ -1,11 +1,16 @@
 #include "LogUtility.h"
+#include "Metrics.h"
+#include "Tracer.h"
+#include "TimestampFormatter.h"
+#include "GlobalData.h"
+#include "Crc32c.h"
 #include <fstream>
 #include <chrono>
 #include <thread>
-
-#ifdef _MSC_VER
-#include <format>
-#endif
+#include <algorithm>
+#include <string_view>
+#include <regex>
+#include <filesystem>
 
 using namespace std;
 namespace fs = std::filesystem;
@@ -13,17 +18,117 @@ namespace fs = std::filesystem;
 queue<string> LogUtility::s_writeQueue{};
 std::mutex LogUtility::s_writeQueueMutex{};
 std::mutex LogUtility::s_fileOperationMutex{};
+const string LogUtility::IndexMagic{"FolderBackupLogIndex1"};
+
+namespace
+{
+    /**
+     * @brief Timestamp at the start of log record, records are written in its order
+     */
+    string_view recordTimestamp(const string& record)
+    {
+        const string_view view{record};
+        return view.substr(0, view.find(' '));
+    }
+    /**
+     * @brief Paths mentioned by record written by LogWriter: "<timestamp> <path><action>[<destination>]"
+     * @param destination: empty for actions other than backup and move
+     */
+    void recordPaths(string_view record, string_view& path, string_view& destination)
+    {
+        static constexpr string_view TwoPathActions[]{" was backed up to: ", " was moved to: "};
+        static constexpr string_view OtherActions[]{" was deleted", " was updated", " was created"};
+
+        path = {};
+        destination = {};
+        const auto start = record.find(' ');
+        if (start == string_view::npos)
+        {
+            return;
+        }
+        record.remove_prefix(start + 1);
+
+        for (const auto action : TwoPathActions)
+        {
+            const auto position = record.find(action);
+            if (position != string_view::npos)
+            {
+                path = record.substr(0, position);
+                destination = record.substr(position + action.size());
+                return;
+            }
+        }
+
+        for (const auto action : OtherActions)
+        {
+            if (record.size() > action.size() && record.substr(record.size() - action.size()) == action)
+            {
+                path = record.substr(0, record.size() - action.size());
+                return;
+            }
+        }
+    }
+    /**
+     * @brief Checksum of the start of log, tells whether stored path index was built from this log
+     * @param indexedEnd: end of last indexed record, it has to be the end of a line
+     * @return false: log is shorter or indexedEnd is not at a line end
+     */
+    bool getLogFingerprint(const string& logFileName, uint64_t indexedEnd, uint32_t& fingerprint)
+    {
+        static constexpr uint64_t FingerprintLength = 4096;
+
+        fingerprint = 0;
+        if (indexedEnd == 0)
+        {
+            return true;
+        }
+
+        ifstream logFile(logFileName, fstream::in | fstream::binary);
+        string data(static_cast<size_t>(min(indexedEnd, FingerprintLength)), '\0');
+        if (!logFile.read(data.data(), static_cast<streamsize>(data.size())))
+        {
+            return false;
+        }
+        fingerprint = Crc32c::update(0, data.data(), data.size());
+
+        char lastCharacter = 0;
+        logFile.seekg(static_cast<streamoff>(indexedEnd - 1));
+        return logFile.get(lastCharacter) && lastCharacter == '\n';
+    }
+    /**
+     * @brief Strip line end written on Windows, log is read in binary mode to keep offsets exact
+     */
+    void trimLineEnd(string& line)
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+    }
+}
 
 LogUtility::LogUtility():
     m_isThreadStopRequested(false),
     LogFileName("FolderBackupLog.txt"),
-    m_logWriter()
+    IndexFileName("FolderBackupLog.idx"),
+    m_logWriter(),
+    m_recordsMutex{},
+    m_records{},
+    m_recordOffsets{},
+    m_pathIndex{},
+    m_droppedRecords(0),
+    m_recordsInTimeOrder(true),
+    m_recordCapacity(GlobalData::getInstance().getLogRecordCapacity()),
+    m_logFileEnd(0),
+    m_indexedEnd(0)
 {
+    loadRecentRecords();
 }
 
 LogUtility::~LogUtility()
 {
     m_isThreadStopRequested.store(true);
+    savePathIndex();
 }
 
 void LogUtility::stopThreads()
@@ -31,8 +136,285 @@ void LogUtility::stopThreads()
     m_isThreadStopRequested.store(true);
 }
 
+size_t LogUtility::getQueueSize() const
+{
+    lock_guard<mutex> lock(s_writeQueueMutex);
+    return s_writeQueue.size();
+}
+
+void LogUtility::loadRecentRecords()
+{
+    lock_guard<mutex> fileLock(s_fileOperationMutex);
+
+    //last line may miss its line end, so new records start at real end of file
+    error_code errorCode;
+    const auto fileSize = fs::file_size(LogFileName, errorCode);
+    m_logFileEnd = errorCode ? 0 : fileSize;
+
+    //with a stored index only records kept in memory by previous run and those written after it are read
+    uint64_t offset = 0;
+    if (!loadPathIndex(offset))
+    {
+        m_pathIndex.clear();
+        m_indexedEnd = 0;
+        m_droppedRecords = 0;
+        offset = 0;
+    }
+
+    ifstream logFile(LogFileName, fstream::in | fstream::binary);
+    logFile.seekg(static_cast<streamoff>(offset));
+    string line;
+    while (getline(logFile, line))
+    {
+        const auto lineLength = line.size() + 1;
+        trimLineEnd(line);
+        if (!line.empty())
+        {
+            addRecentRecord(line, offset, offset + lineLength);
+        }
+        offset += lineLength;
+    }
+}
+
+bool LogUtility::loadPathIndex(uint64_t& memoryStart)
+{
+    ifstream indexFile(IndexFileName, fstream::in | fstream::binary);
+    string magic(IndexMagic.size(), '\0');
+    uint64_t header[4]{};
+    if (!indexFile.read(magic.data(), static_cast<streamsize>(magic.size())) || magic != IndexMagic ||
+        !indexFile.read(reinterpret_cast<char*>(header), sizeof(header)))
+    {
+        return false;
+    }
+
+    const auto [indexedEnd, recordsStart, droppedRecords, fingerprint] = header;
+    //log was replaced or cut since index was written
+    uint32_t logFingerprint = 0;
+    if (indexedEnd > m_logFileEnd || recordsStart > indexedEnd ||
+        !getLogFingerprint(LogFileName, indexedEnd, logFingerprint) || logFingerprint != fingerprint)
+    {
+        return false;
+    }
+
+    if (!m_pathIndex.read(indexFile))
+    {
+        return false;
+    }
+    m_indexedEnd = indexedEnd;
+    m_droppedRecords = static_cast<size_t>(droppedRecords);
+    memoryStart = recordsStart;
+    return true;
+}
+
+void LogUtility::savePathIndex() const
+{
+    const string temporaryName = IndexFileName + ".tmp";
+    {
+        shared_lock<shared_mutex> lock(m_recordsMutex);
+        uint32_t fingerprint = 0;
+        //without any record there is no log to go with the index
+        if (m_indexedEnd == 0 || !getLogFingerprint(LogFileName, m_indexedEnd, fingerprint))
+        {
+            return;
+        }
+
+        const uint64_t header[4]{m_indexedEnd, m_recordOffsets.empty() ? m_indexedEnd : m_recordOffsets.front(),
+            m_droppedRecords, fingerprint};
+        ofstream indexFile(temporaryName, fstream::trunc | fstream::binary);
+        indexFile.write(IndexMagic.data(), static_cast<streamsize>(IndexMagic.size()));
+        indexFile.write(reinterpret_cast<const char*>(header), sizeof(header));
+        m_pathIndex.write(indexFile);
+        indexFile.flush();
+        if (!indexFile)
+        {
+            error_code ec;
+            fs::remove(temporaryName, ec);
+            return;
+        }
+    }
+
+    //index is only a cache, a failed write leaves the previous one, which next run checks against the log
+    error_code ec;
+    fs::rename(temporaryName, IndexFileName, ec);
+}
+
+void LogUtility::addRecentRecord(const string& record, uint64_t offset, uint64_t end) const
+{
+    unique_lock<shared_mutex> lock(m_recordsMutex);
+
+    if (!m_records.empty() && recordTimestamp(record) < recordTimestamp(m_records.back()))
+    {
+        m_recordsInTimeOrder = false;
+    }
+
+    //path index covers whole log, dropping records from memory does not touch it
+    if (offset >= m_indexedEnd)
+    {
+        string_view path;
+        string_view destination;
+        recordPaths(record, path, destination);
+        if (!path.empty())
+        {
+            m_pathIndex.addPath(path, offset);
+        }
+        if (!destination.empty())
+        {
+            m_pathIndex.addPath(destination, offset);
+        }
+        m_indexedEnd = end;
+    }
+
+    m_records.push_back(record);
+    m_recordOffsets.push_back(offset);
+    if (m_records.size() > m_recordCapacity)
+    {
+        m_records.pop_front();
+        m_recordOffsets.pop_front();
+        m_droppedRecords++;
+    }
+}
+
+size_t LogUtility::getRecordCount() const
+{
+    shared_lock<shared_mutex> lock(m_recordsMutex);
+    return m_records.size();
+}
+
+void LogUtility::searchLogByTime(const string& timestampPrefix, const function<void(const string&)>& func) const
+{
+    auto startsWithPrefix = [&timestampPrefix](const string& record)
+    {
+        return record.compare(0, timestampPrefix.size(), timestampPrefix) == 0;
+    };
+
+    //matches are copied out, so a slow caller (a client socket) does not hold up threads adding records
+    vector<string> matches;
+    bool found = false;
+    {
+        shared_lock<shared_mutex> lock(m_recordsMutex);
+        if (m_droppedRecords == 0 && m_recordsInTimeOrder)
+        {
+            //records with the prefix form one run starting at the first record not older than prefix
+            const auto first = lower_bound(m_records.begin(), m_records.end(), timestampPrefix,
+                [](const string& record, const string& prefix) { return recordTimestamp(record) < prefix; });
+            for (auto record = first; record != m_records.end() && startsWithPrefix(*record); ++record)
+            {
+                matches.push_back(*record);
+            }
+            found = true;
+        }
+    }
+    if (found)
+    {
+        for (const auto& record : matches)
+        {
+            func(record);
+        }
+        return;
+    }
+
+    searchLog([&](const string& record)
+    {
+        if (startsWithPrefix(record))
+        {
+            func(record);
+        }
+    });
+}
+
+void LogUtility::searchLogByFileName(const string& text, const function<void(const string&)>& func) const
+{
+    vector<uint64_t> offsets;
+    {
+        shared_lock<shared_mutex> lock(m_recordsMutex);
+        m_pathIndex.findBySubstring(text, offsets);
+    }
+    readRecords(offsets, func);
+}
+
+bool LogUtility::searchLogByFileNameRegex(const string& pattern, const function<void(const string&)>& func) const
+{
+    regex searchRegex;
+    try
+    {
+        searchRegex.assign(pattern);
+    }
+    catch (const exception&)
+    {
+        return false;
+    }
+
+    vector<uint64_t> offsets;
+    {
+        shared_lock<shared_mutex> lock(m_recordsMutex);
+        m_pathIndex.findByRegex(searchRegex, pattern, offsets);
+    }
+    readRecords(offsets, func);
+    return true;
+}
+
+void LogUtility::readRecords(const vector<uint64_t>& offsets, const function<void(const string&)>& func) const
+{
+    auto firstKept = offsets.end();
+    vector<string> keptRecords;
+    {
+        shared_lock<shared_mutex> lock(m_recordsMutex);
+        if (!m_recordOffsets.empty())
+        {
+            //every indexed record from the oldest one in memory onwards is still in memory
+            firstKept = lower_bound(offsets.begin(), offsets.end(), m_recordOffsets.front());
+        }
+        for (auto offset = firstKept; offset != offsets.end(); ++offset)
+        {
+            const auto position = lower_bound(m_recordOffsets.begin(), m_recordOffsets.end(), *offset);
+            keptRecords.push_back(m_records[static_cast<size_t>(position - m_recordOffsets.begin())]);
+        }
+    }
+
+    if (firstKept != offsets.begin())
+    {
+        ifstream logFile(LogFileName, fstream::in | fstream::binary);
+        string line;
+        for (auto offset = offsets.begin(); offset != firstKept; ++offset)
+        {
+            logFile.clear();
+            logFile.seekg(static_cast<streamoff>(*offset));
+            if (getline(logFile, line))
+            {
+                trimLineEnd(line);
+                func(line);
+            }
+        }
+    }
+
+    for (const auto& record : keptRecords)
+    {
+        func(record);
+    }
+}
+
 void LogUtility::searchLog(const std::function<void(const string&)>& func) const
 {
+    //records are copied out, so a slow caller (a client socket) does not hold up threads adding records
+    vector<string> records;
+    bool inMemory = false;
+    {
+        shared_lock<shared_mutex> lock(m_recordsMutex);
+        if (m_droppedRecords == 0)
+        {
+            records.assign(m_records.begin(), m_records.end());
+            inMemory = true;
+        }
+    }
+    if (inMemory)
+    {
+        for (const auto& record : records)
+        {
+            func(record);
+        }
+        return;
+    }
+
     ifstream logFile;
     logFile.open(LogFileName, fstream::in);
 
@@ -66,6 +448,8 @@ void LogUtility::safelyReadLastLineFromFile(string& singleMessage, std::ifstream
 
 void LogUtility::writeToFileThread() const
 {
+    Tracer::getInstance().setThreadName("log writer");
+
     while (true)
     {
         if (m_isThreadStopRequested.load())
@@ -108,6 +492,7 @@ bool LogUtility::readMessageFromQueue(string& singleMessage) const
 
     singleMessage = s_writeQueue.front();
     s_writeQueue.pop();
+    Metrics::getInstance().setGauge(Metrics::Gauge::LogQueueDepth, static_cast<int64_t>(s_writeQueue.size()));
     s_writeQueueMutex.unlock();
 
     return true;
@@ -115,6 +500,8 @@ bool LogUtility::readMessageFromQueue(string& singleMessage) const
 
 bool LogUtility::writeSingleMessageToFile(std::string& singleMessage) const
 {
+    TraceSpan span("writeSingleMessageToFile");
+
     std::ofstream logFile;
 
     if (!s_fileOperationMutex.try_lock())
@@ -122,28 +509,35 @@ bool LogUtility::writeSingleMessageToFile(std::string& singleMessage) const
         return false;
     }
 
-    logFile.open(LogFileName, fstream::app);
-    logFile << singleMessage.c_str() << endl;
+    //record starts where the previous one ended, binary mode keeps line end a single byte on every platform
+    const uint64_t offset = m_logFileEnd;
+
+    logFile.open(LogFileName, fstream::app | fstream::binary);
+    logFile << singleMessage << '\n';
     logFile.close();
+    if (logFile)
+    {
+        m_logFileEnd += singleMessage.size() + 1;
+    }
+    else
+    {
+        //part of the record may have made it to the file
+        error_code errorCode;
+        const auto fileSize = fs::file_size(LogFileName, errorCode);
+        m_logFileEnd = errorCode ? m_logFileEnd : fileSize;
+    }
     s_fileOperationMutex.unlock();
 
+    addRecentRecord(singleMessage, offset, offset + singleMessage.size() + 1);
+
     return true;
 }
 
-void LogUtility::LogWriter::getTimeString(std::string& string) const
+void LogUtility::LogWriter::appendTimeString(std::string& message) const
 {
-#ifdef _MSC_VER //version of method for MSVC compiler
-    auto now = chrono::floor<chrono::seconds>(chrono::system_clock::now());
-
-    string = std::format("{0:%F}T{0:%T%Ez}", now);
-#else //This version is for MINGW compiler
-    time_t now;
-    time(&now);
-    char buf[256];
-    strftime(buf, sizeof buf, "%Y-%m-%dT%H:%M:%S+00:00", gmtime(&now));
-    
-    string = buf;
-#endif
+    //cache of formatted second is kept per producer thread, so they do not contend for it
+    thread_local TimestampFormatter formatter;
+    formatter.append(message);
 }
 
 LogUtility::LogWriter& LogUtility::getLogWriter()
@@ -156,7 +550,8 @@ LogUtility::LogWriter::LogWriter():
     DeleteString(" was deleted"),
     BackupString{ " was backed up to: " },
     UpdateString{ " was updated" },
-    CreatedString{ " was created" }
+    CreatedString{ " was created" },
+    MoveString{ " was moved to: " }
 
 {
     
@@ -169,11 +564,15 @@ LogUtility::LogWriter::~LogWriter()
 
 void LogUtility::LogWriter::addMessageToLog(const string& path, Action action)
 {
+    const auto& actionString = actionToString(action);
     string message;
-    getTimeString(message);
-    message += " " + path + actionToString(action);
+    message.reserve(TimestampFormatter::Length + 1 + path.size() + actionString.size());
+    appendTimeString(message);
+    message += ' ';
+    message += path;
+    message += actionString;
 
-    addMessageToQueue(message);
+    addMessageToQueue(move(message));
 }
 
 void LogUtility::LogWriter::addMessageToLog(const string& source, const string& destination, Action action)
@@ -184,11 +583,16 @@ void LogUtility::LogWriter::addMessageToLog(const string& source, const string&
     }
     else
     {
+        const auto& actionString = actionToString(action);
         string message;
-        getTimeString(message);
-        message += " " + source + actionToString(action) + destination;
-        
-        addMessageToQueue(message);
+        message.reserve(TimestampFormatter::Length + 1 + source.size() + actionString.size() + destination.size());
+        appendTimeString(message);
+        message += ' ';
+        message += source;
+        message += actionString;
+        message += destination;
+
+        addMessageToQueue(move(message));
     }
 }
 
@@ -206,16 +610,23 @@ constexpr const std::string& LogUtility::LogWriter::actionToString(Action action
     {
         return CreatedString;
     }
+    else if (action == Action::Move)
+    {
+        return MoveString;
+    }
     return BackupString;
 }
 
-void LogUtility::LogWriter::addMessageToQueue(const std::string& message)
+void LogUtility::LogWriter::addMessageToQueue(string&& message)
 {
+    TraceSpan span("addMessageToQueue");
+
     while (true)
     {
         if (s_writeQueueMutex.try_lock())
         {
-            s_writeQueue.emplace(message);
+            s_writeQueue.emplace(move(message));
+            Metrics::getInstance().setGauge(Metrics::Gauge::LogQueueDepth, static_cast<int64_t>(s_writeQueue.size()));
             s_writeQueueMutex.unlock();
             return;
         }
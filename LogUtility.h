@@ -2,11 +2,19 @@
 
 #include <string>
 #include <queue>
+#include <deque>
 #include <mutex>
+#include <shared_mutex>
 #include <atomic>
 #include <functional>
+#include <vector>
+#include <cstdint>
+#include "PathIndex.h"
 /**
  * @brief Handles file read and write operations for log file
+ * Records are also kept in memory, so searches do not re-read the file while it covers whole log.
+ * Path index is stored next to the log on exit, next run reads only records it keeps in memory and
+ * those written since.
  */
 class LogUtility
 {
@@ -19,7 +27,8 @@ public:
         Delete,
         Backup,
         Update,
-        Created
+        Created,
+        Move
     };
     LogUtility(const LogUtility&) = delete;
     LogUtility& operator=(const LogUtility&) = delete;
@@ -30,10 +39,32 @@ public:
     ~LogUtility();
 
     /**
-     * @brief read log file and apply provided function to each line
+     * @brief apply provided function to each log line
+     * Lines come from memory, log file is read only when older records were dropped from memory.
+     * Function is not called under any lock, so it may block, for example on a client socket.
      * @param func: function to execute on log lines
      */
     void searchLog(const std::function<void(const std::string&)>& func) const;
+    /**
+     * @brief apply provided function to each log line whose timestamp starts with prefix
+     * Records are found by binary search as they are written in time order.
+     * @param timestampPrefix: for example 2023-02-12T12:20
+     */
+    void searchLogByTime(const std::string& timestampPrefix, const std::function<void(const std::string&)>& func) const;
+    /**
+     * @brief apply provided function to each log line mentioning a path which contains text
+     * Records are looked up in path index of whole log, only the matching ones are read.
+     */
+    void searchLogByFileName(const std::string& text, const std::function<void(const std::string&)>& func) const;
+    /**
+     * @brief apply provided function to each log line mentioning a path regex matches part of
+     * @return false: unsupported regex format
+     */
+    bool searchLogByFileNameRegex(const std::string& pattern, const std::function<void(const std::string&)>& func) const;
+    /**
+     * @brief amount of log records kept in memory
+     */
+    std::size_t getRecordCount() const;
     /**
      * @brief loop for writing queued messages to the end of log file
      */
@@ -42,6 +73,10 @@ public:
      * @brief: call to prepare threads for finishing
      */
     void stopThreads();
+    /**
+     * @brief amount of messages waiting to be written to log file
+     */
+    std::size_t getQueueSize() const;
     /**
      * @brief Class which handles writing to log file
      */
@@ -59,17 +94,44 @@ public:
         void addMessageToLog(const std::string& path, Action action);
         void addMessageToLog(const std::string& source, const std::string& destination, Action action);
     private:
-        void getTimeString(std::string& string) const;
+        /**
+         * @brief Append local time of record with milliseconds and offset from UTC, for example 2023-02-12T14:20:55.123+02:00
+         */
+        void appendTimeString(std::string& message) const;
         constexpr const std::string& actionToString(Action action);
-        void addMessageToQueue(const std::string& message);
+        void addMessageToQueue(std::string&& message);
         const std::string DeleteString;
         const std::string BackupString;
         const std::string UpdateString;
         const std::string CreatedString;
+        const std::string MoveString;
     };
 
     LogUtility::LogWriter& getLogWriter();
 private:
+    /**
+     * @brief Reads records written by previous runs, only the newest m_recordCapacity are kept
+     * Whole log is read only when there is no stored path index matching it.
+     */
+    void loadRecentRecords();
+    /**
+     * @brief Read path index stored by previous run, if it was built from the current log
+     * @param memoryStart: offset of the oldest record previous run kept in memory
+     */
+    bool loadPathIndex(std::uint64_t& memoryStart);
+    /**
+     * @brief Store path index with offset of the last indexed record, replacing the previous one
+     */
+    void savePathIndex() const;
+    /**
+     * @param offset: position of record in log file
+     * @param end: offset following the record, records before m_indexedEnd are already in path index
+     */
+    void addRecentRecord(const std::string& record, std::uint64_t offset, std::uint64_t end) const;
+    /**
+     * @brief Apply function to records at given offsets, records no longer kept in memory are read from log file
+     */
+    void readRecords(const std::vector<std::uint64_t>& offsets, const std::function<void(const std::string&)>& func) const;
     bool readMessageFromQueue(std::string& singleMessage) const;
     bool writeSingleMessageToFile(std::string& singleMessage) const;
     /**
@@ -82,8 +144,25 @@ private:
 
     std::atomic<bool> m_isThreadStopRequested;
     const std::string LogFileName;
+    const std::string IndexFileName;
+    static const std::string IndexMagic;
     static std::mutex s_writeQueueMutex;
     static std::mutex s_fileOperationMutex;
     static std::queue<std::string> s_writeQueue;
     LogWriter m_logWriter;
+    mutable std::shared_mutex m_recordsMutex;
+    mutable std::deque<std::string> m_records;
+    mutable std::deque<std::uint64_t> m_recordOffsets;
+    mutable PathIndex m_pathIndex;
+    mutable std::size_t m_droppedRecords;
+    mutable bool m_recordsInTimeOrder;
+    const std::size_t m_recordCapacity;
+    /**
+     * @brief Size of log file, offset of the next record, guarded by s_fileOperationMutex
+     */
+    mutable std::uint64_t m_logFileEnd;
+    /**
+     * @brief Offset following the last record in path index, guarded by m_recordsMutex
+     */
+    mutable std::uint64_t m_indexedEnd;
 };
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "Tests.h"
+#include "LogUtility.h"
+#include "GlobalData.h"
+#include <fstream>
+#include <vector>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+    /**
+     * @brief Log and its index are named relative to working directory, test runs inside its own folder
+     */
+    class LogFolder
+    {
+    public:
+        LogFolder(const LogFolder&) = delete;
+        LogFolder& operator=(const LogFolder&) = delete;
+
+        explicit LogFolder(const string& name, size_t recordCapacity):
+            m_previous(fs::current_path())
+        {
+            const auto folder = TestRegistry::makeTempFolder(name);
+            fs::current_path(folder);
+            GlobalData::removeInstance();
+            GlobalData::getInstance(folder.string(), folder.string()).setLogRecordCapacity(recordCapacity);
+        }
+
+        ~LogFolder()
+        {
+            GlobalData::removeInstance();
+            fs::current_path(m_previous);
+        }
+    private:
+        fs::path m_previous;
+    };
+
+    string makeRecord(int second, const string& path)
+    {
+        const auto seconds = to_string(100 + second % 60).substr(1);
+        return "2023-02-12T12:20:" + seconds + ".000+02:00 " + path + " was created";
+    }
+
+    void appendRecords(const vector<string>& records)
+    {
+        ofstream log("FolderBackupLog.txt", fstream::app | fstream::binary);
+        for (const auto& record : records)
+        {
+            log << record << '\n';
+        }
+    }
+
+    vector<string> findByFileName(const LogUtility& log, const string& text)
+    {
+        vector<string> found;
+        log.searchLogByFileName(text, [&found](const string& record) { found.push_back(record); });
+        return found;
+    }
+}
+
+TEST(LogUtilityResumesStoredPathIndex)
+{
+    LogFolder folder("log_index", 4);
+
+    //log is longer than its fingerprint, so a record past it can be changed without invalidating the index
+    vector<string> records;
+    for (int i = 0; i < 200; i++)
+    {
+        records.push_back(makeRecord(i, "/hot/folder/file" + to_string(100 + i) + ".txt"));
+    }
+    appendRecords(records);
+    {
+        LogUtility log;
+        CHECK(findByFileName(log, "file250.txt") == vector<string>{records[150]});
+        CHECK(log.getRecordCount() == 4);
+    }
+    CHECK(fs::exists("FolderBackupLog.idx"));
+
+    fstream log("FolderBackupLog.txt", fstream::in | fstream::out | fstream::binary);
+    string content(fs::file_size("FolderBackupLog.txt"), '\0');
+    log.read(content.data(), static_cast<streamsize>(content.size()));
+    const auto position = content.find("file250.txt");
+    log.seekp(static_cast<streamoff>(position));
+    log << "gone250.txt";
+    log.close();
+    appendRecords({makeRecord(1, "/hot/folder/file101.txt"), makeRecord(2, "/hot/new.txt")});
+
+    LogUtility reloaded;
+    //records indexed by previous run are not read again
+    CHECK(findByFileName(reloaded, "gone250.txt").empty());
+    CHECK(findByFileName(reloaded, "file250.txt").size() == 1);
+    CHECK(findByFileName(reloaded, "file101.txt") == (vector<string>{records[1], makeRecord(1, "/hot/folder/file101.txt")}));
+    CHECK(findByFileName(reloaded, "new.txt") == vector<string>{makeRecord(2, "/hot/new.txt")});
+    CHECK(reloaded.getRecordCount() == 4);
+
+    //records dropped from memory by previous run are read from the file
+    size_t recordCount = 0;
+    reloaded.searchLog([&recordCount](const string& record) { recordCount += record.empty() ? 0 : 1; });
+    CHECK(recordCount == 202);
+}
+
+TEST(LogUtilityRebuildsIndexOfReplacedLog)
+{
+    LogFolder folder("log_index_replaced", 10);
+
+    appendRecords({makeRecord(0, "/hot/old.txt"), makeRecord(1, "/hot/other.txt")});
+    {
+        LogUtility log;
+        CHECK(findByFileName(log, "old.txt").size() == 1);
+    }
+
+    fs::remove("FolderBackupLog.txt");
+    appendRecords({makeRecord(2, "/hot/replacement.txt")});
+
+    LogUtility reloaded;
+    CHECK(findByFileName(reloaded, "old.txt").empty());
+    CHECK(findByFileName(reloaded, "replacement.txt") == vector<string>{makeRecord(2, "/hot/replacement.txt")});
+    CHECK(reloaded.getRecordCount() == 1);
+}
\ No newline at end of file
@@ -0,0 +1,600 @@
+#include "MemoryFileSystem.h"
+#include <thread>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+const chrono::nanoseconds MemoryFileSystem::SpinLimit{chrono::microseconds(100)};
+
+/**
+ * @brief Walk through folder tree kept in memory
+ * Position in a folder is the name of last visited child, so children may be added or removed during the walk.
+ */
+class MemoryFileSystem::MemoryWalker : public FileSystem::Walker
+{
+public:
+    MemoryWalker(const MemoryFileSystem& fileSystem, const fs::path& root, pmr::memory_resource* memory):
+        m_fileSystem(fileSystem),
+        m_root(root),
+        m_memory(memory),
+        m_frames(memory),
+        m_relativePath(memory),
+        m_node{},
+        m_isDirectory(false),
+        m_recursionPending(false),
+        m_openFailed(false),
+        m_incomplete(false)
+    {
+        m_frames.reserve(32);
+        m_relativePath.reserve(256);
+
+        shared_ptr<Node> folder;
+        {
+            lock_guard<mutex> lock(m_fileSystem.m_mutex);
+            folder = m_fileSystem.findSharedLocked(m_root.generic_string());
+        }
+        m_incomplete = !folder || folder->type != FileType::Directory || !openFolder(move(folder), 0);
+    }
+
+    bool next() override
+    {
+        m_openFailed = false;
+        if (m_recursionPending && m_isDirectory && m_node)
+        {
+            m_openFailed = !openFolder(m_node, m_relativePath.size());
+        }
+        m_recursionPending = false;
+
+        lock_guard<mutex> lock(m_fileSystem.m_mutex);
+        while (!m_frames.empty())
+        {
+            auto& frame = m_frames.back();
+            auto& children = frame.folder->children;
+            const auto child = frame.started ? children.upper_bound(string_view(frame.name)) : children.begin();
+            if (child == children.end())
+            {
+                m_frames.pop_back();
+                continue;
+            }
+
+            frame.started = true;
+            frame.name.assign(child->first);
+            m_node = child->second;
+            m_isDirectory = m_node->type == FileType::Directory;
+            m_relativePath.resize(frame.relativeLength);
+            if (frame.relativeLength > 0)
+            {
+                m_relativePath.push_back('/');
+            }
+            m_relativePath.append(child->first);
+            m_recursionPending = true;
+
+            return true;
+        }
+
+        m_node.reset();
+        return false;
+    }
+
+    void disableRecursionPending() override
+    {
+        m_recursionPending = false;
+    }
+
+    string_view getName() const override
+    {
+        return m_frames.empty() ? string_view{} : string_view(m_frames.back().name);
+    }
+
+    string_view getRelativePath() const override
+    {
+        return m_relativePath;
+    }
+
+    size_t getDepth() const override
+    {
+        return m_frames.empty() ? 0 : m_frames.size() - 1;
+    }
+
+    bool isDirectory() const override
+    {
+        return m_isDirectory;
+    }
+
+    bool isRegularFile() const override
+    {
+        return m_node && !m_isDirectory;
+    }
+
+    fs::path getPath() const override
+    {
+        return m_root / fs::path(string_view(m_relativePath));
+    }
+
+    bool getStatus(Status& status) const override
+    {
+        if (!m_node)
+        {
+            return false;
+        }
+
+        m_fileSystem.delay(Operation::Status);
+
+        lock_guard<mutex> lock(m_fileSystem.m_mutex);
+        status.type = m_node->type;
+        status.size = m_node->size;
+        status.modificationTime = m_node->modificationTime;
+
+        return true;
+    }
+
+    bool hasOpenFailed() const override
+    {
+        return m_openFailed;
+    }
+
+    bool isIncomplete() const override
+    {
+        return m_incomplete;
+    }
+private:
+    /**
+     * @brief Open folder and name of last visited child in it
+     */
+    struct Frame
+    {
+        shared_ptr<Node> folder;
+        pmr::string name;
+        bool started;
+        size_t relativeLength;
+    };
+
+    bool openFolder(shared_ptr<Node> folder, size_t relativeLength)
+    {
+        m_fileSystem.delay(Operation::List);
+        {
+            lock_guard<mutex> lock(m_fileSystem.m_mutex);
+            if (folder->unreadable)
+            {
+                return false;
+            }
+        }
+        m_frames.push_back(Frame{move(folder), pmr::string(m_memory), false, relativeLength});
+        return true;
+    }
+
+    const MemoryFileSystem& m_fileSystem;
+    const fs::path m_root;
+    pmr::memory_resource* m_memory;
+    pmr::vector<Frame> m_frames;
+    pmr::string m_relativePath;
+    shared_ptr<Node> m_node;
+    bool m_isDirectory;
+    bool m_recursionPending;
+    bool m_openFailed;
+    bool m_incomplete;
+};
+
+MemoryFileSystem::MemoryFileSystem():
+    m_mutex{},
+    m_root(make_shared<Node>()),
+    m_latency{},
+    m_latencyPerMegabyte{},
+    m_operationCounts{}
+{
+    m_root->type = FileType::Directory;
+    m_root->modificationTime = now();
+}
+
+MemoryFileSystem::~MemoryFileSystem()
+{
+
+}
+
+void MemoryFileSystem::setLatency(Operation operation, chrono::nanoseconds perCall, chrono::nanoseconds perMegabyte)
+{
+    m_latency[static_cast<size_t>(operation)] = perCall;
+    m_latencyPerMegabyte[static_cast<size_t>(operation)] = perMegabyte;
+}
+
+void MemoryFileSystem::writeFile(const fs::path& path, uintmax_t size)
+{
+    const auto key = path.generic_string();
+
+    lock_guard<mutex> lock(m_mutex);
+
+    string_view name;
+    auto* parent = findParentLocked(key, name);
+    if (!parent)
+    {
+        const auto folderLength = key.size() - name.size();
+        bool created = false;
+        parent = createDirectoriesLocked(string_view(key).substr(0, folderLength), created);
+    }
+    if (!parent || name.empty())
+    {
+        return;
+    }
+
+    auto& child = parent->children[string(name)];
+    if (!child)
+    {
+        child = make_shared<Node>();
+        parent->modificationTime = now();
+    }
+    else if (child->type != FileType::Regular)
+    {
+        return;
+    }
+    child->size = size;
+    child->modificationTime = now();
+}
+
+void MemoryFileSystem::setUnreadable(const fs::path& path, bool unreadable)
+{
+    const auto key = path.generic_string();
+
+    lock_guard<mutex> lock(m_mutex);
+    auto* node = findLocked(key);
+    if (node)
+    {
+        node->unreadable = unreadable;
+    }
+}
+
+uint64_t MemoryFileSystem::getOperationCount(Operation operation) const
+{
+    return m_operationCounts[static_cast<size_t>(operation)].load(memory_order_relaxed);
+}
+
+bool MemoryFileSystem::getStatus(const fs::path& path, Status& status, error_code& errorCode) const
+{
+    return getStatus(path.generic_string(), status, errorCode);
+}
+
+bool MemoryFileSystem::getStatus(const string& path, Status& status, error_code& errorCode) const
+{
+    errorCode.clear();
+    status = Status{};
+
+    delay(Operation::Status);
+
+    lock_guard<mutex> lock(m_mutex);
+    const auto* node = findLocked(path);
+    if (!node)
+    {
+        return false;
+    }
+    status.type = node->type;
+    status.size = node->size;
+    status.modificationTime = node->modificationTime;
+
+    return true;
+}
+
+unique_ptr<FileSystem::Walker> MemoryFileSystem::walk(const fs::path& root, pmr::memory_resource* memory) const
+{
+    return make_unique<MemoryWalker>(*this, root, memory);
+}
+
+bool MemoryFileSystem::createDirectories(const fs::path& path, error_code& errorCode) const
+{
+    errorCode.clear();
+    delay(Operation::CreateDirectory);
+
+    const auto key = path.generic_string();
+    lock_guard<mutex> lock(m_mutex);
+
+    bool created = false;
+    if (!createDirectoriesLocked(key, created))
+    {
+        errorCode = make_error_code(errc::not_a_directory);
+    }
+
+    return created;
+}
+
+void MemoryFileSystem::setPermissions(const fs::path&, error_code& errorCode) const
+{
+    errorCode.clear();
+}
+
+bool MemoryFileSystem::remove(const fs::path& path, error_code& errorCode) const
+{
+    errorCode.clear();
+    delay(Operation::Remove);
+
+    const auto key = path.generic_string();
+    lock_guard<mutex> lock(m_mutex);
+
+    string_view name;
+    auto* parent = findParentLocked(key, name);
+    if (!parent)
+    {
+        return false;
+    }
+    const auto child = parent->children.find(name);
+    if (child == parent->children.end())
+    {
+        return false;
+    }
+    if (!child->second->children.empty())
+    {
+        errorCode = make_error_code(errc::directory_not_empty);
+        return false;
+    }
+
+    parent->children.erase(child);
+    parent->modificationTime = now();
+
+    return true;
+}
+
+void MemoryFileSystem::rename(const fs::path& source, const fs::path& destination, error_code& errorCode) const
+{
+    errorCode.clear();
+    delay(Operation::Rename);
+
+    const auto sourceKey = source.generic_string();
+    const auto destinationKey = destination.generic_string();
+    lock_guard<mutex> lock(m_mutex);
+
+    string_view sourceName;
+    auto* sourceParent = findParentLocked(sourceKey, sourceName);
+    if (!sourceParent)
+    {
+        errorCode = make_error_code(errc::no_such_file_or_directory);
+        return;
+    }
+    const auto child = sourceParent->children.find(sourceName);
+    if (child == sourceParent->children.end())
+    {
+        errorCode = make_error_code(errc::no_such_file_or_directory);
+        return;
+    }
+
+    string_view destinationName;
+    auto* destinationParent = findParentLocked(destinationKey, destinationName);
+    if (!destinationParent || destinationName.empty())
+    {
+        errorCode = make_error_code(errc::no_such_file_or_directory);
+        return;
+    }
+    const auto replaced = destinationParent->children.find(destinationName);
+    if (replaced != destinationParent->children.end() && replaced->second->type == FileType::Directory)
+    {
+        errorCode = make_error_code(errc::is_a_directory);
+        return;
+    }
+
+    auto node = child->second;
+    sourceParent->children.erase(child);
+    destinationParent->children[string(destinationName)] = move(node);
+    sourceParent->modificationTime = now();
+    destinationParent->modificationTime = now();
+}
+
+void MemoryFileSystem::setModificationTime(const fs::path& path, int64_t modificationTime, error_code& errorCode) const
+{
+    errorCode.clear();
+    delay(Operation::SetTime);
+
+    const auto key = path.generic_string();
+    lock_guard<mutex> lock(m_mutex);
+
+    auto* node = findLocked(key);
+    if (!node)
+    {
+        errorCode = make_error_code(errc::no_such_file_or_directory);
+        return;
+    }
+    node->modificationTime = modificationTime;
+}
+
+bool MemoryFileSystem::copyFile(const fs::path& source, const fs::path& destination, CopyStats& stats,
+    error_code& errorCode) const
+{
+    errorCode.clear();
+    stats = CopyStats{};
+
+    const auto sourceKey = source.generic_string();
+    const auto destinationKey = destination.generic_string();
+
+    uintmax_t size = 0;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        const auto* node = findLocked(sourceKey);
+        if (!node || node->type != FileType::Regular)
+        {
+            errorCode = make_error_code(errc::no_such_file_or_directory);
+            return false;
+        }
+        size = node->size;
+    }
+
+    //data is moved before the copy appears, like a copy through a temporary file
+    delay(Operation::Copy, size);
+
+    lock_guard<mutex> lock(m_mutex);
+    string_view name;
+    auto* parent = findParentLocked(destinationKey, name);
+    if (!parent || name.empty())
+    {
+        errorCode = make_error_code(errc::no_such_file_or_directory);
+        return false;
+    }
+    const auto existing = parent->children.find(name);
+    if (existing != parent->children.end() && existing->second->type != FileType::Regular)
+    {
+        errorCode = make_error_code(errc::is_a_directory);
+        return false;
+    }
+
+    //older file is replaced at once, like renaming the temporary file over it
+    auto copy = make_shared<Node>();
+    copy->size = size;
+    copy->modificationTime = now();
+    if (existing != parent->children.end())
+    {
+        existing->second = move(copy);
+    }
+    else
+    {
+        parent->children.emplace(string(name), move(copy));
+        parent->modificationTime = now();
+    }
+
+    stats.logicalBytes = size;
+    stats.physicalBytes = size;
+
+    return true;
+}
+
+bool MemoryFileSystem::readFile(const fs::path& path, string& content, error_code& errorCode) const
+{
+    errorCode.clear();
+
+    const auto key = path.generic_string();
+    uintmax_t size = 0;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        const auto* node = findLocked(key);
+        if (!node || node->type != FileType::Regular)
+        {
+            errorCode = make_error_code(errc::no_such_file_or_directory);
+            return false;
+        }
+        size = node->size;
+    }
+
+    delay(Operation::Read, size);
+    content.assign(static_cast<size_t>(size), '\0');
+
+    return true;
+}
+
+MemoryFileSystem::Node* MemoryFileSystem::findLocked(string_view path) const
+{
+    auto* node = m_root.get();
+    string_view component;
+    while (nextComponent(path, component))
+    {
+        if (node->type != FileType::Directory)
+        {
+            return nullptr;
+        }
+        const auto child = node->children.find(component);
+        if (child == node->children.end())
+        {
+            return nullptr;
+        }
+        node = child->second.get();
+    }
+
+    return node;
+}
+
+shared_ptr<MemoryFileSystem::Node> MemoryFileSystem::findSharedLocked(string_view path) const
+{
+    auto node = m_root;
+    string_view component;
+    while (nextComponent(path, component))
+    {
+        const auto child = node->children.find(component);
+        if (child == node->children.end())
+        {
+            return nullptr;
+        }
+        node = child->second;
+    }
+
+    return node;
+}
+
+MemoryFileSystem::Node* MemoryFileSystem::findParentLocked(string_view path, string_view& name) const
+{
+    //trailing separators do not belong to the name
+    while (!path.empty() && path.back() == '/')
+    {
+        path.remove_suffix(1);
+    }
+    const auto separator = path.find_last_of('/');
+    name = separator == string_view::npos ? path : path.substr(separator + 1);
+
+    auto* parent = findLocked(separator == string_view::npos ? string_view{} : path.substr(0, separator));
+    return parent && parent->type == FileType::Directory ? parent : nullptr;
+}
+
+MemoryFileSystem::Node* MemoryFileSystem::createDirectoriesLocked(string_view path, bool& created) const
+{
+    auto* node = m_root.get();
+    string_view component;
+    while (nextComponent(path, component))
+    {
+        auto child = node->children.find(component);
+        if (child == node->children.end())
+        {
+            auto folder = make_shared<Node>();
+            folder->type = FileType::Directory;
+            folder->modificationTime = now();
+            child = node->children.emplace(string(component), move(folder)).first;
+            node->modificationTime = now();
+            created = true;
+        }
+        if (child->second->type != FileType::Directory)
+        {
+            return nullptr;
+        }
+        node = child->second.get();
+    }
+
+    return node;
+}
+
+void MemoryFileSystem::delay(Operation operation, uintmax_t bytes) const
+{
+    const auto index = static_cast<size_t>(operation);
+    m_operationCounts[index].fetch_add(1, memory_order_relaxed);
+
+    const auto perMegabyte = chrono::duration<double, nano>(m_latencyPerMegabyte[index]) * (static_cast<double>(bytes) / (1024 * 1024));
+    const auto duration = m_latency[index] + chrono::duration_cast<chrono::nanoseconds>(perMegabyte);
+    if (duration <= chrono::nanoseconds::zero())
+    {
+        return;
+    }
+
+    //sleeping overshoots by tens of microseconds, the end of a delay is spun so results stay repeatable
+    const auto deadline = chrono::steady_clock::now() + duration;
+    if (duration > SpinLimit)
+    {
+        this_thread::sleep_until(deadline - SpinLimit);
+    }
+    while (chrono::steady_clock::now() < deadline)
+    {
+    }
+}
+
+int64_t MemoryFileSystem::now()
+{
+#ifdef __linux__
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+#else
+    return static_cast<int64_t>(fs::file_time_type::clock::now().time_since_epoch().count());
+#endif
+}
+
+bool MemoryFileSystem::nextComponent(string_view& path, string_view& component)
+{
+    while (!path.empty())
+    {
+        const auto separator = path.find('/');
+        component = path.substr(0, separator);
+        path.remove_prefix(separator == string_view::npos ? path.size() : separator + 1);
+        if (!component.empty() && component != ".")
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "FileSystem.h"
+/**
+ * @brief File system kept in memory with optional delay injected into every operation
+ * Lets passes, decisions and scheduling of backup run on millions of simulated files without disk noise, or
+ * reproduce slow storage (NFS, SMB, cold disks) deterministically. Only sizes and times of files are kept,
+ * reads return zeros. Adding or removing an entry updates modification time of its folder like a real file system.
+ */
+class MemoryFileSystem : public FileSystem
+{
+public:
+    /**
+     * @brief Operations with own delay and counter
+     * List is counted once for every folder a walk opens, Status once for every status query.
+     */
+    enum class Operation
+    {
+        Status,
+        List,
+        CreateDirectory,
+        Remove,
+        Rename,
+        SetTime,
+        Copy,
+        Read,
+        OperationCount
+    };
+
+    MemoryFileSystem(const MemoryFileSystem&) = delete;
+    MemoryFileSystem& operator=(const MemoryFileSystem&) = delete;
+    MemoryFileSystem& operator==(const MemoryFileSystem&) = delete;
+
+    MemoryFileSystem();
+    ~MemoryFileSystem() override;
+    /**
+     * @brief Delay added to every call of operation, set before the file system is used
+     * Delays are spent outside of lock, so calls of several threads overlap like requests to a file server.
+     * @param perMegabyte: added for every MiB moved by Copy and Read
+     */
+    void setLatency(Operation operation, std::chrono::nanoseconds perCall, std::chrono::nanoseconds perMegabyte = {});
+    /**
+     * @brief Create or overwrite file with modification time of now, missing folders are created, no delay applies
+     */
+    void writeFile(const std::filesystem::path& path, std::uintmax_t size);
+    /**
+     * @brief Walks fail to open folder, like a folder without read permission, status queries still work
+     */
+    void setUnreadable(const std::filesystem::path& path, bool unreadable);
+    /**
+     * @brief Calls of operation so far
+     */
+    std::uint64_t getOperationCount(Operation operation) const;
+
+    bool getStatus(const std::filesystem::path& path, Status& status, std::error_code& errorCode) const override;
+
+    bool getStatus(const std::string& path, Status& status, std::error_code& errorCode) const override;
+
+    std::unique_ptr<Walker> walk(const std::filesystem::path& root, std::pmr::memory_resource* memory) const override;
+
+    bool createDirectories(const std::filesystem::path& path, std::error_code& errorCode) const override;
+
+    void setPermissions(const std::filesystem::path& path, std::error_code& errorCode) const override;
+
+    bool remove(const std::filesystem::path& path, std::error_code& errorCode) const override;
+
+    void rename(const std::filesystem::path& source, const std::filesystem::path& destination,
+        std::error_code& errorCode) const override;
+
+    void setModificationTime(const std::filesystem::path& path, std::int64_t modificationTime,
+        std::error_code& errorCode) const override;
+
+    bool copyFile(const std::filesystem::path& source, const std::filesystem::path& destination,
+        CopyStats& stats, std::error_code& errorCode) const override;
+
+    bool readFile(const std::filesystem::path& path, std::string& content, std::error_code& errorCode) const override;
+private:
+    /**
+     * @brief File or folder, folders keep children sorted by name
+     * Walkers hold folders they are in, so a folder removed during a walk stays valid till walk leaves it.
+     */
+    struct Node
+    {
+        FileType type = FileType::Regular;
+        std::uintmax_t size = 0;
+        std::int64_t modificationTime = 0;
+        bool unreadable = false;
+        std::map<std::string, std::shared_ptr<Node>, std::less<>> children;
+    };
+    class MemoryWalker;
+    static constexpr std::size_t OperationCount = static_cast<std::size_t>(Operation::OperationCount);
+    /**
+     * @brief Node of path, nullptr when missing, caller holds the lock
+     */
+    Node* findLocked(std::string_view path) const;
+    /**
+     * @brief Same as findLocked, for walkers which keep folders they are in
+     */
+    std::shared_ptr<Node> findSharedLocked(std::string_view path) const;
+    /**
+     * @brief Folder holding path and name of path inside it, nullptr when folder is missing, caller holds the lock
+     */
+    Node* findParentLocked(std::string_view path, std::string_view& name) const;
+    /**
+     * @brief Folder of path, missing folders are created, nullptr when a file is in the way, caller holds the lock
+     */
+    Node* createDirectoriesLocked(std::string_view path, bool& created) const;
+    /**
+     * @brief Count operation and wait for its delay
+     * @param bytes: data moved by operation
+     */
+    void delay(Operation operation, std::uintmax_t bytes = 0) const;
+    /**
+     * @brief Current time in the unit of modification times
+     */
+    static std::int64_t now();
+    /**
+     * @brief Take first component off path, empty ones and "." are skipped
+     * @return false: no component left
+     */
+    static bool nextComponent(std::string_view& path, std::string_view& component);
+
+    mutable std::mutex m_mutex;
+    const std::shared_ptr<Node> m_root;
+    std::array<std::chrono::nanoseconds, OperationCount> m_latency;
+    std::array<std::chrono::nanoseconds, OperationCount> m_latencyPerMegabyte;
+    mutable std::array<std::atomic<std::uint64_t>, OperationCount> m_operationCounts;
+    static const std::chrono::nanoseconds SpinLimit;
+};
\ No newline at end of file
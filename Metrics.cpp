@@ -0,0 +1,320 @@
+#include "Metrics.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <limits>
+#include <algorithm>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+const array<double, Metrics::BucketCount> Metrics::BucketBoundsSeconds{
+    0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60,
+    numeric_limits<double>::infinity()};
+
+const array<const char*, Metrics::CounterCount> Metrics::CounterNames{
+    "files_scanned_total", "files_skipped_total", "files_backed_up_total", "files_deleted_total",
+    "copied_bytes_total", "copied_physical_bytes_total", "passes_total", "copy_seconds_total",
+    "files_excluded_total", "directories_pruned_total", "files_packed_total", "directories_deferred_total",
+    "orphans_removed_total", "orphans_quarantined_total"};
+
+const array<const char*, Metrics::ErrorCategoryCount> Metrics::ErrorCategoryNames{
+    "create_directory", "permissions", "file_size", "delete", "read_time", "write_time", "copy"};
+
+const array<const char*, Metrics::GaugeCount> Metrics::GaugeNames{
+    "log_queue_depth", "last_pass_files_scanned", "last_pass_files_skipped", "last_pass_duration_seconds",
+    "latency_lane_depth", "bulk_lane_depth", "last_pass_directories_scanned", "last_pass_directories_idle",
+    "orphans_pending"};
+
+const array<const char*, Metrics::HistogramCount> Metrics::HistogramNames{
+    "copy_duration_seconds", "pass_duration_seconds", "backup_latency_seconds"};
+
+Metrics::Metrics():
+    m_shardsMutex{},
+    m_shards{},
+    m_freeShards{},
+    m_gauges{}
+{
+
+}
+
+Metrics& Metrics::getInstance()
+{
+    static Metrics s_instance;
+    return s_instance;
+}
+
+Metrics::ShardHandle::ShardHandle(Metrics& metrics):
+    m_metrics(metrics),
+    m_shard(nullptr)
+{
+    lock_guard<mutex> lock(m_metrics.m_shardsMutex);
+
+    //shards of finished threads are reused, their values stay part of the totals
+    if (!m_metrics.m_freeShards.empty())
+    {
+        m_shard = m_metrics.m_freeShards.back();
+        m_metrics.m_freeShards.pop_back();
+    }
+    else
+    {
+        m_metrics.m_shards.push_back(make_unique<Shard>());
+        m_shard = m_metrics.m_shards.back().get();
+    }
+}
+
+Metrics::ShardHandle::~ShardHandle()
+{
+    lock_guard<mutex> lock(m_metrics.m_shardsMutex);
+    m_metrics.m_freeShards.push_back(m_shard);
+}
+
+Metrics::Shard& Metrics::ShardHandle::get()
+{
+    return *m_shard;
+}
+
+Metrics::Shard& Metrics::getShard()
+{
+    thread_local ShardHandle handle(*this);
+    return handle.get();
+}
+
+void Metrics::increment(Counter counter, uint64_t value)
+{
+    getShard().counters[static_cast<size_t>(counter)].fetch_add(value, memory_order_relaxed);
+}
+
+void Metrics::countError(ErrorCategory category)
+{
+    getShard().errors[static_cast<size_t>(category)].fetch_add(1, memory_order_relaxed);
+}
+
+void Metrics::setGauge(Gauge gauge, int64_t value)
+{
+    m_gauges[static_cast<size_t>(gauge)].store(value, memory_order_relaxed);
+}
+
+void Metrics::observe(Histogram histogram, chrono::nanoseconds duration)
+{
+    const auto seconds = chrono::duration<double>(duration).count();
+    const auto bucket = static_cast<size_t>(lower_bound(BucketBoundsSeconds.begin(), BucketBoundsSeconds.end(), seconds) -
+        BucketBoundsSeconds.begin());
+
+    auto& shard = getShard();
+    const auto index = static_cast<size_t>(histogram);
+    shard.buckets[index][bucket].fetch_add(1, memory_order_relaxed);
+    shard.sumNanoseconds[index].fetch_add(static_cast<uint64_t>(duration.count()), memory_order_relaxed);
+}
+
+Metrics::Snapshot Metrics::getSnapshot() const
+{
+    Snapshot snapshot;
+    lock_guard<mutex> lock(m_shardsMutex);
+
+    for (const auto& shard : m_shards)
+    {
+        for (size_t i = 0; i < CounterCount; i++)
+        {
+            snapshot.counters[i] += shard->counters[i].load(memory_order_relaxed);
+        }
+        for (size_t i = 0; i < ErrorCategoryCount; i++)
+        {
+            snapshot.errors[i] += shard->errors[i].load(memory_order_relaxed);
+        }
+        for (size_t i = 0; i < HistogramCount; i++)
+        {
+            for (size_t bucket = 0; bucket < BucketCount; bucket++)
+            {
+                snapshot.buckets[i][bucket] += shard->buckets[i][bucket].load(memory_order_relaxed);
+            }
+            snapshot.sumNanoseconds[i] += shard->sumNanoseconds[i].load(memory_order_relaxed);
+        }
+    }
+
+    return snapshot;
+}
+
+uint64_t Metrics::getCounter(Counter counter) const
+{
+    uint64_t sum = 0;
+    lock_guard<mutex> lock(m_shardsMutex);
+
+    for (const auto& shard : m_shards)
+    {
+        sum += shard->counters[static_cast<size_t>(counter)].load(memory_order_relaxed);
+    }
+
+    return sum;
+}
+
+uint64_t Metrics::getPercentileMicroseconds(const Snapshot& snapshot, Histogram histogram, double percentile) const
+{
+    const auto& buckets = snapshot.buckets[static_cast<size_t>(histogram)];
+    uint64_t total = 0;
+    for (const auto count : buckets)
+    {
+        total += count;
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    //upper bound of the bucket holding the percentile
+    const auto rank = static_cast<uint64_t>(percentile * static_cast<double>(total));
+    uint64_t cumulative = 0;
+    for (size_t bucket = 0; bucket + 1 < BucketCount; bucket++)
+    {
+        cumulative += buckets[bucket];
+        if (cumulative > rank)
+        {
+            return static_cast<uint64_t>(BucketBoundsSeconds[bucket] * 1e6);
+        }
+    }
+
+    return static_cast<uint64_t>(BucketBoundsSeconds[BucketCount - 2] * 1e6);
+}
+
+string Metrics::toText() const
+{
+    const auto snapshot = getSnapshot();
+    const auto counter = [&snapshot](Counter c) { return snapshot.counters[static_cast<size_t>(c)]; };
+    const auto gauge = [this](Gauge g) { return m_gauges[static_cast<size_t>(g)].load(memory_order_relaxed); };
+
+    const auto copySeconds = static_cast<double>(counter(Counter::CopyNanoseconds)) / 1e9;
+    const auto copyRate = copySeconds > 0 ? static_cast<double>(counter(Counter::BytesCopied)) / copySeconds / (1024 * 1024) : 0;
+
+    ostringstream text;
+    text << "Passes: " << counter(Counter::Passes)
+        << ", last pass: " << gauge(Gauge::LastPassFilesScanned) << " files scanned, "
+        << gauge(Gauge::LastPassFilesSkipped) << " skipped in " << static_cast<double>(gauge(Gauge::LastPassMicroseconds)) / 1e6 << " s\n";
+    text << "Folders checked by last pass: " << gauge(Gauge::LastPassDirectoriesScanned) << ", left idle: "
+        << gauge(Gauge::LastPassDirectoriesIdle) << ", deferred over budget in total: " << counter(Counter::DirectoriesDeferred) << "\n";
+    text << "Files scanned: " << counter(Counter::FilesScanned) << ", skipped: " << counter(Counter::FilesSkipped)
+        << ", backed up: " << counter(Counter::FilesBackedUp) << " (packed: " << counter(Counter::FilesPacked)
+        << "), deleted: " << counter(Counter::FilesDeleted) << "\n";
+    text << "Orphaned backups removed: " << counter(Counter::OrphansRemoved) << ", quarantined: "
+        << counter(Counter::OrphansQuarantined) << ", waiting: " << gauge(Gauge::OrphansPending) << "\n";
+    text << "Excluded by filter: " << counter(Counter::FilesExcluded) << " files, "
+        << counter(Counter::DirectoriesPruned) << " folders pruned\n";
+    text << "Copied: " << counter(Counter::BytesCopied) << " bytes (" << counter(Counter::PhysicalBytesCopied)
+        << " physical), " << copyRate << " MB/s while copying\n";
+    text << "Copy latency p50: " << getPercentileMicroseconds(snapshot, Histogram::CopyDuration, 0.5) << " us, p99: "
+        << getPercentileMicroseconds(snapshot, Histogram::CopyDuration, 0.99) << " us\n";
+    text << "Modification to backup p50: " << getPercentileMicroseconds(snapshot, Histogram::BackupLatency, 0.5) << " us, p99: "
+        << getPercentileMicroseconds(snapshot, Histogram::BackupLatency, 0.99) << " us\n";
+    text << "Waiting for backup: " << gauge(Gauge::LatencyLaneDepth) << " small, " << gauge(Gauge::BulkLaneDepth) << " large files\n";
+    text << "Log queue depth: " << gauge(Gauge::LogQueueDepth) << "\n";
+    text << "Errors:";
+    for (size_t i = 0; i < ErrorCategoryCount; i++)
+    {
+        text << " " << ErrorCategoryNames[i] << "=" << snapshot.errors[i];
+    }
+    text << "\n";
+
+    return text.str();
+}
+
+string Metrics::toPrometheus() const
+{
+    const string prefix{"folderbackup_"};
+    const auto snapshot = getSnapshot();
+    ostringstream text;
+
+    for (size_t i = 0; i < CounterCount; i++)
+    {
+        const auto name = prefix + CounterNames[i];
+        text << "# TYPE " << name << " counter\n" << name << " ";
+        if (static_cast<Counter>(i) == Counter::CopyNanoseconds)
+        {
+            text << static_cast<double>(snapshot.counters[i]) / 1e9 << "\n";
+        }
+        else
+        {
+            text << snapshot.counters[i] << "\n";
+        }
+    }
+
+    const auto errorName = prefix + "errors_total";
+    text << "# TYPE " << errorName << " counter\n";
+    for (size_t i = 0; i < ErrorCategoryCount; i++)
+    {
+        text << errorName << "{category=\"" << ErrorCategoryNames[i] << "\"} " << snapshot.errors[i] << "\n";
+    }
+
+    for (size_t i = 0; i < GaugeCount; i++)
+    {
+        const auto name = prefix + GaugeNames[i];
+        const auto value = m_gauges[i].load(memory_order_relaxed);
+        text << "# TYPE " << name << " gauge\n" << name << " ";
+        if (static_cast<Gauge>(i) == Gauge::LastPassMicroseconds)
+        {
+            text << static_cast<double>(value) / 1e6 << "\n";
+        }
+        else
+        {
+            text << value << "\n";
+        }
+    }
+
+    for (size_t i = 0; i < HistogramCount; i++)
+    {
+        const auto name = prefix + HistogramNames[i];
+        text << "# TYPE " << name << " histogram\n";
+        uint64_t cumulative = 0;
+        for (size_t bucket = 0; bucket < BucketCount; bucket++)
+        {
+            cumulative += snapshot.buckets[i][bucket];
+            text << name << "_bucket{le=\"";
+            if (bucket + 1 == BucketCount)
+            {
+                text << "+Inf";
+            }
+            else
+            {
+                text << BucketBoundsSeconds[bucket];
+            }
+            text << "\"} " << cumulative << "\n";
+        }
+        text << name << "_sum " << static_cast<double>(snapshot.sumNanoseconds[i]) / 1e9 << "\n";
+        text << name << "_count " << cumulative << "\n";
+    }
+
+    return text.str();
+}
+
+bool Metrics::writePrometheusFile(const fs::path& path) const
+{
+    auto temporary = path;
+    temporary += ".tmp";
+    {
+        ofstream file(temporary, fstream::trunc);
+        file << toPrometheus();
+        if (!file)
+        {
+            return false;
+        }
+    }
+
+    error_code ec;
+    fs::rename(temporary, path, ec);
+
+    return !ec;
+}
+
+void Metrics::exportToFileThread(const fs::path& path, chrono::seconds interval, const atomic<bool>& stopRequested) const
+{
+    auto nextExport = chrono::steady_clock::now();
+    while (!stopRequested.load())
+    {
+        if (chrono::steady_clock::now() >= nextExport)
+        {
+            writePrometheusFile(path);
+            nextExport += interval;
+        }
+        this_thread::sleep_for(chrono::milliseconds(100));
+    }
+
+    writePrometheusFile(path);
+}
\ No newline at end of file
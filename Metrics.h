@@ -0,0 +1,172 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+/**
+ * @brief Runtime counters, gauges and latency histograms
+ * Every thread updates its own shard without contention, shards are summed up when read.
+ */
+class Metrics
+{
+public:
+    /**
+     * @brief Monotonic counters
+     */
+    enum class Counter
+    {
+        FilesScanned,
+        FilesSkipped,
+        FilesBackedUp,
+        FilesDeleted,
+        BytesCopied,
+        PhysicalBytesCopied,
+        Passes,
+        CopyNanoseconds,
+        FilesExcluded,
+        DirectoriesPruned,
+        FilesPacked,
+        DirectoriesDeferred,
+        OrphansRemoved,
+        OrphansQuarantined,
+        CounterCount
+    };
+    /**
+     * @brief Categories of errors reported through FSHelper error handler
+     */
+    enum class ErrorCategory
+    {
+        CreateDirectory,
+        Permissions,
+        FileSize,
+        Delete,
+        ReadTime,
+        WriteTime,
+        Copy,
+        ErrorCategoryCount
+    };
+    /**
+     * @brief Values which are set rather than accumulated
+     */
+    enum class Gauge
+    {
+        LogQueueDepth,
+        LastPassFilesScanned,
+        LastPassFilesSkipped,
+        LastPassMicroseconds,
+        LatencyLaneDepth,
+        BulkLaneDepth,
+        LastPassDirectoriesScanned,
+        LastPassDirectoriesIdle,
+        OrphansPending,
+        GaugeCount
+    };
+    /**
+     * @brief Latency distributions
+     */
+    enum class Histogram
+    {
+        CopyDuration,
+        PassDuration,
+        BackupLatency,
+        HistogramCount
+    };
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+    Metrics& operator==(const Metrics&) = delete;
+
+    static Metrics& getInstance();
+
+    void increment(Counter counter, std::uint64_t value = 1);
+
+    void countError(ErrorCategory category);
+
+    void setGauge(Gauge gauge, std::int64_t value);
+
+    void observe(Histogram histogram, std::chrono::nanoseconds duration);
+    /**
+     * @brief Sum of counter over all threads
+     */
+    std::uint64_t getCounter(Counter counter) const;
+    /**
+     * @brief Human readable summary for the CLI menu
+     */
+    std::string toText() const;
+    /**
+     * @brief Prometheus text exposition format
+     */
+    std::string toPrometheus() const;
+    /**
+     * @brief Replace file contents with current metrics, readers never see a half written file
+     * @return false: file could not be written
+     */
+    bool writePrometheusFile(const std::filesystem::path& path) const;
+    /**
+     * @brief loop for metrics export thread, rewrites file every interval until stop is requested
+     */
+    void exportToFileThread(const std::filesystem::path& path, std::chrono::seconds interval,
+        const std::atomic<bool>& stopRequested) const;
+private:
+    static constexpr std::size_t CounterCount = static_cast<std::size_t>(Counter::CounterCount);
+    static constexpr std::size_t ErrorCategoryCount = static_cast<std::size_t>(ErrorCategory::ErrorCategoryCount);
+    static constexpr std::size_t GaugeCount = static_cast<std::size_t>(Gauge::GaugeCount);
+    static constexpr std::size_t HistogramCount = static_cast<std::size_t>(Histogram::HistogramCount);
+    static constexpr std::size_t BucketCount = 19;
+    /**
+     * @brief Values written by a single thread
+     */
+    struct Shard
+    {
+        std::array<std::atomic<std::uint64_t>, CounterCount> counters{};
+        std::array<std::atomic<std::uint64_t>, ErrorCategoryCount> errors{};
+        std::array<std::array<std::atomic<std::uint64_t>, BucketCount>, HistogramCount> buckets{};
+        std::array<std::atomic<std::uint64_t>, HistogramCount> sumNanoseconds{};
+    };
+    /**
+     * @brief Sum of all shards
+     */
+    struct Snapshot
+    {
+        std::array<std::uint64_t, CounterCount> counters{};
+        std::array<std::uint64_t, ErrorCategoryCount> errors{};
+        std::array<std::array<std::uint64_t, BucketCount>, HistogramCount> buckets{};
+        std::array<std::uint64_t, HistogramCount> sumNanoseconds{};
+    };
+    /**
+     * @brief Owns shard of a thread and hands it back for reuse when thread ends
+     */
+    class ShardHandle
+    {
+    public:
+        ShardHandle(Metrics& metrics);
+        ~ShardHandle();
+        Shard& get();
+    private:
+        Metrics& m_metrics;
+        Shard* m_shard;
+    };
+
+    Metrics();
+
+    Shard& getShard();
+    Snapshot getSnapshot() const;
+    std::uint64_t getPercentileMicroseconds(const Snapshot& snapshot, Histogram histogram, double percentile) const;
+
+    mutable std::mutex m_shardsMutex;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    std::vector<Shard*> m_freeShards;
+    std::array<std::atomic<std::int64_t>, GaugeCount> m_gauges;
+
+    static const std::array<double, BucketCount> BucketBoundsSeconds;
+    static const std::array<const char*, CounterCount> CounterNames;
+    static const std::array<const char*, ErrorCategoryCount> ErrorCategoryNames;
+    static const std::array<const char*, GaugeCount> GaugeNames;
+    static const std::array<const char*, HistogramCount> HistogramNames;
+};
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "Tests.h"
+#include "BackupFixture.h"
+#include "Metrics.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+    /**
+     * @brief Value of a sample in Prometheus text, labels included in name, -1 when it is missing
+     */
+    double readSample(const string& text, const string& name)
+    {
+        istringstream lines(text);
+        string line;
+        while (getline(lines, line))
+        {
+            if (line.size() > name.size() && line.compare(0, name.size(), name) == 0 && line[name.size()] == ' ')
+            {
+                return stod(line.substr(name.size() + 1));
+            }
+        }
+        return -1;
+    }
+}
+
+TEST(MetricsCountersSumAllThreads)
+{
+    auto& metrics = Metrics::getInstance();
+    const auto before = metrics.getCounter(Metrics::Counter::FilesSkipped);
+
+    vector<thread> threads;
+    for (int i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&metrics]()
+        {
+            for (int j = 0; j < 1000; j++)
+            {
+                metrics.increment(Metrics::Counter::FilesSkipped);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    //shards of finished threads still count
+    CHECK(metrics.getCounter(Metrics::Counter::FilesSkipped) == before + 4000);
+
+    metrics.increment(Metrics::Counter::FilesSkipped, 5);
+    CHECK(metrics.getCounter(Metrics::Counter::FilesSkipped) == before + 4005);
+}
+
+TEST(MetricsHistogramBucketsInPrometheusText)
+{
+    auto& metrics = Metrics::getInstance();
+    const string name{"folderbackup_pass_duration_seconds"};
+    const auto before = metrics.toPrometheus();
+
+    metrics.observe(Metrics::Histogram::PassDuration, chrono::microseconds(50));
+    metrics.observe(Metrics::Histogram::PassDuration, chrono::microseconds(700));
+    metrics.observe(Metrics::Histogram::PassDuration, chrono::milliseconds(20));
+    metrics.observe(Metrics::Histogram::PassDuration, chrono::seconds(100));
+    metrics.setGauge(Metrics::Gauge::OrphansPending, 17);
+    metrics.countError(Metrics::ErrorCategory::Permissions);
+
+    const auto after = metrics.toPrometheus();
+    auto added = [&](const string& sample) { return readSample(after, sample) - readSample(before, sample); };
+    //buckets are cumulative
+    CHECK(added(name + "_bucket{le=\"0.0001\"}") == 1);
+    CHECK(added(name + "_bucket{le=\"0.001\"}") == 2);
+    CHECK(added(name + "_bucket{le=\"0.025\"}") == 3);
+    CHECK(added(name + "_bucket{le=\"60\"}") == 3);
+    CHECK(added(name + "_bucket{le=\"+Inf\"}") == 4);
+    CHECK(added(name + "_count") == 4);
+    //sum is printed with six significant digits
+    CHECK(added(name + "_sum") > 100.01 && added(name + "_sum") < 100.03);
+    CHECK(readSample(after, "folderbackup_orphans_pending") == 17);
+    CHECK(added("folderbackup_errors_total{category=\"permissions\"}") == 1);
+    CHECK(after.find("# TYPE " + name + " histogram\n") != string::npos);
+}
+
+TEST(MetricsCountBackupPass)
+{
+    BackupFixture fixture("metrics_pass", true);
+    auto& metrics = Metrics::getInstance();
+    const auto passes = metrics.getCounter(Metrics::Counter::Passes);
+    const auto backedUp = metrics.getCounter(Metrics::Counter::FilesBackedUp);
+    const auto copied = metrics.getCounter(Metrics::Counter::BytesCopied);
+
+    fixture.getMemoryFileSystem().writeFile(fixture.getHot() / "a.bin", 300000);
+    fixture.getMemoryFileSystem().writeFile(fixture.getHot() / "b.bin", 200000);
+    fixture.runPasses(2);
+
+    CHECK(metrics.getCounter(Metrics::Counter::Passes) == passes + 2);
+    CHECK(metrics.getCounter(Metrics::Counter::FilesBackedUp) == backedUp + 2);
+    CHECK(metrics.getCounter(Metrics::Counter::BytesCopied) == copied + 500000);
+
+    const auto text = metrics.toText();
+    CHECK(text.find("Passes: " + to_string(passes + 2)) == 0);
+
+    const auto file = TestRegistry::makeTempFolder("metrics_file") / "metrics.prom";
+    CHECK(metrics.writePrometheusFile(file));
+    ifstream input(file);
+    stringstream written;
+    written << input.rdbuf();
+    CHECK(readSample(written.str(), "folderbackup_passes_total") == static_cast<double>(passes + 2));
+    CHECK(!fs::exists(file.string() + ".tmp"));
+}
\ No newline at end of file
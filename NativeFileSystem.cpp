@@ -0,0 +1,148 @@
+#include "NativeFileSystem.h"
+#include "DirectoryWalker.h"
+#include <fstream>
+
+#ifdef __linux__
+#include <cerrno>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+NativeFileSystem& NativeFileSystem::getInstance()
+{
+    static NativeFileSystem s_instance;
+    return s_instance;
+}
+
+NativeFileSystem::NativeFileSystem():
+    m_fileCopier()
+{
+
+}
+
+#ifdef __linux__
+void NativeFileSystem::toStatus(const struct stat& source, Status& status)
+{
+    status.type = S_ISREG(source.st_mode) ? FileType::Regular : S_ISDIR(source.st_mode) ? FileType::Directory : FileType::Other;
+    status.size = static_cast<uintmax_t>(source.st_size);
+    status.modificationTime = FileTime::getModificationTime(source);
+}
+#endif
+
+bool NativeFileSystem::getStatus(const fs::path& path, Status& status, error_code& errorCode) const
+{
+#ifdef __linux__
+    return getStatus(path.native(), status, errorCode);
+#else
+    errorCode.clear();
+    status = Status{};
+
+    const auto fileStatus = fs::status(path, errorCode);
+    if (!fs::exists(fileStatus))
+    {
+        if (fileStatus.type() == fs::file_type::not_found)
+        {
+            errorCode.clear();
+        }
+        return false;
+    }
+
+    status.type = fs::is_regular_file(fileStatus) ? FileType::Regular : fs::is_directory(fileStatus) ? FileType::Directory : FileType::Other;
+    status.size = status.type == FileType::Regular ? fs::file_size(path, errorCode) : 0;
+    status.modificationTime = static_cast<int64_t>(fs::last_write_time(path, errorCode).time_since_epoch().count());
+
+    return !errorCode;
+#endif
+}
+
+bool NativeFileSystem::getStatus(const string& path, Status& status, error_code& errorCode) const
+{
+#ifdef __linux__
+    errorCode.clear();
+    status = Status{};
+
+    struct stat source;
+    if (stat(path.c_str(), &source) != 0)
+    {
+        if (errno != ENOENT && errno != ENOTDIR)
+        {
+            errorCode.assign(errno, generic_category());
+        }
+        return false;
+    }
+    toStatus(source, status);
+
+    return true;
+#else
+    return getStatus(fs::u8path(path), status, errorCode);
+#endif
+}
+
+unique_ptr<FileSystem::Walker> NativeFileSystem::walk(const fs::path& root, pmr::memory_resource* memory) const
+{
+    return make_unique<DirectoryWalker>(root, memory);
+}
+
+bool NativeFileSystem::createDirectories(const fs::path& path, error_code& errorCode) const
+{
+    return fs::create_directories(path, errorCode);
+}
+
+void NativeFileSystem::setPermissions(const fs::path& path, error_code& errorCode) const
+{
+    fs::permissions(path, fs::perms::all, fs::perm_options::replace, errorCode);
+}
+
+bool NativeFileSystem::remove(const fs::path& path, error_code& errorCode) const
+{
+    return fs::remove(path, errorCode);
+}
+
+void NativeFileSystem::rename(const fs::path& source, const fs::path& destination, error_code& errorCode) const
+{
+    fs::rename(source, destination, errorCode);
+}
+
+void NativeFileSystem::setModificationTime(const fs::path& path, int64_t modificationTime, error_code& errorCode) const
+{
+    errorCode.clear();
+#ifdef __linux__
+    if (!FileTime::setModificationTime(path, modificationTime))
+    {
+        errorCode.assign(errno, generic_category());
+    }
+#else
+    fs::last_write_time(path, fs::file_time_type(fs::file_time_type::duration(modificationTime)), errorCode);
+#endif
+}
+
+bool NativeFileSystem::copyFile(const fs::path& source, const fs::path& destination, CopyStats& stats,
+    error_code& errorCode) const
+{
+    return m_fileCopier.copy(source, destination, stats, errorCode);
+}
+
+bool NativeFileSystem::readFile(const fs::path& path, string& content, error_code& errorCode) const
+{
+    errorCode.clear();
+
+    ifstream input(path, ios::binary | ios::ate);
+    if (!input.is_open())
+    {
+        errorCode = make_error_code(errc::io_error);
+        return false;
+    }
+
+    content.resize(static_cast<size_t>(input.tellg()));
+    input.seekg(0);
+    input.read(content.data(), static_cast<streamsize>(content.size()));
+    content.resize(static_cast<size_t>(input.gcount()));
+    if (input.bad())
+    {
+        errorCode = make_error_code(errc::io_error);
+        return false;
+    }
+
+    return true;
+}
\ No newline at end of file
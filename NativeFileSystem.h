@@ -0,0 +1,53 @@
+#pragma once
+
+#include "FileSystem.h"
+#include "FileCopier.h"
+
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
+/**
+ * @brief File system of the machine, large files are copied by FileCopier
+ */
+class NativeFileSystem : public FileSystem
+{
+public:
+    NativeFileSystem(const NativeFileSystem&) = delete;
+    NativeFileSystem& operator=(const NativeFileSystem&) = delete;
+    NativeFileSystem& operator==(const NativeFileSystem&) = delete;
+
+    static NativeFileSystem& getInstance();
+
+    bool getStatus(const std::filesystem::path& path, Status& status, std::error_code& errorCode) const override;
+
+    bool getStatus(const std::string& path, Status& status, std::error_code& errorCode) const override;
+
+    std::unique_ptr<Walker> walk(const std::filesystem::path& root, std::pmr::memory_resource* memory) const override;
+
+    bool createDirectories(const std::filesystem::path& path, std::error_code& errorCode) const override;
+
+    void setPermissions(const std::filesystem::path& path, std::error_code& errorCode) const override;
+
+    bool remove(const std::filesystem::path& path, std::error_code& errorCode) const override;
+
+    void rename(const std::filesystem::path& source, const std::filesystem::path& destination,
+        std::error_code& errorCode) const override;
+
+    void setModificationTime(const std::filesystem::path& path, std::int64_t modificationTime,
+        std::error_code& errorCode) const override;
+
+    bool copyFile(const std::filesystem::path& source, const std::filesystem::path& destination,
+        CopyStats& stats, std::error_code& errorCode) const override;
+
+    bool readFile(const std::filesystem::path& path, std::string& content, std::error_code& errorCode) const override;
+#ifdef __linux__
+    /**
+     * @brief Fill status from result of stat
+     */
+    static void toStatus(const struct stat& source, Status& status);
+#endif
+private:
+    NativeFileSystem();
+
+    FileCopier m_fileCopier;
+};
\ No newline at end of file
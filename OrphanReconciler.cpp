@@ -0,0 +1,213 @@
+#include "OrphanReconciler.h"
+#include <algorithm>
+#include <unordered_set>
+
+using namespace std;
+
+OrphanReconciler::OrphanReconciler():
+    m_folders{},
+    m_nameCounts{},
+    m_candidates{},
+    m_lookupKey{},
+    m_pass(0),
+    m_complete(false)
+{
+
+}
+
+void OrphanReconciler::beginPass()
+{
+    m_pass++;
+}
+
+OrphanReconciler::Folder& OrphanReconciler::visitFolder(string_view relativePath, bool listed)
+{
+    //key buffer is reused, known folders are looked up without allocating
+    m_lookupKey.assign(relativePath);
+    auto& folder = m_folders[m_lookupKey];
+
+    folder.pass = m_pass;
+    folder.listed = listed;
+    if (listed)
+    {
+        folder.seenCount = 0;
+        folder.addedNames.clear();
+    }
+
+    return folder;
+}
+
+void OrphanReconciler::keepListing(Folder& folder) const
+{
+    folder.listed = false;
+    folder.seenCount = 0;
+    folder.addedNames.clear();
+}
+
+void OrphanReconciler::countFile(Folder& folder, string_view name) const
+{
+    const auto found = lower_bound(folder.names.begin(), folder.names.end(), name,
+        [](const string& known, string_view wanted) { return string_view(known) < wanted; });
+    if (found != folder.names.end() && *found == name)
+    {
+        folder.seenInPass[static_cast<size_t>(found - folder.names.begin())] = m_pass;
+        folder.seenCount++;
+    }
+    else
+    {
+        folder.addedNames.emplace_back(name);
+    }
+}
+
+void OrphanReconciler::endPass()
+{
+    keepUnreachedFolders();
+
+    //names are added everywhere before any is removed, so a file moved between folders never counts as gone
+    bool complete = true;
+    for (auto& [path, folder] : m_folders)
+    {
+        if (folder.pass == m_pass && folder.listed)
+        {
+            folder.everListed = true;
+            for (const auto& name : folder.addedNames)
+            {
+                addName(name);
+            }
+        }
+        complete = complete && (folder.pass != m_pass || folder.everListed);
+    }
+
+    for (auto it = m_folders.begin(); it != m_folders.end();)
+    {
+        auto& folder = it->second;
+        if (folder.pass != m_pass)
+        {
+            for (const auto& name : folder.names)
+            {
+                removeName(name);
+            }
+            it = m_folders.erase(it);
+            continue;
+        }
+
+        //listing equal to the previous one is recognized by counts alone
+        if (folder.listed && (folder.seenCount != folder.names.size() || !folder.addedNames.empty()))
+        {
+            vector<string> names;
+            names.reserve(folder.seenCount + folder.addedNames.size());
+            for (size_t i = 0; i < folder.names.size(); i++)
+            {
+                if (folder.seenInPass[i] == m_pass)
+                {
+                    names.push_back(move(folder.names[i]));
+                }
+                else
+                {
+                    removeName(folder.names[i]);
+                }
+            }
+            move(folder.addedNames.begin(), folder.addedNames.end(), back_inserter(names));
+            sort(names.begin(), names.end());
+
+            folder.names.swap(names);
+            folder.seenInPass.assign(folder.names.size(), m_pass);
+            folder.addedNames.clear();
+        }
+        ++it;
+    }
+
+    m_complete = complete;
+}
+
+void OrphanReconciler::keepUnreachedFolders()
+{
+    const bool anyUnreached = any_of(m_folders.begin(), m_folders.end(),
+        [this](const auto& folder) { return folder.second.pass != m_pass; });
+    if (!anyUnreached)
+    {
+        return;
+    }
+
+    unordered_set<string_view> keptFolders;
+    for (const auto& [path, folder] : m_folders)
+    {
+        if (folder.pass == m_pass && !folder.listed)
+        {
+            keptFolders.insert(path);
+        }
+    }
+    if (keptFolders.empty())
+    {
+        return;
+    }
+
+    //folder below one which kept its previous listing was not descended into, it is still there as far as we know
+    for (auto& [path, folder] : m_folders)
+    {
+        if (folder.pass == m_pass)
+        {
+            continue;
+        }
+        const string_view folderPath(path);
+        for (auto separator = folderPath.rfind('/'); separator != string_view::npos && separator > 0;
+             separator = folderPath.rfind('/', separator - 1))
+        {
+            if (keptFolders.count(folderPath.substr(0, separator)) != 0)
+            {
+                folder.pass = m_pass;
+                folder.listed = false;
+                break;
+            }
+        }
+    }
+}
+
+bool OrphanReconciler::isComplete() const
+{
+    return m_complete;
+}
+
+bool OrphanReconciler::isLive(const string& name) const
+{
+    return m_nameCounts.find(name) != m_nameCounts.end();
+}
+
+void OrphanReconciler::addCandidate(const string& name)
+{
+    m_candidates.push_back(name);
+}
+
+void OrphanReconciler::takeCandidates(size_t count, vector<string>& names)
+{
+    names.clear();
+    while (names.size() < count && !m_candidates.empty())
+    {
+        names.push_back(move(m_candidates.front()));
+        m_candidates.pop_front();
+    }
+}
+
+size_t OrphanReconciler::getCandidateCount() const
+{
+    return m_candidates.size();
+}
+
+void OrphanReconciler::addName(const string& name)
+{
+    m_nameCounts[name]++;
+}
+
+void OrphanReconciler::removeName(const string& name)
+{
+    const auto found = m_nameCounts.find(name);
+    if (found == m_nameCounts.end())
+    {
+        return;
+    }
+    if (--found->second == 0)
+    {
+        m_nameCounts.erase(found);
+        m_candidates.push_back(name);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+/**
+ * @brief Keeps names of files in hot folder, so backups whose file was deleted or renamed can be found
+ * Every folder remembers names listed by the last pass which listed it. A pass only compares new listing of a folder
+ * with the previous one, names are counted over all folders as backup folder is flat. Name whose count drops to zero
+ * becomes a candidate orphan, so work after a pass is proportional to changes rather than size of the tree.
+ * Folders not listed by a pass (not due for directory poller, excluded by filter or not readable) keep their names,
+ * folders no longer reached lose them.
+ * Used by a single thread.
+ */
+class OrphanReconciler
+{
+public:
+    /**
+     * @brief Names of files in a folder
+     */
+    struct Folder
+    {
+        std::vector<std::string> names;
+        std::vector<std::uint64_t> seenInPass;
+        std::vector<std::string> addedNames;
+        std::uint64_t pass = 0;
+        std::size_t seenCount = 0;
+        bool listed = false;
+        bool everListed = false;
+    };
+
+    OrphanReconciler(const OrphanReconciler&) = delete;
+    OrphanReconciler& operator=(const OrphanReconciler&) = delete;
+    OrphanReconciler& operator==(const OrphanReconciler&) = delete;
+
+    OrphanReconciler();
+
+    void beginPass();
+    /**
+     * @brief Called for every folder the pass reaches, root included with empty path
+     * @param listed: files of folder are listed by this pass
+     * @return state of folder, valid till endPass
+     */
+    Folder& visitFolder(std::string_view relativePath, bool listed);
+    /**
+     * @brief Folder visited as listed could not be read after all, it keeps names of its previous listing
+     */
+    void keepListing(Folder& folder) const;
+    /**
+     * @brief File listed in folder, does not allocate for names listed before
+     */
+    void countFile(Folder& folder, std::string_view name) const;
+    /**
+     * @brief Applies differences of listings to name counts and forgets folders the pass did not reach
+     * Not called for interrupted passes.
+     */
+    void endPass();
+    /**
+     * @brief Every folder reached was listed at least once, names cover whole hot folder
+     */
+    bool isComplete() const;
+
+    bool isLive(const std::string& name) const;
+    /**
+     * @brief Remember name as possible orphan, for example backup found without its file in hot folder
+     */
+    void addCandidate(const std::string& name);
+    /**
+     * @brief Take up to count oldest candidates, each may have got its file back meanwhile
+     */
+    void takeCandidates(std::size_t count, std::vector<std::string>& names);
+
+    std::size_t getCandidateCount() const;
+private:
+    /**
+     * @brief Folders below a folder which kept its previous listing keep theirs as well, the pass did not descend into them
+     */
+    void keepUnreachedFolders();
+
+    void addName(const std::string& name);
+
+    void removeName(const std::string& name);
+
+    std::unordered_map<std::string, Folder> m_folders;
+    std::unordered_map<std::string, std::uint32_t> m_nameCounts;
+    std::deque<std::string> m_candidates;
+    std::string m_lookupKey;
+    std::uint64_t m_pass;
+    bool m_complete;
+};
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "Tests.h"
+#include "BackupFixture.h"
+#include "GlobalData.h"
+#include "OrphanReconciler.h"
+
+using namespace std;
+
+namespace
+{
+    /**
+     * @brief Hot folder kept in memory with orphan removal enabled
+     */
+    class OrphanFixture : public BackupFixture
+    {
+    public:
+        explicit OrphanFixture(const string& name):
+            BackupFixture(name, true)
+        {
+            auto& gd = GlobalData::getInstance();
+            gd.setOrphanMode(GlobalData::OrphanMode::Remove);
+            gd.setOrphanBatch(100);
+
+            for (const auto* file : {"a/f1.txt", "b/f2.txt", "b/sub/f3.txt", "c/f4.txt", "c/f5.tmp", "root.txt"})
+            {
+                getMemoryFileSystem().writeFile(getHot() / file, 10);
+            }
+        }
+
+        void removeFile(const string& relativePath)
+        {
+            error_code ec;
+            getMemoryFileSystem().remove(getHot() / relativePath, ec);
+        }
+    };
+}
+
+TEST(OrphanReconcilerKeepsListingOfUnreadableFolder)
+{
+    OrphanFixture fixture("orphans_unreadable");
+    fixture.runPasses(1);
+    for (const auto* name : {"f1.txt", "f2.txt", "f3.txt", "f4.txt", "f5.tmp", "root.txt"})
+    {
+        CHECK(fixture.hasBackup(name));
+    }
+
+    //files below a folder which can not be opened are not gone
+    fixture.getMemoryFileSystem().setUnreadable(fixture.getHot() / "b", true);
+    fixture.runPasses(2);
+    CHECK(fixture.hasBackup("f2.txt"));
+    CHECK(fixture.hasBackup("f3.txt"));
+    fixture.getMemoryFileSystem().setUnreadable(fixture.getHot() / "b", false);
+
+    //hot folder which can not be listed does not make every backup an orphan
+    fixture.getMemoryFileSystem().setUnreadable(fixture.getHot(), true);
+    fixture.runPasses(2);
+    CHECK(fixture.hasBackup("f1.txt"));
+    CHECK(fixture.hasBackup("root.txt"));
+    fixture.getMemoryFileSystem().setUnreadable(fixture.getHot(), false);
+
+    //readable again, deleted files lose their backups
+    fixture.removeFile("a/f1.txt");
+    fixture.removeFile("b/sub/f3.txt");
+    fixture.runPasses(2);
+    CHECK(!fixture.hasBackup("f1.txt"));
+    CHECK(!fixture.hasBackup("f3.txt"));
+    CHECK(fixture.hasBackup("f2.txt"));
+}
+
+TEST(OrphanReconcilerWaitsForFolderNeverListed)
+{
+    OrphanFixture fixture("orphans_never_listed");
+    fixture.getMemoryFileSystem().setUnreadable(fixture.getHot() / "b", true);
+    fixture.runPasses(1);
+    fixture.removeFile("a/f1.txt");
+    fixture.runPasses(2);
+    //names below b are unknown, so nothing counts as orphaned yet
+    CHECK(fixture.hasBackup("f1.txt"));
+
+    fixture.getMemoryFileSystem().setUnreadable(fixture.getHot() / "b", false);
+    fixture.runPasses(2);
+    CHECK(!fixture.hasBackup("f1.txt"));
+    CHECK(fixture.hasBackup("f2.txt"));
+}
+
+TEST(OrphanReconcilerKeepsBackupsOfExcludedEntries)
+{
+    OrphanFixture fixture("orphans_excluded");
+    fixture.runPasses(1);
+
+    //backups made before the rules were added stay, pruned folders were never listed by the new runner
+    auto& gd = GlobalData::getInstance();
+    gd.addFilterRule({PathFilter::RuleType::ExcludeGlob, "c"});
+    gd.addFilterRule({PathFilter::RuleType::ExcludeGlob, "sub"});
+    gd.addFilterRule({PathFilter::RuleType::ExcludeGlob, "root.txt"});
+    fixture.restartRunner();
+    fixture.removeFile("b/f2.txt");
+    fixture.runPasses(2);
+    CHECK(!fixture.hasBackup("f2.txt"));
+    CHECK(fixture.hasBackup("f1.txt"));
+    CHECK(fixture.hasBackup("f3.txt"));
+    CHECK(fixture.hasBackup("f4.txt"));
+    CHECK(fixture.hasBackup("f5.tmp"));
+    CHECK(fixture.hasBackup("root.txt"));
+}
+
+TEST(OrphanReconcilerKeptFolderKeepsSubfolders)
+{
+    OrphanReconciler reconciler;
+    reconciler.beginPass();
+    reconciler.countFile(reconciler.visitFolder({}, true), "top");
+    reconciler.countFile(reconciler.visitFolder("a", true), "one");
+    reconciler.countFile(reconciler.visitFolder("a/b", true), "two");
+    reconciler.endPass();
+    CHECK(reconciler.isComplete());
+    CHECK(reconciler.isLive("two"));
+
+    //a is not descended into, a/b is not reached but still exists
+    reconciler.beginPass();
+    reconciler.countFile(reconciler.visitFolder({}, true), "top");
+    auto& folder = reconciler.visitFolder("a", true);
+    reconciler.keepListing(folder);
+    reconciler.endPass();
+    CHECK(reconciler.isLive("one"));
+    CHECK(reconciler.isLive("two"));
+    CHECK(reconciler.getCandidateCount() == 0);
+
+    //listed again without b, its names become candidates
+    reconciler.beginPass();
+    reconciler.countFile(reconciler.visitFolder({}, true), "top");
+    reconciler.countFile(reconciler.visitFolder("a", true), "one");
+    reconciler.endPass();
+    CHECK(reconciler.isLive("one"));
+    CHECK(!reconciler.isLive("two"));
+    CHECK(reconciler.getCandidateCount() == 1);
+}
\ No newline at end of file
@@ -0,0 +1,735 @@
+#include "PackStore.h"
+#include "Crc32c.h"
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <chrono>
+#include <map>
+
+#ifdef __linux__
+#include <fcntl.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+const string PackStore::IndexFileName{"FolderBackupPack.idx"};
+const string PackStore::PackPrefix{"FolderBackupPack_"};
+const string PackStore::PackExtension{".pack"};
+const string PackStore::RemovedMarker{"-"};
+const uint64_t PackStore::MaxPackSize{256 * 1024 * 1024};
+const uint64_t PackStore::MinDeadBytesToCompact{64 * 1024 * 1024};
+const size_t PackStore::PackBufferSize{1024 * 1024};
+const size_t PackStore::MaxPendingIndexSize{64 * 1024};
+
+PackStore::PackStore():
+    m_mutex{},
+    m_entries{},
+    m_backupFolder{},
+    m_index{},
+    m_currentPack{},
+    m_packBuffer(PackBufferSize),
+    m_pendingIndex{},
+    m_packSizes{},
+    m_unownedPacks{},
+    m_currentPackNumber(0),
+    m_currentPackSize(0),
+    m_nextPackNumber(0),
+    m_nextVersion(1),
+    m_liveBytes(0),
+    m_totalBytes(0),
+    m_indexLineCount(0),
+    m_lookupKey{},
+    m_compactionMutex{}
+{
+
+}
+
+PackStore::~PackStore()
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    flushLocked();
+}
+
+void PackStore::load(const fs::path& backupFolder)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    //files packed into previously loaded folder are written out first
+    flushLocked();
+
+    m_backupFolder = backupFolder;
+    m_entries.clear();
+    m_packSizes.clear();
+    m_unownedPacks.clear();
+    m_currentPackNumber = 0;
+    m_currentPackSize = 0;
+    m_nextPackNumber = 0;
+    m_nextVersion = 1;
+    m_liveBytes = 0;
+    m_totalBytes = 0;
+    m_indexLineCount = 0;
+    if (m_index.is_open())
+    {
+        m_index.close();
+    }
+    if (m_currentPack.is_open())
+    {
+        m_currentPack.close();
+    }
+
+    {
+        ifstream index(m_backupFolder / IndexFileName, fstream::in);
+        string line;
+        while (getline(index, line))
+        {
+            string backupName;
+            optional<Entry> entry;
+            if (!parseLine(line, backupName, entry))
+            {
+                continue;
+            }
+
+            m_indexLineCount++;
+            if (entry)
+            {
+                m_nextVersion = max(m_nextVersion, entry->version + 1);
+                m_entries[backupName] = entry.value();
+            }
+            else
+            {
+                m_entries.erase(backupName);
+            }
+        }
+    }
+
+    map<uint32_t, uint64_t> packSizes;
+    //packs are found by name, anything between prefix and extension is the pack number
+    error_code ec;
+    for (const auto& file : fs::directory_iterator(m_backupFolder, ec))
+    {
+        const auto name = file.path().filename().string();
+        if (name.size() <= PackPrefix.size() + PackExtension.size() || name.compare(0, PackPrefix.size(), PackPrefix) != 0 ||
+            name.compare(name.size() - PackExtension.size(), PackExtension.size(), PackExtension) != 0)
+        {
+            continue;
+        }
+
+        uint32_t pack = 0;
+        try
+        {
+            pack = static_cast<uint32_t>(stoul(name.substr(PackPrefix.size(), name.size() - PackPrefix.size() - PackExtension.size())));
+        }
+        catch (const exception&)
+        {
+            continue;
+        }
+
+        error_code sizeError;
+        const auto size = file.file_size(sizeError);
+        packSizes[pack] = sizeError ? 0 : size;
+        m_nextPackNumber = max(m_nextPackNumber, pack + 1);
+    }
+
+    //entries past the end of their pack were indexed but their data never made it into the pack
+    for (auto entry = m_entries.begin(); entry != m_entries.end();)
+    {
+        const auto packSize = packSizes.find(entry->second.pack);
+        if (packSize == packSizes.end() || entry->second.offset + entry->second.length > packSize->second)
+        {
+            cerr << "Packed file " << entry->first << " is missing from pack: " << getPackPath(entry->second.pack).string() << "\n";
+            entry = m_entries.erase(entry);
+            continue;
+        }
+        m_liveBytes += entry->second.length;
+        ++entry;
+    }
+
+    //packs without entries are left as they are, only the writer removes them once it is safe
+    for (const auto& [backupName, entry] : m_entries)
+    {
+        m_packSizes[entry.pack] = packSizes[entry.pack];
+    }
+    for (const auto& [pack, size] : packSizes)
+    {
+        if (m_packSizes.find(pack) == m_packSizes.end())
+        {
+            m_unownedPacks.insert(pack);
+        }
+    }
+    for (const auto& [pack, size] : m_packSizes)
+    {
+        m_totalBytes += size;
+    }
+
+    //newest pack keeps being appended to, unless it is a pack nothing refers to
+    if (!m_packSizes.empty() && m_packSizes.rbegin()->first + 1 == m_nextPackNumber)
+    {
+        m_currentPackNumber = m_packSizes.rbegin()->first;
+        m_currentPackSize = m_packSizes.rbegin()->second;
+    }
+    else
+    {
+        m_currentPackNumber = m_nextPackNumber++;
+    }
+}
+
+void PackStore::maintain()
+{
+    bool compactionNeeded = false;
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        //garbage is judged by committed index only
+        if (!flushLocked())
+        {
+            return;
+        }
+
+        collectGarbageLocked();
+
+        //copying is amortized over the writes which made bytes dead
+        const auto deadBytes = m_totalBytes - min(m_totalBytes, m_liveBytes);
+        compactionNeeded = deadBytes >= MinDeadBytesToCompact && deadBytes > m_liveBytes;
+
+        if (!compactionNeeded && m_indexLineCount - min(m_indexLineCount, m_entries.size()) > m_entries.size())
+        {
+            //drop lines of overwritten and removed files
+            rewriteIndexLocked();
+        }
+    }
+
+    if (compactionNeeded)
+    {
+        compact();
+    }
+}
+
+void PackStore::collectGarbageLocked()
+{
+    if (m_unownedPacks.empty() || m_entries.empty())
+    {
+        return;
+    }
+
+    //packs older than newest committed pack are left by interrupted compaction,
+    //newer ones may be written by a writer which did not commit its index yet
+    uint32_t newestReferenced = 0;
+    for (const auto& [backupName, entry] : m_entries)
+    {
+        newestReferenced = max(newestReferenced, entry.pack);
+    }
+
+    for (auto pack = m_unownedPacks.begin(); pack != m_unownedPacks.end() && *pack < newestReferenced;)
+    {
+        error_code ec;
+        fs::remove(getPackPath(*pack), ec);
+        if (ec)
+        {
+            cerr << "Failed to remove unused pack: " << getPackPath(*pack).string() << " - Due to Error: " << ec.message() << "\n";
+        }
+        pack = m_unownedPacks.erase(pack);
+    }
+}
+
+bool PackStore::store(const string& backupName, const string& sourcePath, const char* data, size_t length,
+    int64_t lastWriteTime, uint32_t checksum, error_code& ec)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    if (m_currentPackSize > 0 && m_currentPackSize + length > MaxPackSize)
+    {
+        m_currentPack.close();
+        m_currentPackNumber = m_nextPackNumber++;
+        m_currentPackSize = 0;
+    }
+
+    if (!m_currentPack.is_open() && !openCurrentPack(m_currentPackNumber, ec))
+    {
+        return false;
+    }
+
+    Entry entry;
+    entry.version = m_nextVersion++;
+    entry.pack = m_currentPackNumber;
+    entry.offset = m_currentPackSize;
+    entry.length = length;
+    entry.lastWriteTime = lastWriteTime;
+    entry.checksum = checksum;
+    entry.sourcePath = sourcePath;
+
+    m_currentPack.write(data, static_cast<streamsize>(length));
+    if (!m_currentPack)
+    {
+        //size of a partly written pack is read again on next open
+        m_currentPack.close();
+        ec = make_error_code(errc::io_error);
+        return false;
+    }
+
+    m_currentPackSize += length;
+    m_packSizes[m_currentPackNumber] = m_currentPackSize;
+    m_totalBytes += length;
+
+    appendLine(formatLine(backupName, entry));
+
+    const auto previous = m_entries.find(backupName);
+    if (previous != m_entries.end())
+    {
+        m_liveBytes -= previous->second.length;
+        previous->second = move(entry);
+    }
+    else
+    {
+        m_entries.emplace(backupName, move(entry));
+    }
+    m_liveBytes += length;
+
+    return true;
+}
+
+bool PackStore::remove(const string& backupName)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    const auto entry = m_entries.find(backupName);
+    if (entry == m_entries.end())
+    {
+        return false;
+    }
+
+    m_liveBytes -= entry->second.length;
+    m_entries.erase(entry);
+    appendLine(backupName + "\t" + RemovedMarker);
+
+    return true;
+}
+
+optional<PackStore::Entry> PackStore::get(const string& backupName) const
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    const auto entry = m_entries.find(backupName);
+    if (entry == m_entries.end())
+    {
+        return nullopt;
+    }
+
+    return entry->second;
+}
+
+bool PackStore::isUpToDate(string_view backupName, uint64_t length, int64_t lastWriteTime) const
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    if (m_entries.empty())
+    {
+        return false;
+    }
+
+    //key buffer keeps its capacity, lookup does not allocate for names it has seen the size of
+    m_lookupKey.assign(backupName);
+    const auto entry = m_entries.find(m_lookupKey);
+
+    return entry != m_entries.end() && entry->second.length == length && entry->second.lastWriteTime == lastWriteTime;
+}
+
+bool PackStore::read(const Entry& entry, string& content, error_code& ec) const
+{
+    ifstream pack(getPackPath(entry.pack), ios::binary);
+    pack.seekg(static_cast<streamoff>(entry.offset));
+
+    content.resize(static_cast<size_t>(entry.length));
+    pack.read(content.data(), static_cast<streamsize>(entry.length));
+
+    if (!pack || static_cast<uint64_t>(pack.gcount()) != entry.length)
+    {
+        ec = make_error_code(errc::io_error);
+        return false;
+    }
+
+    return true;
+}
+
+vector<pair<string, PackStore::Entry>> PackStore::getAll() const
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    return {m_entries.begin(), m_entries.end()};
+}
+
+bool PackStore::isEmpty() const
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    return m_entries.empty();
+}
+
+fs::path PackStore::getPackPath(uint32_t pack) const
+{
+    char number[16];
+    snprintf(number, sizeof(number), "%06u", static_cast<unsigned int>(pack));
+
+    return m_backupFolder / (PackPrefix + number + PackExtension);
+}
+
+void PackStore::compact()
+{
+    lock_guard<mutex> compactionLock(m_compactionMutex);
+
+    vector<pair<string, Entry>> live;
+    vector<uint32_t> oldPacks;
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        //old index stays complete if compaction fails
+        if (!flushLocked())
+        {
+            return;
+        }
+
+        //packs written so far do not change anymore, files stored meanwhile go to a new pack
+        if (m_currentPack.is_open())
+        {
+            m_currentPack.close();
+        }
+        for (const auto& [pack, size] : m_packSizes)
+        {
+            oldPacks.push_back(pack);
+        }
+        m_currentPackNumber = m_nextPackNumber++;
+        m_currentPackSize = 0;
+
+        live.assign(m_entries.begin(), m_entries.end());
+    }
+
+    //pack data is copied without holding the index lock, so stores and lookups go on meanwhile
+    sort(live.begin(), live.end(), [](const auto& first, const auto& second)
+    {
+        return make_pair(first.second.pack, first.second.offset) < make_pair(second.second.pack, second.second.offset);
+    });
+
+    map<uint32_t, uint64_t> newPacks;
+    uint32_t pack = 0;
+    uint64_t packSize = 0;
+    ofstream output;
+    ifstream input;
+    optional<uint32_t> inputPack;
+    vector<char> buffer;
+    vector<bool> copied(live.size(), false);
+    bool failed = false;
+
+    for (size_t i = 0; i < live.size() && !failed; i++)
+    {
+        auto& [backupName, entry] = live[i];
+        if (!output.is_open() || (packSize > 0 && packSize + entry.length > MaxPackSize))
+        {
+            if (output.is_open())
+            {
+                output.close();
+                failed = output.fail();
+            }
+            {
+                lock_guard<mutex> lock(m_mutex);
+                pack = m_nextPackNumber++;
+            }
+            output.open(getPackPath(pack), ios::binary | ios::trunc);
+            newPacks[pack] = 0;
+            packSize = 0;
+        }
+
+        if (inputPack != entry.pack)
+        {
+            input.close();
+            input.clear();
+            input.open(getPackPath(entry.pack), ios::binary);
+            inputPack = entry.pack;
+        }
+
+        buffer.resize(static_cast<size_t>(entry.length));
+        input.seekg(static_cast<streamoff>(entry.offset));
+        input.read(buffer.data(), static_cast<streamsize>(entry.length));
+        if (!input || static_cast<uint64_t>(input.gcount()) != entry.length)
+        {
+            //unreadable file is forgotten so next pass stores it again from hot folder
+            cerr << "Failed to read " << backupName << " from pack: " << getPackPath(entry.pack).string() << "\n";
+            input.clear();
+            continue;
+        }
+
+        output.write(buffer.data(), static_cast<streamsize>(entry.length));
+        if (!output)
+        {
+            failed = true;
+            break;
+        }
+
+        entry.pack = pack;
+        entry.offset = packSize;
+        packSize += entry.length;
+        newPacks[pack] = packSize;
+        copied[i] = true;
+    }
+
+    if (output.is_open())
+    {
+        output.close();
+        failed = failed || output.fail();
+    }
+
+    auto removePacks = [this](const auto& packs)
+    {
+        for (const auto& removed : packs)
+        {
+            error_code ec;
+            fs::remove(getPackPath(removed.first), ec);
+        }
+    };
+
+    lock_guard<mutex> lock(m_mutex);
+
+    //files stored or removed while copying keep their newer state
+    auto compacted = m_entries;
+    uint64_t liveBytes = m_liveBytes;
+    for (size_t i = 0; i < live.size() && !failed; i++)
+    {
+        const auto entry = compacted.find(live[i].first);
+        if (entry == compacted.end() || entry->second.version != live[i].second.version)
+        {
+            continue;
+        }
+        if (copied[i])
+        {
+            entry->second = live[i].second;
+        }
+        else
+        {
+            liveBytes -= entry->second.length;
+            compacted.erase(entry);
+        }
+    }
+
+    swap(m_entries, compacted);
+    if (failed || !rewriteIndexLocked())
+    {
+        cerr << "Failed to compact packs in: " << m_backupFolder.string() << "\n";
+        swap(m_entries, compacted);
+        removePacks(newPacks);
+        return;
+    }
+    m_liveBytes = liveBytes;
+
+    set<uint32_t> referenced;
+    for (const auto& [backupName, entry] : m_entries)
+    {
+        referenced.insert(entry.pack);
+    }
+    for (const auto oldPack : oldPacks)
+    {
+        if (referenced.find(oldPack) != referenced.end())
+        {
+            continue;
+        }
+        m_totalBytes -= min(m_totalBytes, m_packSizes[oldPack]);
+        m_packSizes.erase(oldPack);
+        error_code ec;
+        fs::remove(getPackPath(oldPack), ec);
+    }
+    for (const auto& [newPack, size] : newPacks)
+    {
+        m_packSizes[newPack] = size;
+        m_totalBytes += size;
+    }
+}
+
+bool PackStore::rewriteIndexLocked()
+{
+    if (m_index.is_open())
+    {
+        m_index.close();
+    }
+
+    const auto indexPath = m_backupFolder / IndexFileName;
+    auto compacted = indexPath;
+    compacted += ".tmp";
+    {
+        //lines follow pack order, so a cut off index loses the newest packs first and never
+        //makes an older pack look unused
+        vector<const pair<const string, Entry>*> ordered;
+        ordered.reserve(m_entries.size());
+        for (const auto& entry : m_entries)
+        {
+            ordered.push_back(&entry);
+        }
+        sort(ordered.begin(), ordered.end(), [](const auto* first, const auto* second)
+        {
+            return make_pair(first->second.pack, first->second.offset) < make_pair(second->second.pack, second->second.offset);
+        });
+
+        ofstream index(compacted, fstream::trunc);
+        for (const auto* entry : ordered)
+        {
+            index << formatLine(entry->first, entry->second) << "\n";
+        }
+        index.flush();
+        if (!index)
+        {
+            error_code ec;
+            fs::remove(compacted, ec);
+            return false;
+        }
+    }
+
+    error_code ec;
+    fs::rename(compacted, indexPath, ec);
+    if (ec)
+    {
+        cerr << "Failed to compact pack index: " << indexPath.string() << " - Due to Error: " << ec.message() << "\n";
+        return false;
+    }
+
+    //rewritten index already holds every pending line
+    m_pendingIndex.clear();
+    m_indexLineCount = m_entries.size();
+
+    return true;
+}
+
+bool PackStore::openCurrentPack(uint32_t pack, error_code& ec)
+{
+    const auto packPath = getPackPath(pack);
+
+    m_currentPack.clear();
+    m_currentPack.rdbuf()->pubsetbuf(m_packBuffer.data(), static_cast<streamsize>(m_packBuffer.size()));
+    m_currentPack.open(packPath, ios::binary | ios::app);
+    if (!m_currentPack.is_open())
+    {
+        ec = make_error_code(errc::io_error);
+        return false;
+    }
+
+    error_code sizeError;
+    const auto size = fs::file_size(packPath, sizeError);
+    m_currentPackSize = sizeError ? 0 : size;
+    auto& packSize = m_packSizes[pack];
+    m_totalBytes += m_currentPackSize - min(m_currentPackSize, packSize);
+    packSize = m_currentPackSize;
+
+    return true;
+}
+
+void PackStore::appendLine(const string& line)
+{
+    m_indexLineCount++;
+    m_pendingIndex.append(line);
+    m_pendingIndex.push_back('\n');
+
+    if (m_pendingIndex.size() >= MaxPendingIndexSize)
+    {
+        flushLocked();
+    }
+}
+
+bool PackStore::flush()
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    return flushLocked();
+}
+
+bool PackStore::flushLocked()
+{
+    bool written = true;
+    if (m_currentPack.is_open())
+    {
+        m_currentPack.flush();
+        written = static_cast<bool>(m_currentPack);
+    }
+
+    if (!m_pendingIndex.empty())
+    {
+        //index is created with the first packed file, backup folders without packs stay untouched
+        if (!m_index.is_open())
+        {
+            m_index.clear();
+            m_index.open(m_backupFolder / IndexFileName, fstream::app);
+        }
+
+        m_index << m_pendingIndex;
+        m_index.flush();
+        written = written && static_cast<bool>(m_index);
+        m_pendingIndex.clear();
+    }
+
+    if (!written)
+    {
+        cerr << "Failed to write packs in: " << m_backupFolder.string() << "\n";
+    }
+
+    return written;
+}
+
+string PackStore::formatLine(const string& backupName, const Entry& entry) const
+{
+    return backupName + "\t" + to_string(entry.version) + "\t" + to_string(entry.pack) + "\t" + to_string(entry.offset) +
+        "\t" + to_string(entry.length) + "\t" + to_string(entry.lastWriteTime) + "\t" + Crc32c::toString(entry.checksum) +
+        "\t" + entry.sourcePath;
+}
+
+bool PackStore::parseLine(const string& line, string& backupName, optional<Entry>& entry) const
+{
+    const auto nameEnd = line.find('\t');
+    if (nameEnd == string::npos || nameEnd == 0)
+    {
+        return false;
+    }
+
+    backupName = line.substr(0, nameEnd);
+
+    if (line.compare(nameEnd + 1, string::npos, RemovedMarker) == 0)
+    {
+        entry = nullopt;
+        return true;
+    }
+
+    //seven fields follow the name, source path is last and may hold anything
+    string fields[7];
+    size_t fieldStart = nameEnd + 1;
+    for (size_t field = 0; field < 6; field++)
+    {
+        const auto fieldEnd = line.find('\t', fieldStart);
+        if (fieldEnd == string::npos)
+        {
+            return false;
+        }
+        fields[field] = line.substr(fieldStart, fieldEnd - fieldStart);
+        fieldStart = fieldEnd + 1;
+    }
+    fields[6] = line.substr(fieldStart);
+
+    const auto checksum = Crc32c::fromString(fields[5]);
+    if (!checksum)
+    {
+        return false;
+    }
+
+    Entry parsed;
+    try
+    {
+        parsed.version = stoull(fields[0]);
+        parsed.pack = static_cast<uint32_t>(stoul(fields[1]));
+        parsed.offset = stoull(fields[2]);
+        parsed.length = stoull(fields[3]);
+        parsed.lastWriteTime = stoll(fields[4]);
+    }
+    catch (const exception&)
+    {
+        return false;
+    }
+    parsed.checksum = checksum.value();
+    parsed.sourcePath = move(fields[6]);
+
+    entry = parsed;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+/**
+ * @brief Keeps backups of small files appended into large pack files instead of one .bak file each
+ * Index is an append only text file inside backup folder mapping backup name (same name a .bak file
+ * would have) to the newest version of the file: pack, offset, length, modification time, checksum
+ * and original path. Overwritten and removed versions stay in packs as dead bytes until compaction
+ * copies live entries into new packs and rewrites the index.
+ * Writes are buffered, pack data always reaches the file before index lines which point to it.
+ * Only the process writing backups changes files of the store, and only through store, remove, flush and maintain.
+ */
+class PackStore
+{
+public:
+    /**
+     * @brief Location of newest version of a packed file
+     * lastWriteTime: modification time of source, as produced by FileTime::getModificationTime
+     * sourcePath: location of original file relative to hot folder
+     */
+    struct Entry
+    {
+        std::uint64_t version = 0;
+        std::uint32_t pack = 0;
+        std::uint64_t offset = 0;
+        std::uint64_t length = 0;
+        std::int64_t lastWriteTime = 0;
+        std::uint32_t checksum = 0;
+        std::string sourcePath;
+    };
+
+    PackStore(const PackStore&) = delete;
+    PackStore& operator=(const PackStore&) = delete;
+    PackStore& operator==(const PackStore&) = delete;
+
+    PackStore();
+    ~PackStore();
+    /**
+     * @brief Read index of packs in backup folder, no file is changed
+     * Safe to call while another process keeps writing backups into the folder.
+     */
+    void load(const std::filesystem::path& backupFolder);
+    /**
+     * @brief Writer side housekeeping, called between backup passes
+     * Removes packs left by interrupted compaction, compacts packs once most of their bytes are dead
+     * and drops stale index lines.
+     */
+    void maintain();
+    /**
+     * @brief Append new version of a file to current pack
+     * @param data: whole content of the file
+     * @return false: pack or index could not be written, ec holds the reason
+     */
+    bool store(const std::string& backupName, const std::string& sourcePath, const char* data, std::size_t length,
+        std::int64_t lastWriteTime, std::uint32_t checksum, std::error_code& ec);
+    /**
+     * @brief Forget packed file, its bytes become dead
+     * @return true: file was packed
+     */
+    bool remove(const std::string& backupName);
+
+    std::optional<Entry> get(const std::string& backupName) const;
+    /**
+     * @brief Packed file exists with given size and modification time, does not allocate once warm
+     */
+    bool isUpToDate(std::string_view backupName, std::uint64_t length, std::int64_t lastWriteTime) const;
+    /**
+     * @brief Write out buffered pack data and index lines, for example at the end of a backup pass
+     * @return false: pack or index could not be written
+     */
+    bool flush();
+    /**
+     * @brief Read content of packed file, only flushed files can be read
+     */
+    bool read(const Entry& entry, std::string& content, std::error_code& ec) const;
+    /**
+     * @brief Copy of all entries, safe to use while backup keeps running
+     */
+    std::vector<std::pair<std::string, Entry>> getAll() const;
+
+    bool isEmpty() const;
+
+    std::filesystem::path getPackPath(std::uint32_t pack) const;
+    /**
+     * @brief Rewrite live entries into new packs and index
+     * Pack data is copied without holding the index lock, files stored meanwhile go to a new pack.
+     */
+    void compact();
+private:
+    /**
+     * @brief Delete packs no entry refers to which are older than the newest pack committed index refers to
+     */
+    void collectGarbageLocked();
+    bool rewriteIndexLocked();
+    bool openCurrentPack(std::uint32_t pack, std::error_code& ec);
+    bool flushLocked();
+    void appendLine(const std::string& line);
+    bool parseLine(const std::string& line, std::string& backupName, std::optional<Entry>& entry) const;
+    std::string formatLine(const std::string& backupName, const Entry& entry) const;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+    std::filesystem::path m_backupFolder;
+    std::ofstream m_index;
+    std::ofstream m_currentPack;
+    std::vector<char> m_packBuffer;
+    std::string m_pendingIndex;
+    std::map<std::uint32_t, std::uint64_t> m_packSizes;
+    std::set<std::uint32_t> m_unownedPacks;
+    std::uint32_t m_currentPackNumber;
+    std::uint64_t m_currentPackSize;
+    std::uint32_t m_nextPackNumber;
+    std::uint64_t m_nextVersion;
+    std::uint64_t m_liveBytes;
+    std::uint64_t m_totalBytes;
+    std::size_t m_indexLineCount;
+    mutable std::string m_lookupKey;
+    std::mutex m_compactionMutex;
+    static const std::string IndexFileName;
+    static const std::string PackPrefix;
+    static const std::string PackExtension;
+    static const std::string RemovedMarker;
+    static const std::uint64_t MaxPackSize;
+    static const std::uint64_t MinDeadBytesToCompact;
+    static const std::size_t PackBufferSize;
+    static const std::size_t MaxPendingIndexSize;
+};
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "Tests.h"
+#include "PackStore.h"
+#include "Crc32c.h"
+#include <algorithm>
+#include <fstream>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+    string contentOf(int i)
+    {
+        return string(static_cast<size_t>(500 + i), static_cast<char>('a' + i % 26));
+    }
+
+    bool storeFile(PackStore& store, int i, const string& content)
+    {
+        error_code ec;
+        const auto checksum = Crc32c::update(0, content.data(), content.size());
+        return store.store("file_" + to_string(i) + ".bak", "folder/file_" + to_string(i), content.data(), content.size(),
+            i, checksum, ec);
+    }
+
+    bool readsBack(const PackStore& store, int i, const string& content)
+    {
+        const auto entry = store.get("file_" + to_string(i) + ".bak");
+        if (!entry)
+        {
+            return false;
+        }
+        string read;
+        error_code ec;
+        return store.read(*entry, read, ec) && read == content && entry->checksum == Crc32c::update(0, read.data(), read.size()) &&
+            entry->sourcePath == "folder/file_" + to_string(i) && entry->lastWriteTime == i;
+    }
+
+    vector<fs::path> listPacks(const fs::path& folder)
+    {
+        vector<fs::path> packs;
+        for (const auto& file : fs::directory_iterator(folder))
+        {
+            if (file.path().extension() == ".pack")
+            {
+                packs.push_back(file.path());
+            }
+        }
+        sort(packs.begin(), packs.end());
+        return packs;
+    }
+
+    uint32_t newestReferencedPack(const PackStore& store)
+    {
+        uint32_t newest = 0;
+        for (const auto& [name, entry] : store.getAll())
+        {
+            newest = max(newest, entry.pack);
+        }
+        return newest;
+    }
+}
+
+TEST(PackStoreRoundTripAcrossLoad)
+{
+    const auto folder = TestRegistry::makeTempFolder("packs_round_trip");
+    {
+        PackStore store;
+        store.load(folder);
+        for (int i = 0; i < 20; i++)
+        {
+            CHECK(storeFile(store, i, contentOf(i)));
+        }
+        CHECK(storeFile(store, 3, "replaced"));
+        CHECK(store.remove("file_5.bak"));
+        CHECK(!store.remove("file_5.bak"));
+        CHECK(store.flush());
+    }
+
+    PackStore store;
+    store.load(folder);
+    CHECK(store.getAll().size() == 19);
+    CHECK(readsBack(store, 0, contentOf(0)));
+    CHECK(readsBack(store, 19, contentOf(19)));
+    CHECK(readsBack(store, 3, "replaced"));
+    CHECK(!store.get("file_5.bak"));
+    CHECK(store.isUpToDate("file_7.bak", contentOf(7).size(), 7));
+    CHECK(!store.isUpToDate("file_7.bak", contentOf(7).size(), 8));
+    CHECK(!store.isUpToDate("file_5.bak", contentOf(5).size(), 5));
+}
+
+TEST(PackStoreCompactionKeepsLiveEntries)
+{
+    const auto folder = TestRegistry::makeTempFolder("packs_compaction");
+    {
+        PackStore store;
+        store.load(folder);
+        for (int i = 0; i < 100; i++)
+        {
+            CHECK(storeFile(store, i, contentOf(i)));
+        }
+        for (int i = 0; i < 90; i++)
+        {
+            store.remove("file_" + to_string(i) + ".bak");
+        }
+        CHECK(store.flush());
+        const auto packsBefore = listPacks(folder);
+
+        store.compact();
+        CHECK(store.getAll().size() == 10);
+        for (int i = 90; i < 100; i++)
+        {
+            CHECK(readsBack(store, i, contentOf(i)));
+        }
+        //dead bytes are gone with the packs which held them
+        for (const auto& pack : packsBefore)
+        {
+            CHECK(!fs::exists(pack));
+        }
+
+        //store keeps working after compaction
+        CHECK(storeFile(store, 100, contentOf(100)));
+        CHECK(store.flush());
+    }
+
+    PackStore store;
+    store.load(folder);
+    CHECK(store.getAll().size() == 11);
+    for (int i = 90; i <= 100; i++)
+    {
+        CHECK(readsBack(store, i, contentOf(i)));
+    }
+}
+
+TEST(PackStoreLoadIsReadOnlyAndMaintainCollectsGarbage)
+{
+    const auto folder = TestRegistry::makeTempFolder("packs_garbage");
+    {
+        PackStore store;
+        store.load(folder);
+        for (int i = 0; i < 10; i++)
+        {
+            CHECK(storeFile(store, i, contentOf(i)));
+        }
+        CHECK(store.flush());
+        store.compact();
+    }
+
+    //packs nobody refers to, one older and one newer than every pack the index refers to
+    PackStore reader;
+    reader.load(folder);
+    const auto newest = newestReferencedPack(reader);
+    CHECK(newest > 0);
+    const auto olderPack = reader.getPackPath(0);
+    const auto newerPack = reader.getPackPath(newest + 50);
+    ofstream(olderPack) << "left by interrupted compaction";
+    ofstream(newerPack) << "written by a writer whose index lines are not visible yet";
+
+    const auto indexPath = folder / "FolderBackupPack.idx";
+    const auto indexSize = fs::file_size(indexPath);
+    {
+        PackStore readOnly;
+        readOnly.load(folder);
+        CHECK(readOnly.getAll().size() == 10);
+    }
+    CHECK(fs::exists(olderPack));
+    CHECK(fs::exists(newerPack));
+    CHECK(fs::file_size(indexPath) == indexSize);
+
+    PackStore writer;
+    writer.load(folder);
+    writer.maintain();
+    CHECK(!fs::exists(olderPack));
+    CHECK(fs::exists(newerPack));
+
+    //once the index refers to a newer pack the unreferenced one is garbage too
+    CHECK(storeFile(writer, 10, contentOf(10)));
+    const auto stored = writer.get("file_10.bak");
+    CHECK(stored && stored->pack > newest + 50);
+    writer.maintain();
+    CHECK(!fs::exists(newerPack));
+    for (int i = 0; i <= 10; i++)
+    {
+        CHECK(readsBack(writer, i, contentOf(i)));
+    }
+}
+
+TEST(PackStoreWithoutIndexDeletesNothing)
+{
+    const auto folder = TestRegistry::makeTempFolder("packs_without_index");
+    {
+        PackStore store;
+        store.load(folder);
+        CHECK(storeFile(store, 1, contentOf(1)));
+        CHECK(store.flush());
+    }
+    const auto packs = listPacks(folder);
+    CHECK(!packs.empty());
+    fs::remove(folder / "FolderBackupPack.idx");
+
+    PackStore store;
+    store.load(folder);
+    CHECK(store.isEmpty());
+    store.maintain();
+    store.compact();
+    for (const auto& pack : packs)
+    {
+        CHECK(fs::exists(pack));
+    }
+}
\ No newline at end of file
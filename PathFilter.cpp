@@ -0,0 +1,455 @@
+#include "PathFilter.h"
+#include <algorithm>
+
+using namespace std;
+
+PathFilter::Automaton::Automaton():
+    m_positionCount(0),
+    m_words(0),
+    m_positionBytes{},
+    m_positionLoops{},
+    m_starts{},
+    m_includeEnds{},
+    m_excludeEnds{},
+    m_byteMasks{},
+    m_loopMask{},
+    m_initialState{},
+    m_includeFinal{},
+    m_excludeFinal{}
+{
+
+}
+
+void PathFilter::Automaton::addGlob(const vector<pair<array<bool, 256>, bool>>& tokens, bool include)
+{
+    m_starts.push_back(m_positionCount);
+    for (const auto& token : tokens)
+    {
+        m_positionBytes.push_back(token.first);
+        m_positionLoops.push_back(token.second);
+    }
+
+    //end position accepts nothing, reaching it means the glob matched
+    m_positionBytes.push_back(array<bool, 256>{});
+    m_positionLoops.push_back(false);
+    m_positionCount = m_positionBytes.size();
+
+    (include ? m_includeEnds : m_excludeEnds).push_back(m_positionCount - 1);
+}
+
+void PathFilter::Automaton::compile()
+{
+    m_words = (m_positionCount + 63) / 64;
+    m_byteMasks.assign(256 * m_words, 0);
+    m_loopMask.assign(m_words, 0);
+    m_initialState.assign(m_words, 0);
+    m_includeFinal.assign(m_words, 0);
+    m_excludeFinal.assign(m_words, 0);
+
+    const auto setBit = [](uint64_t* words, size_t position) { words[position / 64] |= uint64_t{1} << (position % 64); };
+
+    for (size_t position = 0; position < m_positionCount; position++)
+    {
+        for (size_t byte = 0; byte < 256; byte++)
+        {
+            if (m_positionBytes[position][byte])
+            {
+                setBit(&m_byteMasks[byte * m_words], position);
+            }
+        }
+        if (m_positionLoops[position])
+        {
+            setBit(m_loopMask.data(), position);
+        }
+    }
+
+    for (const auto start : m_starts)
+    {
+        setBit(m_initialState.data(), start);
+    }
+    for (const auto end : m_includeEnds)
+    {
+        setBit(m_includeFinal.data(), end);
+    }
+    for (const auto end : m_excludeEnds)
+    {
+        setBit(m_excludeFinal.data(), end);
+    }
+
+    closeOverLoops(m_initialState);
+}
+
+bool PathFilter::Automaton::isEmpty() const
+{
+    return m_positionCount == 0;
+}
+
+const PathFilter::State& PathFilter::Automaton::getInitialState() const
+{
+    return m_initialState;
+}
+
+void PathFilter::Automaton::closeOverLoops(State& state) const
+{
+    //a looping position may match nothing, so the position after it is active as well
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        uint64_t carry = 0;
+        for (size_t word = 0; word < m_words; word++)
+        {
+            const auto loops = state[word] & m_loopMask[word];
+            const auto added = (loops << 1) | carry;
+            carry = loops >> 63;
+            if (added & ~state[word])
+            {
+                state[word] |= added;
+                changed = true;
+            }
+        }
+    }
+}
+
+bool PathFilter::Automaton::advance(State& state, string_view text) const
+{
+    if (m_words == 0)
+    {
+        return false;
+    }
+
+    for (const auto character : text)
+    {
+        const auto* byteMask = &m_byteMasks[static_cast<unsigned char>(character) * m_words];
+        uint64_t active = 0;
+
+        //positions which accept the byte either stay (loops) or move to the next position,
+        //words are updated from the top so the carry is taken from the not yet updated word below
+        for (size_t word = m_words; word-- > 0;)
+        {
+            const auto moved = state[word] & byteMask[word];
+            auto next = ((moved & ~m_loopMask[word]) << 1) | (moved & m_loopMask[word]);
+            if (word > 0)
+            {
+                next |= (state[word - 1] & byteMask[word - 1] & ~m_loopMask[word - 1]) >> 63;
+            }
+            state[word] = next;
+            active |= next;
+        }
+
+        if (active == 0)
+        {
+            return false;
+        }
+        closeOverLoops(state);
+    }
+
+    return true;
+}
+
+bool PathFilter::Automaton::intersects(const State& state, const State& mask) const
+{
+    for (size_t word = 0; word < m_words && word < state.size(); word++)
+    {
+        if (state[word] & mask[word])
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PathFilter::Automaton::matchesInclude(const State& state) const
+{
+    return intersects(state, m_includeFinal);
+}
+
+bool PathFilter::Automaton::matchesExclude(const State& state) const
+{
+    return intersects(state, m_excludeFinal);
+}
+
+PathFilter::PathFilter(const vector<Rule>& rules):
+    m_nameAutomaton(),
+    m_pathAutomaton(),
+    m_includeRegex(joinRegexes(rules, RuleType::IncludeRegex)),
+    m_excludeRegex(joinRegexes(rules, RuleType::ExcludeRegex)),
+    m_hasIncludeRules(false)
+{
+    for (const auto& rule : rules)
+    {
+        const bool include = rule.type == RuleType::IncludeGlob || rule.type == RuleType::IncludeRegex;
+        m_hasIncludeRules = m_hasIncludeRules || include;
+
+        if (rule.type != RuleType::IncludeGlob && rule.type != RuleType::ExcludeGlob)
+        {
+            continue;
+        }
+
+        if (rule.pattern.find('/') == string::npos)
+        {
+            m_nameAutomaton.addGlob(parseGlob(rule.pattern), include);
+            continue;
+        }
+
+        for (const auto& variant : expandGlob(rule.pattern, include))
+        {
+            m_pathAutomaton.addGlob(parseGlob(variant), include);
+        }
+    }
+
+    m_nameAutomaton.compile();
+    m_pathAutomaton.compile();
+}
+
+PathFilter::~PathFilter()
+{
+
+}
+
+bool PathFilter::isEmpty() const
+{
+    return m_nameAutomaton.isEmpty() && m_pathAutomaton.isEmpty() && !m_includeRegex && !m_excludeRegex;
+}
+
+bool PathFilter::needsRelativePath() const
+{
+    return m_includeRegex || m_excludeRegex;
+}
+
+const PathFilter::State& PathFilter::getRootState() const
+{
+    return m_pathAutomaton.getInitialState();
+}
+
+PathFilter::Decision PathFilter::evaluate(const State& parentState, string_view relativePath, string_view name,
+    bool isDirectory, State& state, State& nameState) const
+{
+    nameState = m_nameAutomaton.getInitialState();
+    const bool nameAlive = m_nameAutomaton.advance(nameState, name);
+
+    //parent state already has the '/' after parent folder name
+    state = parentState;
+    const bool pathAlive = m_pathAutomaton.advance(state, name);
+
+    const bool excluded = (nameAlive && m_nameAutomaton.matchesExclude(nameState)) ||
+        (pathAlive && m_pathAutomaton.matchesExclude(state)) ||
+        (m_excludeRegex && regex_search(relativePath.begin(), relativePath.end(), m_excludeRegex.value()));
+
+    if (excluded)
+    {
+        return isDirectory ? Decision::Prune : Decision::Skip;
+    }
+
+    if (isDirectory)
+    {
+        if (pathAlive)
+        {
+            m_pathAutomaton.advance(state, "/");
+        }
+        return Decision::Process;
+    }
+
+    if (!m_hasIncludeRules)
+    {
+        return Decision::Process;
+    }
+
+    const bool included = (nameAlive && m_nameAutomaton.matchesInclude(nameState)) ||
+        (pathAlive && m_pathAutomaton.matchesInclude(state)) ||
+        (m_includeRegex && regex_search(relativePath.begin(), relativePath.end(), m_includeRegex.value()));
+
+    return included ? Decision::Process : Decision::Skip;
+}
+
+bool PathFilter::isValidGlob(const string& glob)
+{
+    if (glob.empty())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < glob.size(); i++)
+    {
+        if (glob[i] == '\\' && ++i == glob.size())
+        {
+            return false;
+        }
+        if (glob[i] == '[')
+        {
+            //']' right after '[' or '[!' is a member of the class
+            size_t end = i + 1;
+            if (end < glob.size() && (glob[end] == '!' || glob[end] == '^'))
+            {
+                end++;
+            }
+            end = glob.find(']', end + 1);
+            if (end == string::npos)
+            {
+                return false;
+            }
+            i = end;
+        }
+    }
+
+    return true;
+}
+
+vector<string> PathFilter::expandGlob(const string& glob, bool include)
+{
+    //globs with '/' are anchored at hot folder
+    auto anchored = glob;
+    while (!anchored.empty() && anchored.front() == '/')
+    {
+        anchored.erase(anchored.begin());
+    }
+
+    //"**/" also matches zero folders, each occurrence doubles the variants
+    vector<string> variants;
+    vector<pair<string, size_t>> pending{{anchored, 0}};
+    while (!pending.empty())
+    {
+        auto [variant, from] = pending.back();
+        pending.pop_back();
+
+        size_t position = variant.find("**/", from);
+        while (position != string::npos && position > 0 && variant[position - 1] != '/')
+        {
+            position = variant.find("**/", position + 1);
+        }
+
+        if (position == string::npos)
+        {
+            variants.push_back(variant);
+            continue;
+        }
+
+        pending.push_back({variant, position + 3});
+        pending.push_back({variant.erase(position, 3), position});
+    }
+
+    //excluded "folder/**" prunes the folder itself instead of every entry inside it
+    const string everything{"/**"};
+    if (!include && anchored.size() > everything.size() &&
+        anchored.compare(anchored.size() - everything.size(), everything.size(), everything) == 0)
+    {
+        const auto count = variants.size();
+        for (size_t i = 0; i < count; i++)
+        {
+            if (variants[i].size() > everything.size())
+            {
+                variants.push_back(variants[i].substr(0, variants[i].size() - everything.size()));
+            }
+        }
+    }
+
+    sort(variants.begin(), variants.end());
+    variants.erase(unique(variants.begin(), variants.end()), variants.end());
+
+    return variants;
+}
+
+vector<pair<array<bool, 256>, bool>> PathFilter::parseGlob(const string& glob)
+{
+    vector<pair<array<bool, 256>, bool>> tokens;
+
+    array<bool, 256> anyButSeparator;
+    anyButSeparator.fill(true);
+    anyButSeparator['/'] = false;
+    array<bool, 256> anyByte;
+    anyByte.fill(true);
+
+    for (size_t i = 0; i < glob.size(); i++)
+    {
+        const auto character = glob[i];
+
+        if (character == '*')
+        {
+            bool crossesFolders = false;
+            while (i + 1 < glob.size() && glob[i + 1] == '*')
+            {
+                crossesFolders = true;
+                i++;
+            }
+            tokens.push_back({crossesFolders ? anyByte : anyButSeparator, true});
+        }
+        else if (character == '?')
+        {
+            tokens.push_back({anyButSeparator, false});
+        }
+        else if (character == '[')
+        {
+            array<bool, 256> members{};
+            size_t end = i + 1;
+            const bool negated = end < glob.size() && (glob[end] == '!' || glob[end] == '^');
+            if (negated)
+            {
+                end++;
+            }
+
+            bool first = true;
+            for (; end < glob.size() && (first || glob[end] != ']'); end++, first = false)
+            {
+                const auto low = static_cast<unsigned char>(glob[end]);
+                if (end + 2 < glob.size() && glob[end + 1] == '-' && glob[end + 2] != ']')
+                {
+                    const auto high = static_cast<unsigned char>(glob[end + 2]);
+                    for (unsigned int member = low; member <= high; member++)
+                    {
+                        members[member] = true;
+                    }
+                    end += 2;
+                }
+                else
+                {
+                    members[low] = true;
+                }
+            }
+
+            if (negated)
+            {
+                for (auto& member : members)
+                {
+                    member = !member;
+                }
+            }
+            members['/'] = false;
+            tokens.push_back({members, false});
+            i = end;
+        }
+        else
+        {
+            const auto literal = static_cast<unsigned char>(character == '\\' && i + 1 < glob.size() ? glob[++i] : character);
+            array<bool, 256> members{};
+            members[literal] = true;
+            tokens.push_back({members, false});
+        }
+    }
+
+    return tokens;
+}
+
+optional<regex> PathFilter::joinRegexes(const vector<Rule>& rules, RuleType type)
+{
+    //one alternation is searched once instead of every rule separately
+    string joined;
+    for (const auto& rule : rules)
+    {
+        if (rule.type != type)
+        {
+            continue;
+        }
+        if (!joined.empty())
+        {
+            joined += "|";
+        }
+        joined += "(?:" + rule.pattern + ")";
+    }
+
+    if (joined.empty())
+    {
+        return nullopt;
+    }
+
+    return regex(joined, regex::ECMAScript | regex::optimize);
+}
\ No newline at end of file
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+/**
+ * @brief Include/exclude rules for entries of hot folder, compiled once and evaluated per path component
+ * Globs support * ? [abc] [a-z] [!abc] and ** (also matches '/'). A glob without '/' is matched against the
+ * name of every file and folder, a glob with '/' against the whole path relative to hot folder.
+ * All globs are compiled into two bit-parallel automatons (names and paths), the path automaton state of
+ * a folder is reused for everything inside it. Regex rules are joined into one regex per rule type and
+ * searched in the relative path. Excluded folders are pruned, include rules only apply to files.
+ */
+class PathFilter
+{
+public:
+    enum class RuleType
+    {
+        IncludeGlob,
+        ExcludeGlob,
+        IncludeRegex,
+        ExcludeRegex
+    };
+    /**
+     * @brief Single rule as given on command line
+     */
+    struct Rule
+    {
+        RuleType type;
+        std::string pattern;
+    };
+    /**
+     * @brief Outcome of evaluating a single entry
+     * Process: entry goes through the usual backup checks
+     * Skip: file is excluded, or does not match any include rule
+     * Prune: folder is excluded, nothing inside it should be visited
+     */
+    enum class Decision
+    {
+        Process,
+        Skip,
+        Prune
+    };
+    /**
+     * @brief Active positions of an automaton, allocated from the memory resource of the walk
+     */
+    using State = std::pmr::vector<std::uint64_t>;
+    /**
+     * @throw std::regex_error: regex rule does not compile
+     */
+    explicit PathFilter(const std::vector<Rule>& rules);
+    ~PathFilter();
+    /**
+     * @return true: there are no rules, every entry is processed
+     */
+    bool isEmpty() const;
+    /**
+     * @return true: rules need the relative path as text, not only its components
+     */
+    bool needsRelativePath() const;
+    /**
+     * @brief State of hot folder itself, parent state of its direct children
+     */
+    const State& getRootState() const;
+    /**
+     * @brief Evaluate entry of a folder
+     * @param parentState: state of the folder holding the entry
+     * @param relativePath: path relative to hot folder with '/' separators, only read when needsRelativePath()
+     * @param name: file or folder name of the entry
+     * @param isDirectory: entry is a folder
+     * @param state: receives state of the entry, pass it as parentState for entries of this folder
+     * @param nameState: scratch state of name automaton, reused between calls so evaluating does not allocate
+     */
+    Decision evaluate(const State& parentState, std::string_view relativePath, std::string_view name, bool isDirectory,
+        State& state, State& nameState) const;
+    /**
+     * @brief Checks if glob is well formed
+     * @return false: unterminated character class or trailing escape
+     */
+    static bool isValidGlob(const std::string& glob);
+private:
+    /**
+     * @brief Bit-parallel NFA of a set of globs
+     * Every glob position is a bit, a position holds the bytes it accepts and whether it loops (*, **).
+     * A looping position can also be left without reading anything.
+     */
+    class Automaton
+    {
+    public:
+        Automaton();
+        /**
+         * @param tokens: accepted bytes and loop flag of every glob position
+         */
+        void addGlob(const std::vector<std::pair<std::array<bool, 256>, bool>>& tokens, bool include);
+        /**
+         * @brief Builds per byte masks, called after all globs are added
+         */
+        void compile();
+        bool isEmpty() const;
+        const State& getInitialState() const;
+        /**
+         * @brief Advance state over text
+         * @return false: no position is active anymore, nothing can match
+         */
+        bool advance(State& state, std::string_view text) const;
+        bool matchesInclude(const State& state) const;
+        bool matchesExclude(const State& state) const;
+    private:
+        void closeOverLoops(State& state) const;
+        bool intersects(const State& state, const State& mask) const;
+
+        std::size_t m_positionCount;
+        std::size_t m_words;
+        std::vector<std::array<bool, 256>> m_positionBytes;
+        std::vector<bool> m_positionLoops;
+        std::vector<std::size_t> m_starts;
+        std::vector<std::size_t> m_includeEnds;
+        std::vector<std::size_t> m_excludeEnds;
+        std::vector<std::uint64_t> m_byteMasks;
+        State m_loopMask;
+        State m_initialState;
+        State m_includeFinal;
+        State m_excludeFinal;
+    };
+
+    static std::vector<std::string> expandGlob(const std::string& glob, bool include);
+    static std::vector<std::pair<std::array<bool, 256>, bool>> parseGlob(const std::string& glob);
+    static std::optional<std::regex> joinRegexes(const std::vector<Rule>& rules, RuleType type);
+
+    Automaton m_nameAutomaton;
+    Automaton m_pathAutomaton;
+    std::optional<std::regex> m_includeRegex;
+    std::optional<std::regex> m_excludeRegex;
+    bool m_hasIncludeRules;
+};
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "Tests.h"
+#include "PathFilter.h"
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    /**
+     * @brief Evaluate every component of relative path like a walk does, decision of the last one is returned
+     * Folders above the entry which are not processed end the walk early, their decision is returned.
+     */
+    PathFilter::Decision evaluatePath(const PathFilter& filter, const string& relativePath, bool isDirectory)
+    {
+        PathFilter::State parentState = filter.getRootState();
+        PathFilter::State state;
+        PathFilter::State nameState;
+
+        size_t start = 0;
+        while (true)
+        {
+            const auto separator = relativePath.find('/', start);
+            const bool last = separator == string::npos;
+            const auto end = last ? relativePath.size() : separator;
+            const auto decision = filter.evaluate(parentState, string_view(relativePath).substr(0, end),
+                string_view(relativePath).substr(start, end - start), !last || isDirectory, state, nameState);
+            if (last || decision != PathFilter::Decision::Process)
+            {
+                return decision;
+            }
+            parentState.swap(state);
+            start = separator + 1;
+        }
+    }
+
+    PathFilter excluding(const vector<string>& globs)
+    {
+        vector<PathFilter::Rule> rules;
+        for (const auto& glob : globs)
+        {
+            rules.push_back({PathFilter::RuleType::ExcludeGlob, glob});
+        }
+        return PathFilter(rules);
+    }
+
+    bool isProcessed(const PathFilter& filter, const string& relativePath)
+    {
+        return evaluatePath(filter, relativePath, false) == PathFilter::Decision::Process;
+    }
+}
+
+TEST(PathFilterWithoutRulesProcessesEverything)
+{
+    const PathFilter filter({});
+    CHECK(filter.isEmpty());
+    CHECK(isProcessed(filter, "a/b/c.txt"));
+}
+
+TEST(PathFilterNameGlobWildcards)
+{
+    const auto filter = excluding({"*.tmp", "file?.log", "[a-c]x", "[!0-9]y"});
+    CHECK(!isProcessed(filter, "x.tmp"));
+    CHECK(!isProcessed(filter, "deep/folder/x.tmp"));
+    CHECK(!isProcessed(filter, ".tmp"));
+    CHECK(isProcessed(filter, "x.tmp.txt"));
+    CHECK(isProcessed(filter, "xtmp"));
+
+    CHECK(!isProcessed(filter, "file1.log"));
+    CHECK(isProcessed(filter, "file.log"));
+    CHECK(isProcessed(filter, "file12.log"));
+
+    CHECK(!isProcessed(filter, "bx"));
+    CHECK(isProcessed(filter, "dx"));
+    CHECK(!isProcessed(filter, "zy"));
+    CHECK(isProcessed(filter, "5y"));
+}
+
+TEST(PathFilterNameGlobMatchesWholeName)
+{
+    const auto filter = excluding({"build"});
+    CHECK(!isProcessed(filter, "build"));
+    CHECK(!isProcessed(filter, "src/build"));
+    CHECK(isProcessed(filter, "rebuild"));
+    CHECK(isProcessed(filter, "builder"));
+}
+
+TEST(PathFilterExcludedFolderIsPruned)
+{
+    const auto filter = excluding({"node_modules"});
+    CHECK(evaluatePath(filter, "app/node_modules", true) == PathFilter::Decision::Prune);
+    CHECK(evaluatePath(filter, "app/node_modules/x/index.js", false) == PathFilter::Decision::Prune);
+    CHECK(evaluatePath(filter, "node_modules.txt", false) == PathFilter::Decision::Process);
+    CHECK(evaluatePath(filter, "app/x.tmp", false) == PathFilter::Decision::Process);
+}
+
+TEST(PathFilterPathGlobs)
+{
+    const auto filter = excluding({"src/*.o", "**/cache/**", "docs/**/*.pdf"});
+    CHECK(!isProcessed(filter, "src/main.o"));
+    CHECK(isProcessed(filter, "src/sub/main.o"));
+    CHECK(isProcessed(filter, "other/src/main.o"));
+
+    CHECK(!isProcessed(filter, "cache/data"));
+    CHECK(!isProcessed(filter, "a/b/cache/c/data"));
+    CHECK(isProcessed(filter, "a/cached/data"));
+
+    CHECK(!isProcessed(filter, "docs/a.pdf"));
+    CHECK(!isProcessed(filter, "docs/x/y/a.pdf"));
+    CHECK(isProcessed(filter, "docs/x/y/a.txt"));
+    CHECK(isProcessed(filter, "other/docs/a.pdf"));
+}
+
+TEST(PathFilterIncludeRulesOnlyApplyToFiles)
+{
+    const PathFilter filter({{PathFilter::RuleType::IncludeGlob, "*.cpp"}, {PathFilter::RuleType::ExcludeGlob, "gen"}});
+    CHECK(isProcessed(filter, "src/main.cpp"));
+    CHECK(evaluatePath(filter, "src/main.h", false) == PathFilter::Decision::Skip);
+    CHECK(evaluatePath(filter, "src", true) == PathFilter::Decision::Process);
+    CHECK(evaluatePath(filter, "gen/main.cpp", false) == PathFilter::Decision::Prune);
+}
+
+TEST(PathFilterRegexRules)
+{
+    const PathFilter filter({{PathFilter::RuleType::ExcludeRegex, "^logs/.*\\.txt$"}});
+    CHECK(filter.needsRelativePath());
+    CHECK(!isProcessed(filter, "logs/today.txt"));
+    CHECK(isProcessed(filter, "logs/today.csv"));
+    CHECK(isProcessed(filter, "old/logs/today.txt"));
+}
+
+TEST(PathFilterManyGlobsSpanSeveralWords)
+{
+    //more positions than one 64 bit word of the automaton holds
+    vector<string> globs;
+    for (int i = 0; i < 40; i++)
+    {
+        globs.push_back("name_" + to_string(i) + "_*.bin");
+    }
+    const auto filter = excluding(globs);
+    CHECK(!isProcessed(filter, "name_0_a.bin"));
+    CHECK(!isProcessed(filter, "x/name_39_.bin"));
+    CHECK(isProcessed(filter, "name_40_a.bin"));
+    CHECK(isProcessed(filter, "name_39_a.bi"));
+}
+
+TEST(PathFilterValidatesGlobs)
+{
+    CHECK(PathFilter::isValidGlob("*.[ch]"));
+    CHECK(!PathFilter::isValidGlob("*.[ch"));
+}
\ No newline at end of file
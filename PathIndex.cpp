@@ -0,0 +1,333 @@
+#include "PathIndex.h"
+#include <algorithm>
+#include <cctype>
+
+using namespace std;
+
+const size_t PathIndex::TrigramLength{3};
+const size_t PathIndex::MaxPathLength{65536};
+
+namespace
+{
+    /**
+     * @brief Position after bracket expression or group starting at position, nested groups included
+     */
+    size_t skipBracketed(string_view pattern, size_t position)
+    {
+        const auto open = pattern[position];
+        const auto close = open == '(' ? ')' : ']';
+        size_t depth = 0;
+        for (auto i = position; i < pattern.size(); i++)
+        {
+            const auto c = pattern[i];
+            if (c == '\\')
+            {
+                i++;
+            }
+            else if (open == '[' && i == position + 1 && c == ']')
+            {
+                //']' right after '[' is a member of the bracket
+            }
+            else if (c == '[' && open == '(')
+            {
+                i = skipBracketed(pattern, i) - 1;
+            }
+            else if (c == open)
+            {
+                depth++;
+            }
+            else if (c == close && --depth == 0)
+            {
+                return i + 1;
+            }
+        }
+        return pattern.size();
+    }
+}
+
+PathIndex::PathIndex():
+    m_paths{},
+    m_pathIds{},
+    m_postings{},
+    m_trigrams{}
+{
+
+}
+
+void PathIndex::addPath(string_view path, uint64_t offset)
+{
+    auto found = m_pathIds.find(path);
+    if (found == m_pathIds.end())
+    {
+        const auto pathId = static_cast<uint32_t>(m_paths.size());
+        //deque keeps strings in place, dictionary keys point into them
+        const string_view stored = m_paths.emplace_back(path);
+        found = m_pathIds.emplace(stored, pathId).first;
+        m_postings.emplace_back();
+
+        for (size_t i = 0; i + TrigramLength <= stored.size(); i++)
+        {
+            //ids only grow, so list is sorted and a repeated trigram of this path is its last element
+            auto& paths = m_trigrams[toTrigram(stored, i)];
+            if (paths.empty() || paths.back() != pathId)
+            {
+                paths.push_back(pathId);
+            }
+        }
+    }
+
+    auto& postings = m_postings[found->second];
+    if (postings.empty() || postings.back() != offset)
+    {
+        postings.push_back(offset);
+    }
+}
+
+void PathIndex::findBySubstring(string_view text, vector<uint64_t>& offsets) const
+{
+    vector<uint32_t> candidates;
+    collectCandidates({string(text)}, candidates);
+
+    vector<uint32_t> matches;
+    for (const auto pathId : candidates)
+    {
+        if (m_paths[pathId].find(text) != string::npos)
+        {
+            matches.push_back(pathId);
+        }
+    }
+    collectOffsets(matches, offsets);
+}
+
+void PathIndex::findByRegex(const regex& searchRegex, string_view pattern, vector<uint64_t>& offsets) const
+{
+    vector<string> literals;
+    getRequiredLiterals(pattern, literals);
+
+    vector<uint32_t> candidates;
+    collectCandidates(literals, candidates);
+
+    vector<uint32_t> matches;
+    for (const auto pathId : candidates)
+    {
+        if (regex_search(m_paths[pathId], searchRegex))
+        {
+            matches.push_back(pathId);
+        }
+    }
+    collectOffsets(matches, offsets);
+}
+
+void PathIndex::write(ostream& output) const
+{
+    auto writeNumber = [&output](uint64_t number)
+    {
+        output.write(reinterpret_cast<const char*>(&number), sizeof(number));
+    };
+
+    writeNumber(m_paths.size());
+    for (size_t pathId = 0; pathId < m_paths.size(); pathId++)
+    {
+        const auto& path = m_paths[pathId];
+        const auto& postings = m_postings[pathId];
+        writeNumber(path.size());
+        output.write(path.data(), static_cast<streamsize>(path.size()));
+        writeNumber(postings.size());
+        output.write(reinterpret_cast<const char*>(postings.data()), static_cast<streamsize>(postings.size() * sizeof(uint64_t)));
+    }
+}
+
+bool PathIndex::read(istream& input)
+{
+    clear();
+
+    auto readNumber = [&input](uint64_t& number)
+    {
+        return static_cast<bool>(input.read(reinterpret_cast<char*>(&number), sizeof(number)));
+    };
+
+    uint64_t pathCount = 0;
+    bool isValid = readNumber(pathCount);
+    string path;
+    for (uint64_t i = 0; isValid && i < pathCount; i++)
+    {
+        uint64_t pathLength = 0;
+        uint64_t postingCount = 0;
+        //length is checked before allocating, so a damaged file cannot make a huge one
+        isValid = readNumber(pathLength) && pathLength > 0 && pathLength <= MaxPathLength;
+        if (isValid)
+        {
+            path.resize(static_cast<size_t>(pathLength));
+            isValid = input.read(path.data(), static_cast<streamsize>(pathLength)) && m_pathIds.count(path) == 0 &&
+                readNumber(postingCount) && postingCount > 0;
+        }
+
+        //paths are added in id order, so they get back the ids they were written with
+        uint64_t previous = 0;
+        for (uint64_t j = 0; isValid && j < postingCount; j++)
+        {
+            uint64_t offset = 0;
+            isValid = readNumber(offset) && (j == 0 || offset > previous);
+            if (isValid)
+            {
+                addPath(path, offset);
+                previous = offset;
+            }
+        }
+    }
+
+    if (!isValid)
+    {
+        clear();
+    }
+    return isValid;
+}
+
+void PathIndex::clear()
+{
+    m_paths.clear();
+    m_pathIds.clear();
+    m_postings.clear();
+    m_trigrams.clear();
+}
+
+size_t PathIndex::getPathCount() const
+{
+    return m_paths.size();
+}
+
+void PathIndex::collectCandidates(const vector<string>& literals, vector<uint32_t>& candidates) const
+{
+    vector<const vector<uint32_t>*> lists;
+    for (const auto& literal : literals)
+    {
+        for (size_t i = 0; i + TrigramLength <= literal.size(); i++)
+        {
+            const auto found = m_trigrams.find(toTrigram(literal, i));
+            if (found == m_trigrams.end())
+            {
+                //no path has this trigram, so none can match
+                candidates.clear();
+                return;
+            }
+            lists.push_back(&found->second);
+        }
+    }
+
+    if (lists.empty())
+    {
+        candidates.resize(m_paths.size());
+        for (uint32_t i = 0; i < candidates.size(); i++)
+        {
+            candidates[i] = i;
+        }
+        return;
+    }
+
+    //intersection starts from the shortest list and can only shrink
+    sort(lists.begin(), lists.end(), [](const auto* left, const auto* right) { return left->size() < right->size(); });
+    lists.erase(unique(lists.begin(), lists.end()), lists.end());
+
+    //common trigrams are in most paths, few candidates are looked up in their lists instead of walking them
+    candidates = *lists.front();
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); i++)
+    {
+        const auto& paths = *lists[i];
+        candidates.erase(remove_if(candidates.begin(), candidates.end(),
+            [&paths](uint32_t pathId) { return !binary_search(paths.begin(), paths.end(), pathId); }), candidates.end());
+    }
+}
+
+void PathIndex::collectOffsets(const vector<uint32_t>& paths, vector<uint64_t>& offsets) const
+{
+    offsets.clear();
+    for (const auto pathId : paths)
+    {
+        const auto& postings = m_postings[pathId];
+        offsets.insert(offsets.end(), postings.begin(), postings.end());
+    }
+
+    //record mentioning two matching paths, like source and its backup, is returned once
+    sort(offsets.begin(), offsets.end());
+    offsets.erase(unique(offsets.begin(), offsets.end()), offsets.end());
+}
+
+void PathIndex::getRequiredLiterals(string_view pattern, vector<string>& literals)
+{
+    string literal;
+    auto endLiteral = [&literal, &literals]()
+    {
+        if (literal.size() >= TrigramLength)
+        {
+            literals.push_back(literal);
+        }
+        literal.clear();
+    };
+
+    for (size_t i = 0; i < pattern.size(); i++)
+    {
+        const auto c = pattern[i];
+        if (c == '|')
+        {
+            //any of the alternatives may match, none of them is required
+            literals.clear();
+            return;
+        }
+        else if (c == '(' || c == '[')
+        {
+            //contents of groups and brackets are not relied upon
+            endLiteral();
+            i = skipBracketed(pattern, i) - 1;
+        }
+        else if (c == '\\' && i + 1 < pattern.size())
+        {
+            const auto escaped = pattern[++i];
+            if (isalnum(static_cast<unsigned char>(escaped)))
+            {
+                //character class, anchor, backreference or character code
+                endLiteral();
+                const size_t codeLength = escaped == 'x' ? 2 : escaped == 'u' ? 4 : escaped == 'c' ? 1 : 0;
+                i = min(i + codeLength, pattern.size() - 1);
+                while (isdigit(static_cast<unsigned char>(escaped)) && i + 1 < pattern.size() &&
+                    isdigit(static_cast<unsigned char>(pattern[i + 1])))
+                {
+                    i++;
+                }
+            }
+            else
+            {
+                literal += escaped;
+            }
+        }
+        else if (c == '*' || c == '?' || c == '{')
+        {
+            //quantified character may be missing
+            if (!literal.empty())
+            {
+                literal.pop_back();
+            }
+            endLiteral();
+            if (c == '{')
+            {
+                const auto close = pattern.find('}', i);
+                i = close == string_view::npos ? pattern.size() : close;
+            }
+        }
+        else if (c == '+' || c == '.' || c == '^' || c == '$')
+        {
+            endLiteral();
+        }
+        else
+        {
+            literal += c;
+        }
+    }
+    endLiteral();
+}
+
+uint32_t PathIndex::toTrigram(string_view text, size_t position)
+{
+    return static_cast<uint32_t>(static_cast<unsigned char>(text[position])) << 16 |
+        static_cast<uint32_t>(static_cast<unsigned char>(text[position + 1])) << 8 |
+        static_cast<uint32_t>(static_cast<unsigned char>(text[position + 2]));
+}
\ No newline at end of file
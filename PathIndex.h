@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <ostream>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+/**
+ * @brief Side index of log records by the paths they mention, so file name searches do not read every record
+ * Distinct paths are kept in a dictionary, trigrams of each path point to the paths containing them and every path
+ * has a posting list of offsets of records mentioning it. Queries pick candidate paths by trigrams, check only
+ * them and return offsets of their records.
+ * Not thread safe, LogUtility guards it with its records mutex.
+ */
+class PathIndex
+{
+public:
+    PathIndex(const PathIndex&) = delete;
+    PathIndex& operator=(const PathIndex&) = delete;
+    PathIndex& operator==(const PathIndex&) = delete;
+
+    PathIndex();
+    /**
+     * @brief Remember that record at offset mentions path, records have to be added in offset order
+     * @param offset: position of record in log file
+     */
+    void addPath(std::string_view path, std::uint64_t offset);
+    /**
+     * @brief Offsets of records mentioning a path which contains text
+     * @param offsets: filled in ascending order without duplicates
+     */
+    void findBySubstring(std::string_view text, std::vector<std::uint64_t>& offsets) const;
+    /**
+     * @brief Offsets of records mentioning a path searchRegex matches part of
+     * @param pattern: source of searchRegex, literal parts every match needs narrow down candidate paths
+     * @param offsets: filled in ascending order without duplicates
+     */
+    void findByRegex(const std::regex& searchRegex, std::string_view pattern, std::vector<std::uint64_t>& offsets) const;
+    /**
+     * @brief Store paths and their postings, trigrams are rebuilt from paths when read
+     * Format uses native byte order, file is a cache of the machine which wrote it.
+     */
+    void write(std::ostream& output) const;
+    /**
+     * @brief Replace content with paths and postings stored by write
+     * @return false: data is cut off or malformed, index is left empty
+     */
+    bool read(std::istream& input);
+    /**
+     * @brief Forget all paths
+     */
+    void clear();
+    /**
+     * @brief amount of distinct paths in dictionary
+     */
+    std::size_t getPathCount() const;
+private:
+    /**
+     * @brief Paths containing every trigram of literals, all paths when literals are too short to have any
+     */
+    void collectCandidates(const std::vector<std::string>& literals, std::vector<std::uint32_t>& candidates) const;
+    void collectOffsets(const std::vector<std::uint32_t>& paths, std::vector<std::uint64_t>& offsets) const;
+    /**
+     * @brief Literal runs of an ECMAScript regex which are part of every match, nothing when pattern has alternatives
+     */
+    static void getRequiredLiterals(std::string_view pattern, std::vector<std::string>& literals);
+    static std::uint32_t toTrigram(std::string_view text, std::size_t position);
+
+    std::deque<std::string> m_paths;
+    std::unordered_map<std::string_view, std::uint32_t> m_pathIds;
+    std::vector<std::vector<std::uint64_t>> m_postings;
+    std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> m_trigrams;
+    static const std::size_t TrigramLength;
+    /**
+     * @brief Longest path accepted when reading stored index
+     */
+    static const std::size_t MaxPathLength;
+};
\ No newline at end of file
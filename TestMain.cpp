@@ -0,0 +1,77 @@
+#include "Tests.h"
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+    vector<pair<string, function<void()>>>& getTests()
+    {
+        static vector<pair<string, function<void()>>> s_tests;
+        return s_tests;
+    }
+
+    int s_failedChecks = 0;
+}
+
+bool TestRegistry::add(const char* name, function<void()> test)
+{
+    getTests().emplace_back(name, move(test));
+    return true;
+}
+
+void TestRegistry::check(bool condition, const char* expression, const char* file, int line)
+{
+    if (!condition)
+    {
+        s_failedChecks++;
+        cerr << file << ":" << line << ": check failed: " << expression << "\n";
+    }
+}
+
+int TestRegistry::run(const string& filter)
+{
+    size_t testCount = 0;
+    for (const auto& [name, test] : getTests())
+    {
+        if (name.find(filter) == string::npos)
+        {
+            continue;
+        }
+
+        const auto failedBefore = s_failedChecks;
+        try
+        {
+            test();
+        }
+        catch (const exception& e)
+        {
+            s_failedChecks++;
+            cerr << name << ": unexpected exception: " << e.what() << "\n";
+        }
+        cout << (s_failedChecks == failedBefore ? "[  OK  ] " : "[FAILED] ") << name << endl;
+        testCount++;
+    }
+
+    cout << testCount << " tests, " << s_failedChecks << " failed checks" << endl;
+    return s_failedChecks;
+}
+
+fs::path TestRegistry::makeTempFolder(const string& name)
+{
+    const auto folder = fs::temp_directory_path() / ("FolderBackupTests_" + name);
+    fs::remove_all(folder);
+    fs::create_directories(folder);
+    return folder;
+}
+
+/**
+ * @brief FolderBackupTests [filter], runs tests whose name contains filter
+ */
+int main(int argc, char** argv)
+{
+    return TestRegistry::run(argc > 1 ? argv[1] : "") == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <string>
+/**
+ * @brief Registry of FolderBackupTests, tests register themselves with TEST and report with CHECK
+ * A failed check is reported and counted, the test goes on, so one run lists every failure.
+ */
+class TestRegistry
+{
+public:
+    TestRegistry() = delete;
+    /**
+     * @return always true, result initializes the static which registers the test
+     */
+    static bool add(const char* name, std::function<void()> test);
+
+    static void check(bool condition, const char* expression, const char* file, int line);
+    /**
+     * @brief Run tests whose name contains filter, every test when filter is empty
+     * @return number of failed checks
+     */
+    static int run(const std::string& filter);
+    /**
+     * @brief Empty folder in temp directory, removed and created again for every call
+     */
+    static std::filesystem::path makeTempFolder(const std::string& name);
+};
+
+#define TEST(name) \
+    static void name(); \
+    static const bool name##Registered = TestRegistry::add(#name, name); \
+    static void name()
+
+#define CHECK(condition) TestRegistry::check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "TimestampFormatter.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <limits>
+
+using namespace std;
+
+const size_t TimestampFormatter::Length{29};
+
+namespace
+{
+    /**
+     * @brief Position of milliseconds in formatted time
+     */
+    const size_t MillisecondsPosition{20};
+    /**
+     * @brief Seconds since 1970-01-01 of broken down time read as UTC
+     */
+    int64_t toSecondsAsUtc(const tm& time)
+    {
+        //days since 1970-01-01 of a proleptic gregorian date
+        const int year = time.tm_year + 1900;
+        const int month = time.tm_mon + 1;
+        const int shiftedYear = year - (month <= 2 ? 1 : 0);
+        const int era = (shiftedYear >= 0 ? shiftedYear : shiftedYear - 399) / 400;
+        const int yearOfEra = shiftedYear - era * 400;
+        const int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + time.tm_mday - 1;
+        const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        const int64_t days = static_cast<int64_t>(era) * 146097 + dayOfEra - 719468;
+
+        return days * 86400 + time.tm_hour * 3600 + time.tm_min * 60 + time.tm_sec;
+    }
+    /**
+     * @brief Write lowest count decimal digits of value, leading zeros included
+     */
+    void writeDigits(char* destination, int value, size_t count)
+    {
+        for (size_t i = count; i > 0; i--)
+        {
+            destination[i - 1] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    }
+}
+
+TimestampFormatter::TimestampFormatter():
+    m_cachedSecond(numeric_limits<int64_t>::min()),
+    m_buffer{}
+{
+
+}
+
+void TimestampFormatter::append(string& text)
+{
+    append(text, chrono::system_clock::now());
+}
+
+void TimestampFormatter::append(string& text, chrono::system_clock::time_point time)
+{
+    const auto milliseconds = chrono::floor<chrono::milliseconds>(time.time_since_epoch()).count();
+    const auto second = chrono::floor<chrono::seconds>(chrono::milliseconds(milliseconds)).count();
+    const auto millisecond = static_cast<int>(milliseconds - second * 1000);
+
+    if (second != m_cachedSecond)
+    {
+        formatSecond(second);
+        m_cachedSecond = second;
+    }
+
+    m_buffer[MillisecondsPosition] = static_cast<char>('0' + millisecond / 100);
+    m_buffer[MillisecondsPosition + 1] = static_cast<char>('0' + millisecond / 10 % 10);
+    m_buffer[MillisecondsPosition + 2] = static_cast<char>('0' + millisecond % 10);
+    text.append(m_buffer.data(), Length);
+}
+
+optional<chrono::system_clock::time_point> TimestampFormatter::parse(string_view text)
+{
+    const string terminated{text};
+    tm time{};
+    int consumed = 0;
+    if (sscanf(terminated.c_str(), "%4d-%2d-%2dT%2d:%2d:%2d%n", &time.tm_year, &time.tm_mon, &time.tm_mday,
+            &time.tm_hour, &time.tm_min, &time.tm_sec, &consumed) != 6 ||
+        time.tm_mon < 1 || time.tm_mon > 12 || time.tm_mday < 1 || time.tm_mday > 31 ||
+        time.tm_hour > 23 || time.tm_min > 59 || time.tm_sec > 60)
+    {
+        return nullopt;
+    }
+    time.tm_year -= 1900;
+    time.tm_mon -= 1;
+
+    auto rest = text.substr(static_cast<size_t>(consumed));
+    int milliseconds = 0;
+    if (!rest.empty() && rest.front() == '.')
+    {
+        size_t digits = 1;
+        while (digits < rest.size() && isdigit(static_cast<unsigned char>(rest[digits])))
+        {
+            //only milliseconds are kept, finer digits are dropped
+            if (digits <= 3)
+            {
+                milliseconds = milliseconds * 10 + (rest[digits] - '0');
+            }
+            digits++;
+        }
+        if (digits == 1)
+        {
+            return nullopt;
+        }
+        for (auto i = digits; i <= 3; i++)
+        {
+            milliseconds *= 10;
+        }
+        rest.remove_prefix(digits);
+    }
+
+    int offsetMinutes = 0;
+    if (rest == "Z" || rest == "z")
+    {
+        rest = {};
+    }
+    else if (!rest.empty() && (rest.front() == '+' || rest.front() == '-'))
+    {
+        const string offset{rest.substr(1)};
+        int offsetHours, offsetRemainder, offsetLength = 0;
+        if ((sscanf(offset.c_str(), "%2d:%2d%n", &offsetHours, &offsetRemainder, &offsetLength) != 2 &&
+             sscanf(offset.c_str(), "%2d%2d%n", &offsetHours, &offsetRemainder, &offsetLength) != 2) ||
+            static_cast<size_t>(offsetLength) != offset.size() || offsetHours > 23 || offsetRemainder > 59)
+        {
+            return nullopt;
+        }
+        offsetMinutes = (rest.front() == '-' ? -1 : 1) * (offsetHours * 60 + offsetRemainder);
+        rest = {};
+    }
+    if (!rest.empty())
+    {
+        return nullopt;
+    }
+
+    //local time of an offset is ahead of UTC by that offset, same relation formatSecond writes
+    return chrono::system_clock::time_point{
+        chrono::seconds(toSecondsAsUtc(time) - offsetMinutes * 60) + chrono::milliseconds(milliseconds)};
+}
+
+void TimestampFormatter::formatSecond(int64_t second)
+{
+    const auto time = static_cast<time_t>(second);
+    tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &time);
+#else
+    localtime_r(&time, &local);
+#endif
+
+    //local time read as UTC differs from real time by offset in effect at that second, daylight saving included
+    const auto offsetMinutes = static_cast<int>((toSecondsAsUtc(local) - second) / 60);
+    const auto absoluteOffset = abs(offsetMinutes);
+
+    //layout of 2023-02-12T14:20:55.123+02:00
+    auto* text = m_buffer.data();
+    writeDigits(text, local.tm_year + 1900, 4);
+    text[4] = '-';
+    writeDigits(text + 5, local.tm_mon + 1, 2);
+    text[7] = '-';
+    writeDigits(text + 8, local.tm_mday, 2);
+    text[10] = 'T';
+    writeDigits(text + 11, local.tm_hour, 2);
+    text[13] = ':';
+    writeDigits(text + 14, local.tm_min, 2);
+    text[16] = ':';
+    writeDigits(text + 17, local.tm_sec, 2);
+    text[19] = '.';
+    text[23] = offsetMinutes < 0 ? '-' : '+';
+    writeDigits(text + 24, absoluteOffset / 60, 2);
+    text[26] = ':';
+    writeDigits(text + 27, absoluteOffset % 60, 2);
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+/**
+ * @brief Formats local time of log records, for example 2023-02-12T14:20:55.123+02:00
+ * Date, time and offset from UTC are formatted once per second, records within the same second only get their
+ * milliseconds patched in. Used by a single thread, log writer keeps one per thread.
+ */
+class TimestampFormatter
+{
+public:
+    TimestampFormatter(const TimestampFormatter&) = delete;
+    TimestampFormatter& operator=(const TimestampFormatter&) = delete;
+    TimestampFormatter& operator==(const TimestampFormatter&) = delete;
+
+    TimestampFormatter();
+    /**
+     * @brief Append current time to text, does not allocate when text has capacity for Length more characters
+     */
+    void append(std::string& text);
+
+    void append(std::string& text, std::chrono::system_clock::time_point time);
+    /**
+     * @brief Parse time in the format appended, for example 2023-02-12T14:20:55.123+02:00
+     * Milliseconds are optional, finer digits are dropped. Time without Z or offset from UTC is taken as UTC.
+     * @return nullopt: text is not a time in this format
+     */
+    static std::optional<std::chrono::system_clock::time_point> parse(std::string_view text);
+    /**
+     * @brief Characters appended by every call
+     */
+    static const std::size_t Length;
+private:
+    void formatSecond(std::int64_t second);
+
+    std::int64_t m_cachedSecond;
+    std::array<char, 29> m_buffer;
+};
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "Tests.h"
+#include "TimestampFormatter.h"
+#include <cstdlib>
+#include <ctime>
+
+using namespace std;
+
+namespace
+{
+    /**
+     * @brief Format time with a fresh formatter and parse it back
+     */
+    optional<chrono::system_clock::time_point> roundTrip(chrono::system_clock::time_point time, string& text)
+    {
+        TimestampFormatter formatter;
+        text.clear();
+        formatter.append(text, time);
+        return TimestampFormatter::parse(text);
+    }
+
+    void checkRoundTrips()
+    {
+        //2023-02-12T12:20:55.123Z, a summer time and a time before 1970
+        const chrono::system_clock::time_point times[]{
+            chrono::system_clock::time_point{chrono::milliseconds(1676204455123)},
+            chrono::system_clock::time_point{chrono::milliseconds(1690000000007)},
+            chrono::system_clock::time_point{chrono::milliseconds(-86399999)},
+            chrono::time_point_cast<chrono::milliseconds>(chrono::system_clock::now())};
+        for (const auto time : times)
+        {
+            string text;
+            const auto parsed = roundTrip(time, text);
+            CHECK(text.size() == TimestampFormatter::Length);
+            CHECK(parsed.has_value() && parsed.value() == time);
+        }
+    }
+}
+
+TEST(TimestampFormatterRoundTripInLocalZone)
+{
+    checkRoundTrips();
+}
+
+#ifdef __linux__
+TEST(TimestampFormatterRoundTripWithOffset)
+{
+    const char* previous = getenv("TZ");
+    const string previousZone = previous == nullptr ? "" : previous;
+
+    //zones given as POSIX rules need no time zone database, sign is reversed: UTC-05:30 is ahead of UTC
+    for (const auto* zone : {"UTC-05:30", "UTC+03:45", "UTC0"})
+    {
+        setenv("TZ", zone, 1);
+        tzset();
+        checkRoundTrips();
+    }
+
+    setenv("TZ", "UTC-05:30", 1);
+    tzset();
+    string text;
+    roundTrip(chrono::system_clock::time_point{chrono::milliseconds(1676204455123)}, text);
+    CHECK(text == "2023-02-12T17:50:55.123+05:30");
+
+    if (previous == nullptr)
+    {
+        unsetenv("TZ");
+    }
+    else
+    {
+        setenv("TZ", previousZone.c_str(), 1);
+    }
+    tzset();
+}
+#endif
+
+TEST(TimestampFormatterParsesSuffixes)
+{
+    const chrono::system_clock::time_point expected{chrono::milliseconds(1676204455123)};
+    CHECK(TimestampFormatter::parse("2023-02-12T12:20:55.123Z") == expected);
+    CHECK(TimestampFormatter::parse("2023-02-12T12:20:55.123") == expected);
+    CHECK(TimestampFormatter::parse("2023-02-12T14:20:55.123+02:00") == expected);
+    CHECK(TimestampFormatter::parse("2023-02-12T14:20:55.123+0200") == expected);
+    CHECK(TimestampFormatter::parse("2023-02-12T10:50:55.123-01:30") == expected);
+    CHECK(TimestampFormatter::parse("2023-02-12T12:20:55.1234567Z") == expected);
+    CHECK(TimestampFormatter::parse("2023-02-12T12:20:55.1Z") == expected - chrono::milliseconds(23));
+    CHECK(TimestampFormatter::parse("2023-02-12T12:20:55") == expected - chrono::milliseconds(123));
+
+    CHECK(!TimestampFormatter::parse("2023-02-12"));
+    CHECK(!TimestampFormatter::parse("2023-02-12T12:20:55."));
+    CHECK(!TimestampFormatter::parse("2023-02-12T12:20:55.123+2"));
+    CHECK(!TimestampFormatter::parse("2023-02-12T12:20:55.123+02:00x"));
+    CHECK(!TimestampFormatter::parse("2023-13-12T12:20:55Z"));
+    CHECK(!TimestampFormatter::parse("yesterday"));
+}
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "Tracer.h"
+#include <fstream>
+#include <algorithm>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+atomic<bool> Tracer::s_enabled{false};
+const size_t Tracer::MaxEventsPerThread{4 * 1024 * 1024};
+
+Tracer::Tracer():
+    m_buffersMutex{},
+    m_buffers{},
+    m_freeBuffers{},
+    m_lastThreadId{0},
+    m_tracePath{},
+    m_traceEnd{0},
+    m_epoch{chrono::steady_clock::now()}
+{
+
+}
+
+Tracer::ThreadBufferLease::~ThreadBufferLease()
+{
+    if (buffer)
+    {
+        Tracer::getInstance().releaseThreadBuffer(*buffer);
+    }
+}
+
+Tracer& Tracer::getInstance()
+{
+    static Tracer s_instance;
+    return s_instance;
+}
+
+void Tracer::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled);
+}
+
+Tracer::ThreadBuffer& Tracer::getThreadBuffer()
+{
+    thread_local ThreadBufferLease lease;
+    if (!lease.buffer)
+    {
+        lock_guard<mutex> lock(m_buffersMutex);
+        if (m_freeBuffers.empty())
+        {
+            m_buffers.push_back(make_unique<ThreadBuffer>());
+            lease.buffer = m_buffers.back().get();
+        }
+        else
+        {
+            lease.buffer = m_freeBuffers.back();
+            m_freeBuffers.pop_back();
+        }
+        lock_guard<mutex> bufferLock(lease.buffer->mutex);
+        lease.buffer->threadId = ++m_lastThreadId;
+        lease.buffer->retired = false;
+        lease.buffer->available = false;
+    }
+    return *lease.buffer;
+}
+
+void Tracer::releaseThreadBuffer(ThreadBuffer& buffer)
+{
+    lock_guard<mutex> lock(m_buffersMutex);
+    lock_guard<mutex> bufferLock(buffer.mutex);
+
+    //spans of ended thread still have to make it to the trace, buffer is reused after they are written
+    buffer.retired = true;
+    if (buffer.events.empty() && buffer.droppedEvents == 0)
+    {
+        recycleLocked(buffer);
+    }
+}
+
+void Tracer::recycleLocked(ThreadBuffer& buffer)
+{
+    //capacity of events is kept for the next thread
+    buffer.events.clear();
+    buffer.threadName.clear();
+    buffer.droppedEvents = 0;
+    buffer.available = true;
+    m_freeBuffers.push_back(&buffer);
+}
+
+void Tracer::setThreadName(const string& name)
+{
+    auto& buffer = getThreadBuffer();
+    lock_guard<mutex> lock(buffer.mutex);
+    buffer.threadName = name;
+}
+
+void Tracer::record(const char* name, chrono::steady_clock::time_point start, chrono::steady_clock::time_point end)
+{
+    auto& buffer = getThreadBuffer();
+    lock_guard<mutex> lock(buffer.mutex);
+
+    if (buffer.events.size() >= MaxEventsPerThread)
+    {
+        buffer.droppedEvents++;
+        return;
+    }
+
+    buffer.events.push_back(Event{name, chrono::duration_cast<chrono::nanoseconds>(start - m_epoch).count(),
+        chrono::duration_cast<chrono::nanoseconds>(end - start).count()});
+}
+
+bool Tracer::writeChromeTrace(const fs::path& path)
+{
+    lock_guard<mutex> buffersLock(m_buffersMutex);
+
+    //spans written before are kept in the file, new ones replace its closing brackets
+    fstream trace;
+    if (path == m_tracePath && m_traceEnd > 0)
+    {
+        trace.open(path, fstream::in | fstream::out | fstream::binary);
+        trace.seekp(static_cast<streamoff>(m_traceEnd));
+    }
+    if (!trace.is_open() || !trace)
+    {
+        trace.close();
+        trace.clear();
+        trace.open(path, fstream::out | fstream::trunc | fstream::binary);
+        if (!trace)
+        {
+            return false;
+        }
+        trace << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        trace << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"FolderBackup\"}}";
+    }
+
+    //trace event timestamps are microseconds, fractions keep nanosecond precision
+    auto microseconds = [](int64_t nanoseconds)
+    {
+        nanoseconds = max<int64_t>(nanoseconds, 0);
+        return to_string(nanoseconds / 1000) + "." + to_string(1000 + nanoseconds % 1000).substr(1);
+    };
+
+    for (const auto& buffer : m_buffers)
+    {
+        lock_guard<mutex> lock(buffer->mutex);
+
+        if (buffer->available || (buffer->events.empty() && buffer->droppedEvents == 0))
+        {
+            continue;
+        }
+
+        const auto threadName = buffer->threadName.empty() ? "thread " + to_string(buffer->threadId) : buffer->threadName;
+        trace << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+            << ",\"args\":{\"name\":\"" << threadName << "\"}}";
+
+        for (const auto& event : buffer->events)
+        {
+            trace << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"ts\":" << microseconds(event.startNanoseconds) << ",\"dur\":" << microseconds(event.durationNanoseconds) << "}";
+        }
+
+        if (buffer->droppedEvents > 0)
+        {
+            trace << ",\n{\"name\":\"dropped " << buffer->droppedEvents << " events\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":"
+                << buffer->threadId << ",\"ts\":0}";
+        }
+
+        buffer->events.clear();
+        buffer->droppedEvents = 0;
+        if (buffer->retired)
+        {
+            recycleLocked(*buffer);
+        }
+    }
+
+    const auto traceEnd = trace.tellp();
+    trace << "\n]}\n";
+    trace.flush();
+
+    if (!trace || traceEnd < 0)
+    {
+        m_tracePath.clear();
+        m_traceEnd = 0;
+        return false;
+    }
+
+    m_tracePath = path;
+    m_traceEnd = static_cast<uintmax_t>(traceEnd);
+
+    return true;
+}
\ No newline at end of file
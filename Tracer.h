@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+/**
+ * @brief Opt-in recorder of timed spans, exported as Chrome trace-event JSON (opens in Perfetto)
+ * Every thread records into its own buffer. When tracing is disabled a span costs one relaxed atomic load.
+ */
+class Tracer
+{
+public:
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+    Tracer& operator==(const Tracer&) = delete;
+
+    static Tracer& getInstance();
+
+    static bool isEnabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    void setEnabled(bool enabled);
+    /**
+     * @brief Name shown for the calling thread in trace viewer
+     */
+    void setThreadName(const std::string& name);
+    /**
+     * @brief Store a finished span of the calling thread
+     * @param name: must be a string literal, only the pointer is kept
+     */
+    void record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+    /**
+     * @brief Write all spans recorded since last write, recording continues afterwards
+     * Written spans are dropped from memory, repeated writes to the same path append to the trace.
+     * @return false: file could not be written
+     */
+    bool writeChromeTrace(const std::filesystem::path& path);
+private:
+    /**
+     * @brief Single finished span, times are nanoseconds since tracer creation
+     */
+    struct Event
+    {
+        const char* name;
+        std::int64_t startNanoseconds;
+        std::int64_t durationNanoseconds;
+    };
+    /**
+     * @brief Spans of a single thread, mutex is only contended while trace is written
+     * retired: thread has ended, buffer is reused once its spans are written
+     * available: buffer waits in free list for a new thread
+     */
+    struct ThreadBuffer
+    {
+        std::mutex mutex;
+        std::vector<Event> events;
+        std::string threadName;
+        std::size_t threadId = 0;
+        std::uint64_t droppedEvents = 0;
+        bool retired = false;
+        bool available = false;
+    };
+    /**
+     * @brief Hands buffer back to tracer when its thread ends
+     */
+    struct ThreadBufferLease
+    {
+        ThreadBuffer* buffer = nullptr;
+        ~ThreadBufferLease();
+    };
+
+    Tracer();
+
+    ThreadBuffer& getThreadBuffer();
+    void releaseThreadBuffer(ThreadBuffer& buffer);
+    /**
+     * @brief Put buffer to free list, both mutexes have to be held
+     */
+    void recycleLocked(ThreadBuffer& buffer);
+
+    static std::atomic<bool> s_enabled;
+
+    std::mutex m_buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    std::vector<ThreadBuffer*> m_freeBuffers;
+    std::size_t m_lastThreadId;
+    std::filesystem::path m_tracePath;
+    std::uintmax_t m_traceEnd;
+    const std::chrono::steady_clock::time_point m_epoch;
+    static const std::size_t MaxEventsPerThread;
+};
+
+/**
+ * @brief Records a span from construction till end of scope when tracing is enabled
+ */
+class TraceSpan
+{
+public:
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    explicit TraceSpan(const char* name):
+        m_name(name),
+        m_active(Tracer::isEnabled())
+    {
+        if (m_active)
+        {
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~TraceSpan()
+    {
+        if (m_active)
+        {
+            Tracer::getInstance().record(m_name, m_start, std::chrono::steady_clock::now());
+        }
+    }
+private:
+    const char* m_name;
+    bool m_active;
+    std::chrono::steady_clock::time_point m_start;
+};
\ No newline at end of file
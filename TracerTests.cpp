@@ -0,0 +1,126 @@
+#include "Tests.h"
+#include "Tracer.h"
+#include <fstream>
+#include <regex>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+    string readText(const fs::path& path)
+    {
+        ifstream input(path, ios::binary);
+        stringstream text;
+        text << input.rdbuf();
+        return text.str();
+    }
+    /**
+     * @brief Brackets outside of strings are balanced and the document is a single object
+     */
+    bool isBalancedJson(const string& text)
+    {
+        string open;
+        bool inString = false;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            const auto c = text[i];
+            if (inString)
+            {
+                if (c == '\\')
+                {
+                    i++;
+                }
+                else if (c == '"')
+                {
+                    inString = false;
+                }
+            }
+            else if (c == '"')
+            {
+                inString = true;
+            }
+            else if (c == '{' || c == '[')
+            {
+                if (open.empty() && i != text.find_first_not_of(" \n"))
+                {
+                    return false;
+                }
+                open += c;
+            }
+            else if (c == '}' || c == ']')
+            {
+                if (open.empty() || open.back() != (c == '}' ? '{' : '['))
+                {
+                    return false;
+                }
+                open.pop_back();
+            }
+        }
+        return open.empty() && !inString && text.front() == '{';
+    }
+    /**
+     * @brief Complete ("X") events with given name
+     */
+    size_t countSpans(const string& text, const string& name)
+    {
+        const regex span("\\{\"name\":\"" + name + "\",\"ph\":\"X\",\"pid\":1,\"tid\":[0-9]+,\"ts\":[0-9]+\\.[0-9]{3},\"dur\":[0-9]+\\.[0-9]{3}\\}");
+        return static_cast<size_t>(distance(sregex_iterator(text.begin(), text.end(), span), sregex_iterator()));
+    }
+}
+
+TEST(TracerWritesSpansOfAllThreads)
+{
+    auto& tracer = Tracer::getInstance();
+    const auto trace = TestRegistry::makeTempFolder("tracer") / "trace.json";
+
+    {
+        TraceSpan span("disabledSpan");
+    }
+
+    tracer.setEnabled(true);
+    {
+        TraceSpan span("mainSpan");
+        this_thread::sleep_for(chrono::milliseconds(2));
+    }
+    thread worker([&tracer]()
+    {
+        tracer.setThreadName("test worker");
+        for (int i = 0; i < 3; i++)
+        {
+            TraceSpan span("workerSpan");
+        }
+    });
+    worker.join();
+
+    CHECK(tracer.writeChromeTrace(trace));
+    const auto first = readText(trace);
+    CHECK(isBalancedJson(first));
+    CHECK(countSpans(first, "mainSpan") == 1);
+    CHECK(countSpans(first, "workerSpan") == 3);
+    CHECK(first.find("disabledSpan") == string::npos);
+    CHECK(first.find("\"args\":{\"name\":\"test worker\"}") != string::npos);
+
+    //span lasted at least 2 ms, duration is in microseconds
+    smatch duration;
+    CHECK(regex_search(first, duration, regex("\"name\":\"mainSpan\"[^}]*\"dur\":([0-9]+)\\.")) && stoi(duration[1]) >= 2000);
+
+    {
+        TraceSpan span("secondSpan");
+    }
+    tracer.setEnabled(false);
+    {
+        TraceSpan span("disabledSpan");
+    }
+
+    //second write appends to the same trace, written spans are not repeated
+    CHECK(tracer.writeChromeTrace(trace));
+    const auto second = readText(trace);
+    CHECK(isBalancedJson(second));
+    CHECK(countSpans(second, "mainSpan") == 1);
+    CHECK(countSpans(second, "workerSpan") == 3);
+    CHECK(countSpans(second, "secondSpan") == 1);
+    CHECK(second.find("disabledSpan") == string::npos);
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "WorkloadGenerator.h"
+#include <fstream>
+#include <algorithm>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+WorkloadGenerator::WorkloadGenerator(const fs::path& root, uint64_t seed):
+    m_root(root),
+    m_random(seed),
+    m_pattern(1024 * 1024),
+    m_createdFiles(0)
+{
+    for (auto& byte : m_pattern)
+    {
+        byte = static_cast<char>(m_random());
+    }
+}
+
+WorkloadGenerator::~WorkloadGenerator()
+{
+
+}
+
+const fs::path& WorkloadGenerator::getRoot() const
+{
+    return m_root;
+}
+
+void WorkloadGenerator::writeFile(const fs::path& path, uintmax_t size)
+{
+    ofstream file(path, ios::binary | ios::trunc);
+
+    //start at a random place of the pattern so files do not have identical contents
+    size_t position = static_cast<size_t>(m_random() % m_pattern.size());
+    while (size > 0)
+    {
+        const auto length = static_cast<size_t>(min<uintmax_t>(size, m_pattern.size() - position));
+        file.write(m_pattern.data() + position, static_cast<streamsize>(length));
+        size -= length;
+        position = 0;
+    }
+    m_createdFiles++;
+}
+
+vector<fs::path> WorkloadGenerator::listFiles(const fs::path& folder) const
+{
+    vector<fs::path> files;
+    for (const auto& entry : fs::recursive_directory_iterator(folder))
+    {
+        if (entry.is_regular_file())
+        {
+            files.push_back(entry.path());
+        }
+    }
+    //iteration order depends on file system, sorting keeps churn deterministic
+    sort(files.begin(), files.end());
+
+    return files;
+}
+
+WorkloadGenerator::Summary WorkloadGenerator::createTinyFiles(const string& folder, size_t count, size_t maxSize)
+{
+    Summary summary;
+    const auto target = m_root / folder;
+    fs::create_directories(target);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const auto size = static_cast<uintmax_t>(m_random() % (maxSize + 1));
+        writeFile(target / ("tiny_" + to_string(i) + ".txt"), size);
+        summary.files++;
+        summary.bytes += size;
+    }
+
+    return summary;
+}
+
+WorkloadGenerator::Summary WorkloadGenerator::createHugeFiles(const string& folder, size_t count, uintmax_t size)
+{
+    Summary summary;
+    const auto target = m_root / folder;
+    fs::create_directories(target);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        writeFile(target / ("huge_" + to_string(i) + ".img"), size);
+        summary.files++;
+        summary.bytes += size;
+    }
+
+    return summary;
+}
+
+WorkloadGenerator::Summary WorkloadGenerator::createDeepTree(const string& folder, size_t depth, size_t fanout,
+    size_t filesPerFolder, size_t fileSize)
+{
+    Summary summary;
+    vector<fs::path> level{m_root / folder};
+
+    for (size_t currentDepth = 0; currentDepth <= depth; currentDepth++)
+    {
+        vector<fs::path> nextLevel;
+        for (const auto& directory : level)
+        {
+            fs::create_directories(directory);
+            for (size_t i = 0; i < filesPerFolder; i++)
+            {
+                //names are unique across the tree because backup folder is flat
+                writeFile(directory / ("deep_" + to_string(m_createdFiles) + ".dat"), fileSize);
+                summary.files++;
+                summary.bytes += fileSize;
+            }
+            if (currentDepth < depth)
+            {
+                for (size_t i = 0; i < fanout; i++)
+                {
+                    nextLevel.push_back(directory / ("level" + to_string(currentDepth) + "_" + to_string(i)));
+                }
+            }
+        }
+        level = move(nextLevel);
+    }
+
+    return summary;
+}
+
+WorkloadGenerator::Summary WorkloadGenerator::applyChurn(const string& folder, double modifyRatio,
+    double deleteRatio, size_t newFiles)
+{
+    Summary summary;
+    const auto target = m_root / folder;
+    const auto files = listFiles(target);
+    uniform_real_distribution<double> chance(0.0, 1.0);
+
+    for (const auto& file : files)
+    {
+        const auto roll = chance(m_random);
+        if (roll < deleteRatio)
+        {
+            fs::remove(file);
+            summary.files++;
+        }
+        else if (roll < deleteRatio + modifyRatio)
+        {
+            const auto size = fs::file_size(file) + 1;
+            writeFile(file, size);
+            summary.files++;
+            summary.bytes += size;
+        }
+    }
+
+    fs::create_directories(target);
+    for (size_t i = 0; i < newFiles; i++)
+    {
+        writeFile(target / ("churn_" + to_string(m_createdFiles) + ".txt"), 512);
+        summary.files++;
+        summary.bytes += 512;
+    }
+
+    return summary;
+}
\ No newline at end of file
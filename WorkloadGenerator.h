@@ -0,0 +1,59 @@
+#pragma once
+
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdint>
+/**
+ * @brief Creates synthetic hot folder contents for benchmarks
+ * Same seed always produces the same tree, so results of different builds can be compared.
+ */
+class WorkloadGenerator
+{
+public:
+    /**
+     * @brief What was created or changed by a single call
+     */
+    struct Summary
+    {
+        std::size_t files = 0;
+        std::uintmax_t bytes = 0;
+    };
+
+    WorkloadGenerator(const std::filesystem::path& root, std::uint64_t seed);
+    ~WorkloadGenerator();
+    /**
+     * @brief Many small files in a single folder
+     * @param maxSize: files get random size from 0 to maxSize bytes
+     */
+    Summary createTinyFiles(const std::string& folder, std::size_t count, std::size_t maxSize);
+    /**
+     * @brief A few big files filled with incompressible data
+     */
+    Summary createHugeFiles(const std::string& folder, std::size_t count, std::uintmax_t size);
+    /**
+     * @brief Tree of nested folders with a few files in each of them
+     * @param depth: levels of folders below folder
+     * @param fanout: sub folders of every folder
+     */
+    Summary createDeepTree(const std::string& folder, std::size_t depth, std::size_t fanout,
+        std::size_t filesPerFolder, std::size_t fileSize);
+    /**
+     * @brief Modify, delete and add files below folder like users working in hot folder would
+     * @param modifyRatio: part of existing files which get rewritten
+     * @param deleteRatio: part of existing files which get deleted
+     * @param newFiles: amount of new files
+     */
+    Summary applyChurn(const std::string& folder, double modifyRatio, double deleteRatio, std::size_t newFiles);
+
+    const std::filesystem::path& getRoot() const;
+private:
+    void writeFile(const std::filesystem::path& path, std::uintmax_t size);
+    std::vector<std::filesystem::path> listFiles(const std::filesystem::path& folder) const;
+
+    std::filesystem::path m_root;
+    std::mt19937_64 m_random;
+    std::vector<char> m_pattern;
+    std::size_t m_createdFiles;
+};
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "Tests.h"
+#include "BackupFixture.h"
+#include "WorkloadGenerator.h"
+#include <fstream>
+#include <map>
+#include <sstream>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+    string readText(const fs::path& path)
+    {
+        ifstream input(path, ios::binary);
+        stringstream text;
+        text << input.rdbuf();
+        return text.str();
+    }
+    /**
+     * @brief Files below folder by path relative to it, with their contents
+     */
+    map<string, string> readTree(const fs::path& folder)
+    {
+        map<string, string> tree;
+        for (const auto& entry : fs::recursive_directory_iterator(folder))
+        {
+            if (entry.is_regular_file())
+            {
+                tree[fs::relative(entry.path(), folder).generic_string()] = readText(entry.path());
+            }
+        }
+        return tree;
+    }
+
+    WorkloadGenerator::Summary summarize(const map<string, string>& tree)
+    {
+        WorkloadGenerator::Summary summary;
+        for (const auto& file : tree)
+        {
+            summary.files++;
+            summary.bytes += file.second.size();
+        }
+        return summary;
+    }
+}
+
+TEST(WorkloadGeneratorIsDeterministic)
+{
+    const auto folder = TestRegistry::makeTempFolder("workload_seed");
+    WorkloadGenerator first(folder / "first", 42);
+    WorkloadGenerator second(folder / "second", 42);
+
+    const auto firstTiny = first.createTinyFiles("tiny", 50, 4096);
+    const auto secondTiny = second.createTinyFiles("tiny", 50, 4096);
+    const auto firstHuge = first.createHugeFiles("huge", 2, 3 * 1024 * 1024);
+    second.createHugeFiles("huge", 2, 3 * 1024 * 1024);
+
+    CHECK(firstTiny.files == 50 && secondTiny.files == 50);
+    CHECK(firstTiny.bytes == secondTiny.bytes);
+    CHECK(firstHuge.files == 2 && firstHuge.bytes == 6 * 1024 * 1024);
+
+    const auto tree = readTree(folder / "first");
+    CHECK(tree == readTree(folder / "second"));
+    const auto onDisk = summarize(tree);
+    CHECK(onDisk.files == 52);
+    CHECK(onDisk.bytes == firstTiny.bytes + firstHuge.bytes);
+    CHECK(tree.at("huge/huge_0.img") != tree.at("huge/huge_1.img"));
+}
+
+TEST(WorkloadGeneratorDeepTreeAndChurn)
+{
+    const auto folder = TestRegistry::makeTempFolder("workload_tree");
+    WorkloadGenerator generator(folder, 7);
+
+    //folders 1 + 3 + 9 with 2 files each
+    const auto created = generator.createDeepTree("deep", 2, 3, 2, 100);
+    CHECK(created.files == 26 && created.bytes == 2600);
+    const auto tree = readTree(folder / "deep");
+    CHECK(tree.size() == 26);
+    CHECK(tree.count("level0_2/level1_2/deep_25.dat") == 1);
+
+    const auto churn = generator.applyChurn("deep", 0.0, 1.0, 5);
+    CHECK(churn.files == 31 && churn.bytes == 5 * 512);
+    const auto churned = readTree(folder / "deep");
+    CHECK(churned.size() == 5);
+    CHECK(summarize(churned).bytes == 5 * 512);
+
+    const auto modified = generator.applyChurn("deep", 1.0, 0.0, 0);
+    CHECK(modified.files == 5 && modified.bytes == 5 * 513);
+    CHECK(summarize(readTree(folder / "deep")).bytes == 5 * 513);
+}
+
+TEST(WorkloadGeneratorTreeIsBackedUp)
+{
+    BackupFixture fixture("workload_backup", false);
+    WorkloadGenerator generator(fixture.getHot(), 3);
+    generator.createTinyFiles("tiny", 20, 2048);
+    generator.createDeepTree("deep", 1, 2, 3, 1000);
+    fixture.runPasses(1);
+
+    for (const auto& file : readTree(fixture.getHot()))
+    {
+        const auto name = fs::path(file.first).filename().string();
+        CHECK(fixture.hasBackup(name));
+    }
+}
\ No newline at end of file
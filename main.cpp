@@ -2,44 +2,26 @@
 #include <string>
 #include <chrono>
 #include "GlobalData.h"
-#include "FShelper.h"
+#include "FSHelper.h"
 #include "LogUtility.h"
+#include "BackupRunner.h"
+#include "BackupVerifier.h"
+#include "BackupRestorer.h"
+#include "Crc32c.h"
+#include "Metrics.h"
+#include "Tracer.h"
+#include "ControlServer.h"
+#include "TimestampFormatter.h"
 #include <thread>
 #include <atomic>
 #include <regex>
+#include <functional>
+#include <optional>
+#include <csignal>
 
 using namespace std;
 atomic<bool> isThreadStopRequested;
 
-/**
- * @brief loop for file backup thread
- * Crawls through input directory and checks each file
- */
-void runBackupForDirectory(const FSHelper& fsHelper)
-{
-    while (true)
-    {
-        GlobalData::getInstance().updatePaths();
-
-        for (const auto& fileToBackup : filesystem::recursive_directory_iterator(GlobalData::getInstance().getHotFolderDir()))
-        {
-            if (isThreadStopRequested.load())
-            {
-                return;
-            }
-
-            fsHelper.backupSingleFile(fileToBackup);
-        }
-
-        if (isThreadStopRequested.load())
-        {
-            return;
-        }
-
-        this_thread::sleep_for(chrono::seconds(1));
-    }
-}
-
 void regexHandler(LogUtility& log)
 {
     string regexInput;
@@ -88,6 +70,35 @@ void simpleSearchHandler(LogUtility& log)
     log.searchLog(simpleSearch);
 }
 
+void fileNameSearchHandler(LogUtility& log)
+{
+    string fileNameSearchTerm;
+    getline(cin, fileNameSearchTerm);
+    cout << "Results in log file with file name containing: " << fileNameSearchTerm << endl;
+
+    log.searchLogByFileName(fileNameSearchTerm, [](const string& singleLine)
+    {
+        cout << singleLine << endl;
+    });
+}
+
+void fileNameRegexHandler(LogUtility& log)
+{
+    string regexInput;
+    getline(cin, regexInput);
+    cout << "Results in log file with file name matching: " << regexInput << endl;
+
+    auto found = log.searchLogByFileNameRegex(regexInput, [](const string& singleLine)
+    {
+        cout << singleLine << endl;
+    });
+
+    if (!found)
+    {
+        cout << "Unsupported regex format" << endl;
+    }
+}
+
 void printHandler(LogUtility& log)
 {
     auto justPrint = [](const string& singleLine)
@@ -97,6 +108,25 @@ void printHandler(LogUtility& log)
     log.searchLog(justPrint);
 }
 
+void writeTrace()
+{
+    const auto& tracePath = GlobalData::getInstance().getTraceFilePath();
+    if (tracePath.empty())
+    {
+        cout << "Tracing is disabled, start application with --trace=<path>" << endl;
+        return;
+    }
+
+    if (Tracer::getInstance().writeChromeTrace(tracePath))
+    {
+        cout << "Trace written to: " << tracePath.string() << endl;
+    }
+    else
+    {
+        cerr << "Unable to write trace to: " << tracePath.string() << endl;
+    }
+}
+
 bool hanldeMainMenu(LogUtility& log)
 {
     cin.clear();
@@ -113,7 +143,7 @@ bool hanldeMainMenu(LogUtility& log)
     }
     else if (menuOption == "s")
     {
-        cout << "Provide simple search term. For example: 2023-02-12T12:20:55+00:00" << endl;
+        cout << "Provide simple search term. For example: 2023-02-12T12:20:55" << endl;
 
         simpleSearchHandler(log);
         return false;
@@ -125,6 +155,30 @@ bool hanldeMainMenu(LogUtility& log)
         regexHandler(log);
         return false;
     }
+    else if (menuOption == "f")
+    {
+        cout << "Provide part of file name. For example: report.txt" << endl;
+
+        fileNameSearchHandler(log);
+        return false;
+    }
+    else if (menuOption == "g")
+    {
+        cout << "Provide regex matching file name. For example: reports/2023-0[1-6].*\\.xlsx" << endl;
+
+        fileNameRegexHandler(log);
+        return false;
+    }
+    else if (menuOption == "m")
+    {
+        cout << Metrics::getInstance().toText() << endl;
+        return false;
+    }
+    else if (menuOption == "t")
+    {
+        writeTrace();
+        return false;
+    }
     else if (menuOption == "e")
     {
         return true;
@@ -143,23 +197,418 @@ void handleUI(LogUtility& log)
         cout << "Enter 'p' to print the log.\n";
         cout << "Enter 's' to execute simple search through the log.\n";
         cout << "Enter 'r' to execute regex search through the log.\n";
+        cout << "Enter 'f' to search the log by part of file name.\n";
+        cout << "Enter 'g' to search the log by file name regex.\n";
+        cout << "Enter 'm' to show runtime metrics.\n";
+        cout << "Enter 't' to write trace of recorded spans.\n";
         cout << "Enter 'e' to exit application.\n";
 
         exitRequested = hanldeMainMenu(log);
     }
 }
 
+void printUsage()
+{
+    cout<< "Please enter paths for hot and backup folders.\n";
+    cout<< "Example: FolderBackup.exe C:\\hot C:\\backup\n";
+    cout<< "Options:\n";
+    cout<< "  --large-file-threshold=<MB>  files of this size or bigger are copied in parallel ranges (default 256)\n";
+    cout<< "  --copy-threads=<N>           workers used to copy a single large file (default 4)\n";
+    cout<< "  --direct-io                  copy large files bypassing page cache\n";
+    cout<< "  --backup-threads=<N>         workers backing up changed files, one is kept for small files (default 2)\n";
+    cout<< "  --latency-lane-size=<KB>     smaller files are backed up ahead of bigger ones (default 1024)\n";
+    cout<< "  --pack-threshold=<KB>        files smaller than this are appended into pack files (default 0, disabled)\n";
+    cout<< "  --poll-max-interval=<s>      folders without changes are checked less often, up to this interval (default 1)\n";
+    cout<< "  --poll-budget=<N>            files checked per second, folders over it wait a pass (default 0, unlimited)\n";
+    cout<< "  --orphans=<mode>             backups of files gone from hot folder: off, remove or quarantine (default off)\n";
+    cout<< "  --orphan-batch=<N>           orphaned backups handled after a pass at most (default 100)\n";
+    cout<< "  --log-records=<N>            newest log records kept in memory for searches (default 100000)\n";
+    cout<< "  --no-checksums               do not compute CRC32C of backups\n";
+    cout<< "  --metrics-file=<path>        periodically write metrics in Prometheus text format\n";
+    cout<< "  --metrics-interval=<s>       seconds between metrics file updates (default 15)\n";
+    cout<< "  --trace=<path>               record per stage spans, written as Chrome trace JSON on exit\n";
+    cout<< "  --exclude=<glob>             do not back up matching files, matching folders are skipped entirely\n";
+    cout<< "  --include=<glob>             back up only matching files (folders are always searched)\n";
+    cout<< "  --exclude-regex=<regex>      like --exclude, regex is searched in path relative to hot folder\n";
+    cout<< "  --include-regex=<regex>      like --include, regex is searched in path relative to hot folder\n";
+    cout<< "  Globs support * ? [a-z] [!a] and **, globs without '/' match names, others paths relative to hot folder.\n";
+    cout<< "  Filter options can be repeated.\n";
+    cout<< "  --daemon                     run without menu, controlled over Unix domain socket (not on Windows)\n";
+    cout<< "  --socket=<path>              socket of daemon mode (default FolderBackup.sock)\n";
+    cout<< "To check backups against stored checksums:\n";
+    cout<< "  FolderBackup.exe verify C:\\backup [--threads=<N>]\n";
+    cout<< "To restore backups to their original names and folders:\n";
+    cout<< "  FolderBackup.exe restore C:\\backup C:\\restored [--filter=<regex>] [--before=<YYYY-MM-DDTHH:MM:SS[.mmm][Z|+HH:MM]>]\n";
+    cout<< "                 [--threads=<N>] [--no-verify]\n";
+    cout<< "  --filter matches original path relative to hot folder, --before takes time of last modification\n";
+    cout<< "  as written in the log, UTC when Z and offset are left out\n";
+    cout<< "To send a command to application running in daemon mode ('help' lists commands):\n";
+    cout<< "  FolderBackup client FolderBackup.sock status\n";
+}
+
+/**
+ * @brief Applies optional command line arguments to GlobalData
+ * @return false: unknown or malformed option
+ */
+bool parseOptions(int argc, char** argv, int firstOption)
+{
+    auto& gd = GlobalData::getInstance();
+
+    for (int i = firstOption; i < argc; i++)
+    {
+        const string option{argv[i]};
+        const auto separator = option.find('=');
+        const auto name = option.substr(0, separator);
+        const auto value = separator == string::npos ? string{} : option.substr(separator + 1);
+
+        try
+        {
+            if (name == "--large-file-threshold" && !value.empty())
+            {
+                gd.setLargeFileThreshold(stoull(value) * 1024 * 1024);
+            }
+            else if (name == "--copy-threads" && !value.empty())
+            {
+                gd.setCopyThreads(static_cast<unsigned int>(stoul(value)));
+            }
+            else if (name == "--backup-threads" && !value.empty())
+            {
+                gd.setBackupThreads(static_cast<unsigned int>(stoul(value)));
+            }
+            else if (name == "--latency-lane-size" && !value.empty())
+            {
+                gd.setLatencyLaneThreshold(stoull(value) * 1024);
+            }
+            else if (name == "--pack-threshold" && !value.empty())
+            {
+                gd.setPackThreshold(stoull(value) * 1024);
+            }
+            else if (name == "--poll-max-interval" && !value.empty())
+            {
+                gd.setPollMaxInterval(chrono::seconds(stoul(value)));
+            }
+            else if (name == "--poll-budget" && !value.empty())
+            {
+                gd.setPollBudget(stoull(value));
+            }
+            else if (name == "--orphans" && (value == "off" || value == "remove" || value == "quarantine"))
+            {
+                gd.setOrphanMode(value == "remove" ? GlobalData::OrphanMode::Remove :
+                    value == "quarantine" ? GlobalData::OrphanMode::Quarantine : GlobalData::OrphanMode::Off);
+            }
+            else if (name == "--orphan-batch" && !value.empty())
+            {
+                gd.setOrphanBatch(stoul(value));
+            }
+            else if (name == "--log-records" && !value.empty())
+            {
+                gd.setLogRecordCapacity(stoul(value));
+            }
+            else if (name == "--direct-io")
+            {
+                gd.setDirectIoEnabled(true);
+            }
+            else if (name == "--no-checksums")
+            {
+                gd.setChecksumEnabled(false);
+            }
+            else if (name == "--metrics-file" && !value.empty())
+            {
+                gd.setMetricsFilePath(filesystem::absolute(filesystem::u8path(value)));
+            }
+            else if (name == "--metrics-interval" && !value.empty())
+            {
+                gd.setMetricsInterval(chrono::seconds(stoul(value)));
+            }
+            else if (name == "--trace" && !value.empty())
+            {
+                gd.setTraceFilePath(filesystem::absolute(filesystem::u8path(value)));
+            }
+            else if (name == "--daemon")
+            {
+                gd.setDaemonMode(true);
+            }
+            else if (name == "--socket" && !value.empty())
+            {
+                gd.setSocketPath(filesystem::absolute(filesystem::u8path(value)));
+            }
+            else if (name == "--include" || name == "--exclude")
+            {
+                if (!PathFilter::isValidGlob(value))
+                {
+                    throw invalid_argument(value);
+                }
+                gd.addFilterRule({name == "--include" ? PathFilter::RuleType::IncludeGlob : PathFilter::RuleType::ExcludeGlob, value});
+            }
+            else if ((name == "--include-regex" || name == "--exclude-regex") && !value.empty())
+            {
+                //compiled here only to reject broken patterns early
+                regex validation(value);
+                gd.addFilterRule({name == "--include-regex" ? PathFilter::RuleType::IncludeRegex : PathFilter::RuleType::ExcludeRegex, value});
+            }
+            else
+            {
+                cerr << "Unknown option: " << option << "\n";
+                return false;
+            }
+        }
+        catch (const exception&)
+        {
+            cerr << "Invalid value for option: " << option << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Re-hash whole backup set and report files which do not match stored checksums
+ */
+int runVerify(int argc, char** argv)
+{
+    auto& gd = GlobalData::getInstance(nullopt, argv[2]);
+    unsigned int threadCount = max(1u, thread::hardware_concurrency());
+
+    for (int i = 3; i < argc; i++)
+    {
+        const string option{argv[i]};
+        const string threadsOption{"--threads="};
+        try
+        {
+            if (option.compare(0, threadsOption.size(), threadsOption) != 0)
+            {
+                throw invalid_argument(option);
+            }
+            threadCount = static_cast<unsigned int>(stoul(option.substr(threadsOption.size())));
+        }
+        catch (const exception&)
+        {
+            cerr << "Unknown option: " << option << "\n";
+            printUsage();
+            return -1;
+        }
+    }
+
+    if (!gd.getBackupFolderDir().is_directory())
+    {
+        cerr << "Backup folder does not exist, or is not a directory: " << gd.getBackupFolderPath() << endl;
+        return -1;
+    }
+
+    ChecksumStore checksumStore;
+    checksumStore.loadReadOnly(gd.getBackupFolderPath() / gd.getChecksumFileName());
+    PackStore packStore;
+    packStore.load(gd.getBackupFolderPath());
+
+    BackupVerifier verifier(checksumStore, packStore);
+    const auto result = verifier.verify(gd.getBackupFolderPath(), threadCount);
+
+    const double megabytes = static_cast<double>(result.checkedBytes) / (1024 * 1024);
+    cout << "Verified " << result.checkedFiles << " files, " << megabytes << " MB in " << result.seconds << " s ("
+        << (result.seconds > 0 ? megabytes / result.seconds : 0) << " MB/s, CRC32C "
+        << (Crc32c::isHardwareAccelerated() ? "hardware" : "software") << ")\n";
+    cout << "Mismatches: " << result.mismatches << " missing: " << result.missing
+        << " without checksum: " << result.withoutChecksum << endl;
+
+    return (result.mismatches == 0 && result.missing == 0) ? 0 : 1;
+}
+
+/**
+ * @brief Parse time in the format used by the log, for example 2023-02-12T14:20:55.123+02:00
+ * Milliseconds are optional, time without Z or offset from UTC is taken as UTC.
+ */
+optional<filesystem::file_time_type> parseTimestamp(const string& text)
+{
+    const auto systemTime = TimestampFormatter::parse(text);
+    if (!systemTime)
+    {
+        return nullopt;
+    }
+
+    //file clock epoch is implementation defined, so move between clocks relative to now
+    const auto fileNow = filesystem::file_time_type::clock::now();
+    const auto systemNow = chrono::system_clock::now();
+    return fileNow + chrono::duration_cast<filesystem::file_time_type::duration>(systemTime.value() - systemNow);
+}
+
+/**
+ * @brief Copy backups back to original names and folders below target folder
+ */
+int runRestore(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        printUsage();
+        return 0;
+    }
+
+    auto& gd = GlobalData::getInstance(nullopt, argv[2]);
+
+    BackupRestorer::Options options;
+    options.targetFolder = filesystem::absolute(filesystem::u8path(argv[3]));
+    options.threadCount = max(1u, thread::hardware_concurrency());
+
+    for (int i = 4; i < argc; i++)
+    {
+        const string option{argv[i]};
+        const auto separator = option.find('=');
+        const auto name = option.substr(0, separator);
+        const auto value = separator == string::npos ? string{} : option.substr(separator + 1);
+
+        try
+        {
+            if (name == "--filter" && !value.empty())
+            {
+                options.pathFilter = regex(value);
+            }
+            else if (name == "--before" && !value.empty())
+            {
+                options.notNewerThan = parseTimestamp(value);
+                if (!options.notNewerThan)
+                {
+                    throw invalid_argument(value);
+                }
+            }
+            else if (name == "--threads" && !value.empty())
+            {
+                options.threadCount = static_cast<unsigned int>(stoul(value));
+            }
+            else if (name == "--no-verify")
+            {
+                options.verifyChecksums = false;
+            }
+            else
+            {
+                cerr << "Unknown option: " << option << "\n";
+                printUsage();
+                return -1;
+            }
+        }
+        catch (const exception&)
+        {
+            cerr << "Invalid value for option: " << option << "\n";
+            return -1;
+        }
+    }
+
+    if (!gd.getBackupFolderDir().is_directory())
+    {
+        cerr << "Backup folder does not exist, or is not a directory: " << gd.getBackupFolderPath() << endl;
+        return -1;
+    }
+
+    ChecksumStore checksumStore;
+    checksumStore.loadReadOnly(gd.getBackupFolderPath() / gd.getChecksumFileName());
+    PackStore packStore;
+    packStore.load(gd.getBackupFolderPath());
+
+    BackupRestorer restorer(checksumStore, packStore);
+    const auto result = restorer.restore(gd.getBackupFolderPath(), options);
+
+    const double megabytes = static_cast<double>(result.restoredBytes) / (1024 * 1024);
+    cout << "Restored " << result.restoredFiles << " files, " << megabytes << " MB in " << result.seconds << " s ("
+        << (result.seconds > 0 ? megabytes / result.seconds : 0) << " MB/s) to " << options.targetFolder.string() << "\n";
+    cout << "Skipped by filter: " << result.skippedFiles << " failed: " << result.failedFiles
+        << " checksum mismatches: " << result.checksumMismatches << endl;
+
+    return (result.failedFiles == 0 && result.checksumMismatches == 0) ? 0 : 1;
+}
+
+/**
+ * @brief Send command given on command line to daemon
+ */
+int runClient(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        printUsage();
+        return 0;
+    }
+
+    string command{argv[3]};
+    for (int i = 4; i < argc; i++)
+    {
+        command += " " + string(argv[i]);
+    }
+
+    const auto result = ControlServer::runClient(filesystem::u8path(argv[2]), command);
+    if (result == -1)
+    {
+        cerr << "Unable to connect to daemon at: " << argv[2] << endl;
+    }
+
+    return result;
+}
+
+void handleStopSignal(int)
+{
+    isThreadStopRequested.store(true);
+}
+
+/**
+ * @brief Serve control socket until stop command or termination signal
+ */
+int runDaemon(LogUtility& log, const BackupRunner& backupRunner)
+{
+    const auto& socketPath = GlobalData::getInstance().getSocketPath();
+    ControlServer server(log, backupRunner, isThreadStopRequested);
+
+    if (!server.start(socketPath))
+    {
+        return -1;
+    }
+
+    signal(SIGINT, handleStopSignal);
+    signal(SIGTERM, handleStopSignal);
+#ifdef SIGPIPE
+    //client closing connection early must not kill daemon
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+    cout << "Running in daemon mode, control socket: " << socketPath.string() << endl;
+    server.serve();
+
+    return 0;
+}
+
 int main(int argc, char** argv)
 {
-    if (argc != 3)
+    if (argc < 3)
     {
-        cout<< "Please enter paths for hot and backup folders.\n";
-        cout<< "Example: FolderBackup.exe C:\\hot C:\\backup\n";
+        printUsage();
         return 0;
     }
 
+    if (string(argv[1]) == "verify")
+    {
+        return runVerify(argc, argv);
+    }
+
+    if (string(argv[1]) == "restore")
+    {
+        return runRestore(argc, argv);
+    }
+
+    if (string(argv[1]) == "client")
+    {
+        return runClient(argc, argv);
+    }
+
     auto& globaldata = GlobalData::getInstance(argv[1], argv[2]);
 
+    if (!parseOptions(argc, argv, 3))
+    {
+        printUsage();
+        return -1;
+    }
+
+    if (!globaldata.getTraceFilePath().empty())
+    {
+        Tracer::getInstance().setEnabled(true);
+        Tracer::getInstance().setThreadName("main");
+    }
+
     LogUtility log;
 
     FSHelper fsHelper(log.getLogWriter());
@@ -171,15 +620,45 @@ int main(int argc, char** argv)
 
     thread writeToFileThread(&LogUtility::writeToFileThread, &log );
 
-    thread backupFilesThread(&runBackupForDirectory, fsHelper);
+    BackupRunner backupRunner(fsHelper, isThreadStopRequested);
 
-    handleUI(log);
+    thread backupFilesThread(&BackupRunner::run, &backupRunner);
+
+    thread metricsExportThread;
+    if (!globaldata.getMetricsFilePath().empty())
+    {
+        metricsExportThread = thread(&Metrics::exportToFileThread, &Metrics::getInstance(),
+            globaldata.getMetricsFilePath(), globaldata.getMetricsInterval(), cref(isThreadStopRequested));
+    }
+
+    int exitCode = 0;
+    if (globaldata.isDaemonMode())
+    {
+        exitCode = runDaemon(log, backupRunner);
+    }
+    else
+    {
+        handleUI(log);
+    }
 
     isThreadStopRequested.store(true);
     backupFilesThread.join();
+    if (metricsExportThread.joinable())
+    {
+        metricsExportThread.join();
+    }
+
+    const auto copyTotals = fsHelper.getCopyTotals();
+    cout << "Backed up " << copyTotals.logicalBytes << " bytes, " << copyTotals.physicalBytes
+        << " bytes were written (holes of sparse files are not copied)." << endl;
 
     log.stopThreads();
     writeToFileThread.join();
 
-    return 0;
+    if (!globaldata.getTraceFilePath().empty())
+    {
+        writeTrace();
+    }
+
+    return exitCode;
 }
\ No newline at end of file